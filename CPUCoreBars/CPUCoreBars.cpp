@@ -1,52 +1,54 @@
 ﻿// CPUCoreBars/CPUCoreBars.cpp - 性能优化版本
 #include "CPUCoreBars.h"
 #include <string>
-#include <PdhMsg.h>
-#include <winevt.h>
+#include <algorithm>
 
-#pragma comment(lib, "pdh.lib")
-#pragma comment(lib, "wevtapi.lib")
 #pragma comment(lib, "gdiplus.lib")
 
 using namespace Gdiplus;
 
+namespace
+{
+    // COLORREF (0x00BBGGRR) -> 32 位 DIB 像素 (0x00RRGGBB)
+    inline uint32_t ToPixel(COLORREF color)
+    {
+        return (GetRValue(color) << 16) | (GetGValue(color) << 8) | GetBValue(color);
+    }
+
+    // 把离屏缓冲区一次性输出到 DC
+    void BlitCanvas(HDC dc, int x, int y, const CPixelCanvas& canvas)
+    {
+        int w = canvas.GetWidth();
+        int h = canvas.GetHeight();
+        if (w <= 0 || h <= 0) return;
+
+        BITMAPINFO bmi = {};
+        bmi.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
+        bmi.bmiHeader.biWidth = w;
+        bmi.bmiHeader.biHeight = -h;    // 自上而下
+        bmi.bmiHeader.biPlanes = 1;
+        bmi.bmiHeader.biBitCount = 32;
+        bmi.bmiHeader.biCompression = BI_RGB;
+        SetDIBitsToDevice(dc, x, y, w, h, 0, 0, 0, h, canvas.GetPixels(), &bmi, DIB_RGB_COLORS);
+    }
+}
+
+unsigned long long CDrawCacheStats::hits = 0;
+unsigned long long CDrawCacheStats::misses = 0;
+
 // =================================================================
 // CCpuUsageItem implementation - 优化版本
 // =================================================================
 
-// 静态成员变量定义
-HFONT CCpuUsageItem::s_symbolFont = nullptr;
-int CCpuUsageItem::s_fontRefCount = 0;
-
 CCpuUsageItem::CCpuUsageItem(int core_index, bool is_e_core) 
-    : m_core_index(core_index), m_is_e_core(is_e_core),
-      m_cachedBgBrush(nullptr), m_cachedBarBrush(nullptr),
-      m_lastBgColor(0), m_lastBarColor(0), m_lastDarkMode(false)
+    : m_core_index(core_index), m_is_e_core(is_e_core)
 {
-    // 初始化静态字体（只创建一次）
-    if (s_symbolFont == nullptr) {
-        s_symbolFont = CreateFontW(12, 0, 0, 0, FW_NORMAL, FALSE, FALSE, FALSE, 
-            DEFAULT_CHARSET, OUT_DEFAULT_PRECIS, CLIP_DEFAULT_PRECIS, 
-            DEFAULT_QUALITY, DEFAULT_PITCH | FF_DONTCARE, L"Segoe UI Symbol");
-    }
-    s_fontRefCount++;
-    
     swprintf_s(m_item_name, L"CPU Core %d", m_core_index);
     swprintf_s(m_item_id, L"cpu_core_%d", m_core_index);
 }
 
 CCpuUsageItem::~CCpuUsageItem()
 {
-    // 清理缓存的画刷
-    if (m_cachedBgBrush) DeleteObject(m_cachedBgBrush);
-    if (m_cachedBarBrush) DeleteObject(m_cachedBarBrush);
-    
-    // 减少字体引用计数
-    s_fontRefCount--;
-    if (s_fontRefCount == 0 && s_symbolFont) {
-        DeleteObject(s_symbolFont);
-        s_symbolFont = nullptr;
-    }
 }
 
 const wchar_t* CCpuUsageItem::GetItemName() const
@@ -81,7 +83,7 @@ bool CCpuUsageItem::IsCustomDraw() const
 
 int CCpuUsageItem::GetItemWidth() const
 {
-    return 8;
+    return m_sparkline_mode ? SPARKLINE_WIDTH : 8;
 }
 
 void CCpuUsageItem::SetUsage(double usage)
@@ -89,6 +91,11 @@ void CCpuUsageItem::SetUsage(double usage)
     m_usage = max(0.0, min(1.0, usage));
 }
 
+void CCpuUsageItem::SetPeak(double peak)
+{
+    m_peak = max(0.0, min(1.0, peak));
+}
+
 inline COLORREF CCpuUsageItem::CalculateBarColor() const
 {
     // 高使用率优先显示（性能优化：重新排列条件优先级）
@@ -105,64 +112,126 @@ inline COLORREF CCpuUsageItem::CalculateBarColor() const
     }
 }
 
-void CCpuUsageItem::DrawECoreSymbol(HDC hDC, const RECT& rect, bool dark_mode)
-{
-    COLORREF icon_color = dark_mode ? RGB(255, 255, 255) : RGB(0, 0, 0);
-    SetTextColor(hDC, icon_color);
-    SetBkMode(hDC, TRANSPARENT);
-    const wchar_t* symbol = L"\u2618";
-    
-    // 使用缓存的静态字体
-    if (s_symbolFont) {
-        HGDIOBJ hOldFont = SelectObject(hDC, s_symbolFont);
-        DrawTextW(hDC, symbol, -1, (LPRECT)&rect, DT_CENTER | DT_VCENTER | DT_SINGLELINE);
-        SelectObject(hDC, hOldFont);
-    }
-}
-
 void CCpuUsageItem::DrawItem(void* hDC, int x, int y, int w, int h, bool dark_mode)
 {
     HDC dc = (HDC)hDC;
-    RECT rect = { x, y, x + w, y + h };
-    
-    // 使用缓存的背景画刷
     COLORREF bg_color = dark_mode ? RGB(32, 32, 32) : RGB(255, 255, 255);
-    if (!m_cachedBgBrush || m_lastBgColor != bg_color || m_lastDarkMode != dark_mode) {
-        if (m_cachedBgBrush) DeleteObject(m_cachedBgBrush);
-        m_cachedBgBrush = CreateSolidBrush(bg_color);
-        m_lastBgColor = bg_color;
-        m_lastDarkMode = dark_mode;
-    }
-    FillRect(dc, &rect, m_cachedBgBrush);
 
     // 计算条形图颜色
     COLORREF bar_color = CalculateBarColor();
-    
-    // 使用缓存的条形画刷
-    if (!m_cachedBarBrush || m_lastBarColor != bar_color) {
-        if (m_cachedBarBrush) DeleteObject(m_cachedBarBrush);
-        m_cachedBarBrush = CreateSolidBrush(bar_color);
-        m_lastBarColor = bar_color;
+    // E-Core 标记使用内置的点阵图案，不再调用 DrawTextW
+    uint32_t icon_pixel = dark_mode ? ToPixel(RGB(255, 255, 255)) : ToPixel(RGB(0, 0, 0));
+
+    if (m_sparkline_mode && m_history) {
+        // 历史曲线每帧都在变化，不走条形图的缓存
+        m_has_last_state = false;
+        m_canvas.Resize(w, h);
+        m_canvas.Clear(ToPixel(bg_color));
+        RenderSparkline(*m_history, m_core_index, m_canvas, ToPixel(bar_color));
+        if (m_is_e_core) DrawECoreGlyph(m_canvas, icon_pixel);
+        BlitCanvas(dc, x, y, m_canvas);
+        return;
     }
 
     int bar_height = static_cast<int>(h * m_usage);
-    if (bar_height > 0) {
-        RECT bar_rect = { x, y + (h - bar_height), x + w, y + h };
-        FillRect(dc, &bar_rect, m_cachedBarBrush);
+    int peak_height = static_cast<int>(h * m_peak);
+    // 峰值保持刻度：只在峰值明显高于平均值时绘制（1像素横线）
+    if (peak_height <= bar_height + 1) peak_height = 0;
+
+    // 量化后的状态与上一帧相同：直接输出缓存的像素
+    BarRenderState state = { w, h, bar_height, peak_height, bar_color, dark_mode };
+    if (m_has_last_state && state.w == m_last_state.w && state.h == m_last_state.h
+        && state.bar_height == m_last_state.bar_height && state.peak_height == m_last_state.peak_height
+        && state.bar_color == m_last_state.bar_color && state.dark_mode == m_last_state.dark_mode) {
+        ++CDrawCacheStats::hits;
+        BlitCanvas(dc, x, y, m_canvas);
+        return;
     }
+    ++CDrawCacheStats::misses;
+    m_last_state = state;
+    m_has_last_state = true;
 
-    if (m_is_e_core) {
-        DrawECoreSymbol(dc, rect, dark_mode);
-    }
+    // 条形图先画到离屏像素缓冲区，最后一次性输出到 DC
+    m_canvas.Resize(w, h);
+    RenderCoreBar(m_canvas, bar_height, peak_height, ToPixel(bg_color), ToPixel(bar_color));
+    if (m_is_e_core) DrawECoreGlyph(m_canvas, icon_pixel);
+
+    BlitCanvas(dc, x, y, m_canvas);
+}
+
+// =================================================================
+// CCpuHeatmapItem implementation
+// =================================================================
+CCpuHeatmapItem::CCpuHeatmapItem(const double* usage, const BYTE* e_core_flags, int num_cores)
+    : m_usage(usage), m_e_core_flags(e_core_flags), m_num_cores(num_cores)
+{
+}
+
+// 空闲档接近背景色，随后经绿色、橙色过渡到红色（0x00RRGGBB）
+const uint32_t CCpuHeatmapItem::s_light_levels[HEATMAP_COLOR_LEVELS] = {
+    0xE6E6E6, 0xBEE6AA, 0x76CA53, 0xB4C846, 0xF6B64E, 0xF08C3C, 0xE66437, 0xD94235
+};
+const uint32_t CCpuHeatmapItem::s_dark_levels[HEATMAP_COLOR_LEVELS] = {
+    0x373737, 0x3C6432, 0x76CA53, 0xB4C846, 0xF6B64E, 0xF08C3C, 0xE66437, 0xD94235
+};
+
+const wchar_t* CCpuHeatmapItem::GetItemName() const
+{
+    return L"CPU 核心热力图";
+}
+
+const wchar_t* CCpuHeatmapItem::GetItemId() const
+{
+    return L"cpu_heatmap";
+}
+
+const wchar_t* CCpuHeatmapItem::GetItemLableText() const
+{
+    return L"";
+}
+
+const wchar_t* CCpuHeatmapItem::GetItemValueText() const
+{
+    return L"";
+}
+
+const wchar_t* CCpuHeatmapItem::GetItemValueSampleText() const
+{
+    return L"";
+}
+
+bool CCpuHeatmapItem::IsCustomDraw() const
+{
+    return true;
+}
+
+int CCpuHeatmapItem::GetItemWidth() const
+{
+    int rows = NOMINAL_HEIGHT / NOMINAL_CELL;
+    int cols = (m_num_cores + rows - 1) / rows;
+    return max(8, cols * NOMINAL_CELL);
+}
+
+void CCpuHeatmapItem::DrawItem(void* hDC, int x, int y, int w, int h, bool dark_mode)
+{
+    HDC dc = (HDC)hDC;
+    m_canvas.Resize(w, h);
+    RenderHeatmap(m_canvas, m_usage, m_e_core_flags, m_num_cores,
+        dark_mode ? s_dark_levels : s_light_levels,
+        dark_mode ? ToPixel(RGB(32, 32, 32)) : ToPixel(RGB(255, 255, 255)),
+        dark_mode ? ToPixel(RGB(255, 255, 255)) : ToPixel(RGB(0, 0, 0)));
+    BlitCanvas(dc, x, y, m_canvas);
 }
 
 
 // =================================================================
 // CNvidiaMonitorItem implementation - 优化版本
 // =================================================================
-CNvidiaMonitorItem::CNvidiaMonitorItem()
+CNvidiaMonitorItem::CNvidiaMonitorItem(const wchar_t* name, const wchar_t* id)
     : m_cachedGraphics(nullptr), m_lastHdc(nullptr)
 {
+    wcscpy_s(m_item_name, name);
+    wcscpy_s(m_item_id, id);
     wcscpy_s(m_value_text, L"N/A");
 
     HDC hdc = GetDC(NULL);
@@ -188,12 +257,12 @@ CNvidiaMonitorItem::~CNvidiaMonitorItem()
 
 const wchar_t* CNvidiaMonitorItem::GetItemName() const
 {
-    return L"GPU/WHEA";
+    return m_item_name;
 }
 
 const wchar_t* CNvidiaMonitorItem::GetItemId() const
 {
-    return L"gpu_system_status";
+    return m_item_id;
 }
 
 const wchar_t* CNvidiaMonitorItem::GetItemLableText() const
@@ -203,7 +272,11 @@ const wchar_t* CNvidiaMonitorItem::GetItemLableText() const
 
 const wchar_t* CNvidiaMonitorItem::GetItemValueText() const
 {
-    return m_value_text;
+    switch (m_health) {
+    case GPU_HEALTH_UNRESPONSIVE: return L"无响应";
+    case GPU_HEALTH_LOST: return L"设备丢失";
+    default: return m_value_text;
+    }
 }
 
 const wchar_t* CNvidiaMonitorItem::GetItemValueSampleText() const
@@ -221,14 +294,6 @@ int CNvidiaMonitorItem::GetItemWidth() const
     return m_width;
 }
 
-inline COLORREF CNvidiaMonitorItem::CalculateTextColor(bool dark_mode) const 
-{
-    const wchar_t* current_value = GetItemValueText();
-    if (wcscmp(current_value, L"过热") == 0) return RGB(217, 66, 53);
-    if (wcscmp(current_value, L"功耗") == 0) return RGB(246, 182, 78);
-    return dark_mode ? RGB(255, 255, 255) : RGB(0, 0, 0);
-}
-
 void CNvidiaMonitorItem::DrawItem(void* hDC, int x, int y, int w, int h, bool dark_mode)
 {
     HDC dc = (HDC)hDC;
@@ -245,29 +310,245 @@ void CNvidiaMonitorItem::DrawItem(void* hDC, int x, int y, int w, int h, bool da
         m_lastHdc = dc;
     }
     
-    // 使用缓存的Graphics对象绘制圆形
-    Color circle_color = m_has_system_error ? Color(217, 66, 53) : Color(118, 202, 83);
+    // 使用缓存的Graphics对象绘制圆形，颜色按最严重的错误等级
+    // 驱动无响应或掉卡时正是错误最要紧的时候，错误颜色照常显示，健康状态由灰色描边和文本表示
+    Color circle_color(118, 202, 83);
+    if (m_health != GPU_HEALTH_OK && m_error_level == SYSTEM_ERROR_NONE) circle_color = Color(128, 128, 128);
+    switch (m_error_level) {
+    case SYSTEM_ERROR_CORRECTED: circle_color = Color(246, 182, 78); break;
+    case SYSTEM_ERROR_ERROR:
+    case SYSTEM_ERROR_UNCORRECTED: circle_color = Color(217, 66, 53); break;
+    case SYSTEM_ERROR_FATAL: circle_color = Color(148, 33, 146); break;
+    default: break;
+    }
     SolidBrush circle_brush(circle_color);
     m_cachedGraphics->FillEllipse(&circle_brush, 
         x + LEFT_MARGIN, y + icon_y_offset, icon_size, icon_size);
+    if (m_health != GPU_HEALTH_OK) {
+        Pen outline_pen(Color(128, 128, 128), 2.0f);
+        m_cachedGraphics->DrawEllipse(&outline_pen,
+            x + LEFT_MARGIN + 1, y + icon_y_offset + 1, icon_size - 2, icon_size - 2);
+    }
 
     // --- 绘制文本 ---
     RECT text_rect = { x + LEFT_MARGIN + icon_size + 4, y, x + w, y + h };
-    COLORREF value_text_color = CalculateTextColor(dark_mode);
+    COLORREF value_text_color = GetClockReasonColor(m_reason, dark_mode);
+    if (m_color_by_violation && m_violation_fraction >= 0.0f) {
+        // 短暂的功耗制动也会计入占比，不会因为正好错过采样点而漏掉
+        if (m_violation_fraction >= 0.5f) value_text_color = RGB(217, 66, 53);
+        else if (m_violation_fraction >= 0.1f) value_text_color = RGB(246, 182, 78);
+        else value_text_color = dark_mode ? RGB(255, 255, 255) : RGB(0, 0, 0);
+    }
+    // 驱动无响应或掉卡时其余数据都是旧值，用灰色和普通的降频状态区分开
+    if (m_health != GPU_HEALTH_OK) value_text_color = RGB(128, 128, 128);
     
     SetTextColor(dc, value_text_color);
     SetBkMode(dc, TRANSPARENT);
     DrawTextW(dc, GetItemValueText(), -1, &text_rect, DT_LEFT | DT_VCENTER | DT_SINGLELINE);
 }
 
-void CNvidiaMonitorItem::SetValue(const wchar_t* value)
+void CNvidiaMonitorItem::SetReason(int reason)
+{
+    m_reason = reason;
+    wcscpy_s(m_value_text, GetClockReasonText(reason));
+}
+
+void CNvidiaMonitorItem::SetSystemErrorLevel(SystemErrorLevel level)
+{
+    m_error_level = level;
+}
+
+void CNvidiaMonitorItem::SetHealth(GpuHealth health)
+{
+    m_health = health;
+}
+
+void CNvidiaMonitorItem::SetViolationFraction(float fraction)
+{
+    m_violation_fraction = fraction;
+}
+
+void CNvidiaMonitorItem::SetColorByViolation(bool enable)
 {
-    wcscpy_s(m_value_text, value);
+    m_color_by_violation = enable;
 }
 
-void CNvidiaMonitorItem::SetSystemErrorStatus(bool has_error)
+// =================================================================
+// CGpuUtilItem implementation
+// =================================================================
+CGpuUtilItem::CGpuUtilItem(const wchar_t* name, const wchar_t* id)
+{
+    wcscpy_s(m_item_name, name);
+    wcscpy_s(m_item_id, id);
+    wcscpy_s(m_value_text, L"N/A");
+}
+
+const wchar_t* CGpuUtilItem::GetItemName() const
+{
+    return m_item_name;
+}
+
+const wchar_t* CGpuUtilItem::GetItemId() const
+{
+    return m_item_id;
+}
+
+const wchar_t* CGpuUtilItem::GetItemLableText() const
+{
+    return L"GPU";
+}
+
+const wchar_t* CGpuUtilItem::GetItemValueText() const
+{
+    return m_value_text;
+}
+
+const wchar_t* CGpuUtilItem::GetItemValueSampleText() const
 {
-    m_has_system_error = has_error;
+    return L"100% (100-100)";
+}
+
+int CGpuUtilItem::IsDrawResourceUsageGraph() const
+{
+    return 1;
+}
+
+float CGpuUtilItem::GetResourceUsageGraphValue() const
+{
+    return m_graph_value;
+}
+
+void CGpuUtilItem::SetUtilization(const CGpuUtilization& utilization)
+{
+    if (utilization.count == 0) {
+        wcscpy_s(m_value_text, L"N/A");
+        m_graph_value = 0.0f;
+        return;
+    }
+    swprintf_s(m_value_text, L"%u%% (%u-%u)", utilization.mean, utilization.min, utilization.max);
+    m_graph_value = utilization.mean / 100.0f;
+}
+
+// =================================================================
+// CGpuPowerItem implementation
+// =================================================================
+CGpuPowerItem::CGpuPowerItem(const wchar_t* name, const wchar_t* id)
+{
+    wcscpy_s(m_item_name, name);
+    wcscpy_s(m_item_id, id);
+    wcscpy_s(m_value_text, L"N/A");
+}
+
+const wchar_t* CGpuPowerItem::GetItemName() const
+{
+    return m_item_name;
+}
+
+const wchar_t* CGpuPowerItem::GetItemId() const
+{
+    return m_item_id;
+}
+
+const wchar_t* CGpuPowerItem::GetItemLableText() const
+{
+    return L"功耗";
+}
+
+const wchar_t* CGpuPowerItem::GetItemValueText() const
+{
+    return m_value_text;
+}
+
+const wchar_t* CGpuPowerItem::GetItemValueSampleText() const
+{
+    return L"888 W / 888 W";
+}
+
+int CGpuPowerItem::IsDrawResourceUsageGraph() const
+{
+    return 1;
+}
+
+float CGpuPowerItem::GetResourceUsageGraphValue() const
+{
+    return m_graph_value;
+}
+
+void CGpuPowerItem::SetPower(float watts, float limit_watts)
+{
+    if (watts < 0.0f) {
+        wcscpy_s(m_value_text, L"N/A");
+        m_graph_value = 0.0f;
+        return;
+    }
+    if (limit_watts > 0.0f) {
+        swprintf_s(m_value_text, L"%.0f W / %.0f W", watts, limit_watts);
+        m_graph_value = min(1.0f, watts / limit_watts);
+    } else {
+        swprintf_s(m_value_text, L"%.0f W", watts);
+        m_graph_value = 0.0f;
+    }
+}
+
+// =================================================================
+// CGpuMemoryItem implementation
+// =================================================================
+CGpuMemoryItem::CGpuMemoryItem(const wchar_t* name, const wchar_t* id)
+{
+    wcscpy_s(m_item_name, name);
+    wcscpy_s(m_item_id, id);
+    wcscpy_s(m_value_text, L"N/A");
+}
+
+const wchar_t* CGpuMemoryItem::GetItemName() const
+{
+    return m_item_name;
+}
+
+const wchar_t* CGpuMemoryItem::GetItemId() const
+{
+    return m_item_id;
+}
+
+const wchar_t* CGpuMemoryItem::GetItemLableText() const
+{
+    return L"显存";
+}
+
+const wchar_t* CGpuMemoryItem::GetItemValueText() const
+{
+    return m_value_text;
+}
+
+const wchar_t* CGpuMemoryItem::GetItemValueSampleText() const
+{
+    return L"88.8/88 GB B1 100%";
+}
+
+int CGpuMemoryItem::IsDrawResourceUsageGraph() const
+{
+    return 1;
+}
+
+float CGpuMemoryItem::GetResourceUsageGraphValue() const
+{
+    return m_graph_value;
+}
+
+void CGpuMemoryItem::SetMemory(const CGpuMemory& memory)
+{
+    if (memory.total == 0) {
+        wcscpy_s(m_value_text, L"N/A");
+        m_graph_value = 0.0f;
+        return;
+    }
+    const double GB = 1024.0 * 1024.0 * 1024.0;
+    m_graph_value = static_cast<float>(static_cast<double>(memory.used) / memory.total);
+    int length = swprintf_s(m_value_text, L"%.1f/%.0f GB", memory.used / GB, memory.total / GB);
+    if (memory.bar1_total > 0 && length > 0) {
+        swprintf_s(m_value_text + length, ARRAYSIZE(m_value_text) - length, L" B1 %.0f%%",
+            memory.bar1_used * 100.0 / memory.bar1_total);
+    }
 }
 
 // =================================================================
@@ -295,6 +576,11 @@ CTempMonitorItem::CTempMonitorItem(const wchar_t* name, const wchar_t* id, const
     ReleaseDC(NULL, hdc);
 }
 
+CTempMonitorItem::~CTempMonitorItem()
+{
+    ReleaseCache();
+}
+
 const wchar_t* CTempMonitorItem::GetItemName() const
 {
     return m_item_name;
@@ -332,6 +618,11 @@ int CTempMonitorItem::GetItemWidth() const
 
 void CTempMonitorItem::SetValue(int temp)
 {
+    // 只有显示文本变化时才需要重绘
+    int shown = (temp > 0) ? temp : 0;
+    int last_shown = (m_temp > 0) ? m_temp : 0;
+    if (shown != last_shown) ++m_text_id;
+
     m_temp = temp;
     if (temp > 0)
         swprintf_s(m_value_text, L"%d°C", temp);
@@ -346,29 +637,74 @@ COLORREF CTempMonitorItem::GetTemperatureColor() const
     return RGB(118, 202, 83);                  // Green
 }
 
-void CTempMonitorItem::DrawItem(void* hDC, int x, int y, int w, int h, bool dark_mode)
+void CTempMonitorItem::ReleaseCache()
 {
-    HDC dc = (HDC)hDC;
-    RECT rect = { x, y, x + w, y + h };
+    if (m_cache_dc) {
+        SelectObject(m_cache_dc, m_cache_old_bitmap);
+        DeleteDC(m_cache_dc);
+        m_cache_dc = nullptr;
+    }
+    if (m_cache_bitmap) {
+        DeleteObject(m_cache_bitmap);
+        m_cache_bitmap = nullptr;
+    }
+    m_cache_text_id = -1;
+}
+
+void CTempMonitorItem::RenderToCache(HDC dc, int w, int h, bool dark_mode)
+{
+    if (!m_cache_dc || m_cache_w != w || m_cache_h != h) {
+        ReleaseCache();
+        m_cache_dc = CreateCompatibleDC(dc);
+        m_cache_bitmap = CreateCompatibleBitmap(dc, w, h);
+        m_cache_old_bitmap = SelectObject(m_cache_dc, m_cache_bitmap);
+        m_cache_w = w;
+        m_cache_h = h;
+    }
+    // 沿用主程序在目标 DC 上选好的字体
+    HGDIOBJ font = GetCurrentObject(dc, OBJ_FONT);
+    SelectObject(m_cache_dc, font);
+
+    RECT rect = { 0, 0, w, h };
 
     // Draw background
     HBRUSH bg_brush = CreateSolidBrush(RGB(0, 0, 0));
-    FillRect(dc, &rect, bg_brush);
+    FillRect(m_cache_dc, &rect, bg_brush);
     DeleteObject(bg_brush);
 
-    SetBkMode(dc, TRANSPARENT);
+    SetBkMode(m_cache_dc, TRANSPARENT);
 
     // Draw label
     COLORREF label_color = dark_mode ? RGB(255, 255, 255) : RGB(0, 0, 0);
-    SetTextColor(dc, label_color);
+    SetTextColor(m_cache_dc, label_color);
     RECT label_rect = rect;
-    DrawTextW(dc, m_label, -1, &label_rect, DT_LEFT | DT_VCENTER | DT_SINGLELINE);
+    DrawTextW(m_cache_dc, m_label, -1, &label_rect, DT_LEFT | DT_VCENTER | DT_SINGLELINE);
 
     // Draw value
     COLORREF value_color = (m_temp > 0) ? GetTemperatureColor() : label_color;
-    SetTextColor(dc, value_color);
+    SetTextColor(m_cache_dc, value_color);
     RECT value_rect = rect;
-    DrawTextW(dc, m_value_text, -1, &value_rect, DT_RIGHT | DT_VCENTER | DT_SINGLELINE);
+    DrawTextW(m_cache_dc, m_value_text, -1, &value_rect, DT_RIGHT | DT_VCENTER | DT_SINGLELINE);
+
+    m_cache_text_id = m_text_id;
+    m_cache_dark_mode = dark_mode;
+    m_cache_font = font;
+}
+
+void CTempMonitorItem::DrawItem(void* hDC, int x, int y, int w, int h, bool dark_mode)
+{
+    HDC dc = (HDC)hDC;
+    if (w <= 0 || h <= 0) return;
+
+    bool unchanged = m_cache_dc && m_cache_text_id == m_text_id && m_cache_w == w && m_cache_h == h
+        && m_cache_dark_mode == dark_mode && m_cache_font == GetCurrentObject(dc, OBJ_FONT);
+    if (unchanged) {
+        ++CDrawCacheStats::hits;
+    } else {
+        ++CDrawCacheStats::misses;
+        RenderToCache(dc, w, h, dark_mode);
+    }
+    BitBlt(dc, x, y, w, h, m_cache_dc, 0, 0, SRCCOPY);
 }
 
 
@@ -382,46 +718,87 @@ CCPUCoreBarsPlugin& CCPUCoreBarsPlugin::Instance()
 }
 
 CCPUCoreBarsPlugin::CCPUCoreBarsPlugin()
-    : m_cached_whea_count(0), m_cached_nvlddmkm_count(0), m_last_error_check_time(0)
+    : m_error_monitor([](const std::vector<std::wstring>& providers, bool subscribe) {
+          return CreateEventLogReader(L"System", providers, ERROR_WINDOW_MS, subscribe);
+      })
 {
     GdiplusStartupInput gdiplusStartupInput;
     GdiplusStartup(&m_gdiplusToken, &gdiplusStartupInput, NULL);
 
-    SYSTEM_INFO sys_info;
-    GetSystemInfo(&sys_info);
-    m_num_cores = sys_info.dwNumberOfProcessors;
-    DetectCoreTypes();
+    // 拓扑覆盖所有处理器组；GetSystemInfo 只报告当前组，仅作后备
+    if (!m_topology.Detect()) {
+        SYSTEM_INFO sys_info;
+        GetSystemInfo(&sys_info);
+        m_topology.LoadSingleGroup(sys_info.dwNumberOfProcessors);
+    }
+    m_num_cores = m_topology.GetCount();
+    m_core_history.Init(m_num_cores);
     for (int i = 0; i < m_num_cores; ++i)
     {
-        bool is_e_core = (m_core_efficiency[i] == 0);
-        m_all_items.push_back(new CCpuUsageItem(i, is_e_core));
+        auto cpu_item = new CCpuUsageItem(i, m_topology.IsEfficiencyCore(i));
+        cpu_item->SetHistory(&m_core_history);
+        m_all_items.push_back(cpu_item);
     }
-    if (PdhOpenQuery(nullptr, 0, &m_query) == ERROR_SUCCESS)
-    {
-        m_counters.resize(m_num_cores);
-        for (int i = 0; i < m_num_cores; ++i)
-        {
-            wchar_t counter_path[128];
-            swprintf_s(counter_path, L"\\Processor(%d)\\%% Processor Time", i);
-            PdhAddCounterW(m_query, counter_path, 0, &m_counters[i]);
-        }
-        PdhCollectQueryData(m_query);
+    m_display_usage.assign(m_num_cores, 0.0);
+    m_e_core_flags.resize(m_num_cores);
+    for (int i = 0; i < m_num_cores; ++i) {
+        m_e_core_flags[i] = m_topology.IsEfficiencyCore(i) ? 1 : 0;
     }
-    InitNVML();
+    m_heatmap_item = new CCpuHeatmapItem(m_display_usage.data(), m_e_core_flags.data(), m_num_cores);
+    m_all_items.push_back(m_heatmap_item);
+    m_cpu_sampler = CreateCpuSampler(m_topology, m_num_cores);
+    // 登录时驱动可能还没加载，初始化失败也继续，由轮询线程稍后重试
+    m_gpu_monitor->Init();
+    m_gpu_devices = m_gpu_monitor->GetDevices();
+    m_gpu_generation = m_gpu_monitor->GetGeneration();
+    m_nvml_state = m_gpu_monitor->GetState();
+    // 主程序只在加载时枚举一次显示项：NVML 还没就绪或没有 NVIDIA 显卡时先放一组占位项（显示 N/A），设备出现后绑定
+    if (m_gpu_devices.empty()) AddGpuItems(0, "");
+    SyncGpuItems(m_gpu_devices);
+    m_gpu_item_generation = m_gpu_generation;
+    m_gpu_monitor->StartXidListener();
 
     // 创建并添加温度监控项
-    if (m_gpu_item) m_all_items.push_back(m_gpu_item);
     m_cpu_temp_item = new CTempMonitorItem(L"CPU温度(动态颜色)", L"cpu_temp", L"");
     m_all_items.push_back(m_cpu_temp_item);
     m_gpu_temp_item = new CTempMonitorItem(L"GPU温度(动态颜色)", L"gpu_temp", L"");
     m_all_items.push_back(m_gpu_temp_item);
+
+    // 所有采集（PDH/NVML/事件日志）都在后台线程完成，不占用主程序的刷新线程
+    int num_cores = m_num_cores;
+    m_snapshots.InitSlots([num_cores](CSampleSnapshot& snapshot) {
+        snapshot.core_usage.assign(num_cores, 0.0);
+        snapshot.core_peak.assign(num_cores, 0.0f);
+        snapshot.core_p95.assign(num_cores, 0.0f);
+    });
+    const std::vector<CGpuDeviceInfo>& devices = m_gpu_devices;
+    unsigned int generation = m_gpu_generation;
+    m_snapshots.InitSlots([&devices, generation](CSampleSnapshot& snapshot) {
+        snapshot.gpus.assign(devices.size(), CGpuSample());
+        snapshot.gpu_devices = devices;
+        snapshot.gpu_generation = generation;
+    });
+    m_gpu_samples.assign(m_gpu_devices.size(), CGpuSample());
+    m_gpu_energy_j.assign(m_gpu_devices.size(), 0.0);
+    m_gpu_worker.Start(m_gpu_monitor.get());
+    m_sample_buffer.assign(num_cores, 0.0);
+    m_core_stats.Init(num_cores);
+    ApplyErrorSourceSettings();
+    m_sampler_thread.Start(SAMPLE_INTERVAL_MS, [this]() { SampleTick(); });
 }
 
 CCPUCoreBarsPlugin::~CCPUCoreBarsPlugin()
 {
-    if (m_query) PdhCloseQuery(m_query);
+    m_sampler_thread.Stop();
+    m_cpu_sampler.reset();
+    SaveGpuEnergy();
     for (auto item : m_all_items) delete item;
-    ShutdownNVML();
+    if (!m_gpu_worker.Stop(GPU_STOP_TIMEOUT_MS)) {
+        m_gpu_monitor->Abandon();
+        static_cast<void>(m_gpu_monitor.release());      // 故意泄漏
+    } else {
+        m_gpu_monitor->Shutdown();
+    }
     GdiplusShutdown(m_gdiplusToken);
 }
 
@@ -435,25 +812,124 @@ IPluginItem* CCPUCoreBarsPlugin::GetItem(int index)
 
 void CCPUCoreBarsPlugin::DataRequired()
 {
-    UpdateCpuUsage();
-    UpdateGpuLimitReason();
-    
+    // 只读取采样线程发布的最新快照，不做任何阻塞调用
+    const CSampleSnapshot& snapshot = m_snapshots.Read();
+    for (int i = 0; i < m_num_cores; ++i) {
+        if (auto cpu_item = dynamic_cast<CCpuUsageItem*>(m_all_items[i]))
+        {
+            cpu_item->SetUsage(snapshot.core_usage[i]);
+            cpu_item->SetPeak(snapshot.core_peak[i]);
+        }
+    }
+    std::copy(snapshot.core_usage.begin(), snapshot.core_usage.end(), m_display_usage.begin());
+    if (snapshot.sequence != m_history_sequence) {
+        m_core_history.Push(snapshot.core_usage.data());
+        m_history_sequence = snapshot.sequence;
+    }
+
+    // 通知采样线程开始新的统计窗口
+    m_consume_epoch.fetch_add(1, std::memory_order_release);
+
     // 更新温度项的文本
     if (m_cpu_temp_item) m_cpu_temp_item->SetValue(m_cpu_temp);
     if (m_gpu_temp_item) m_gpu_temp_item->SetValue(m_gpu_temp);
 
-    // 减少事件日志查询频率 - 60秒检查一次
-    DWORD current_time = GetTickCount();
-    if (current_time - m_last_error_check_time > ERROR_CHECK_INTERVAL_MS) {
-        UpdateWheaErrorCount();
-        UpdateNvlddmkmErrorCount();
-        m_last_error_check_time = current_time;
+    // NVML 重新初始化后设备列表可能变化，显示项在主线程上重新对应
+    if (snapshot.gpu_generation != m_gpu_item_generation) {
+        SyncGpuItems(snapshot.gpu_devices);
+        m_gpu_item_generation = snapshot.gpu_generation;
     }
-    
-    if (m_gpu_item) {
-        bool has_error = (m_cached_whea_count > 0 || m_cached_nvlddmkm_count > 0);
-        m_gpu_item->SetSystemErrorStatus(has_error);
+    // 还没绑定过设备的占位项只反映系统错误等级，文本保持 N/A
+    for (size_t k = 0; k < m_gpu_slot_bus_ids.size(); ++k) {
+        if (m_gpu_slot_bus_ids[k].empty()) m_gpu_items[k]->SetSystemErrorLevel(snapshot.error_level);
+    }
+    for (size_t i = 0; i < snapshot.gpus.size() && i < m_gpu_device_slots.size(); ++i) {
+        const CGpuSample& gpu = snapshot.gpus[i];
+        int slot = m_gpu_device_slots[i];
+        m_gpu_items[slot]->SetReason(gpu.reason);
+        m_gpu_items[slot]->SetHealth(gpu.health);
+        m_gpu_items[slot]->SetViolationFraction(gpu.violation.valid ? gpu.violation.throttled_fraction : -1.0f);
+        SystemErrorLevel level = snapshot.error_level;
+        if (gpu.xid_count > 0) level = max(level, SYSTEM_ERROR_ERROR);
+        m_gpu_items[slot]->SetSystemErrorLevel(level);
+        m_gpu_nvml_temp_items[slot]->SetValue(static_cast<int>(gpu.temperature));
+        m_gpu_util_items[slot]->SetUtilization(gpu.utilization[GPU_UTIL_GPU]);
+        float limit_w = gpu.telemetry.Has(GPU_FIELD_POWER_LIMIT) ? gpu.telemetry.values[GPU_FIELD_POWER_LIMIT] / 1000.0f : -1.0f;
+        m_gpu_power_items[slot]->SetPower(gpu.health == GPU_HEALTH_OK ? gpu.average_power_w : -1.0f, limit_w);
+        m_gpu_memory_items[slot]->SetMemory(gpu.memory);
+        if (i < snapshot.gpu_energy_j.size()) m_gpu_session_kwh[slot] = snapshot.gpu_energy_j[i] / 3.6e6;
+    }
+}
+
+void CCPUCoreBarsPlugin::SampleTick()
+{
+    // DataRequired 读取过快照后，丢弃旧窗口的统计
+    unsigned int epoch = m_consume_epoch.load(std::memory_order_acquire);
+    if (epoch != m_stats_epoch) {
+        m_core_stats.Reset();
+        m_stats_epoch = epoch;
+    }
+
+    CSampleSnapshot& snapshot = m_snapshots.WriteBuffer();
+    UpdateCpuUsage(snapshot);
+
+    // GPU 和事件日志不需要高频采样，仍按约 1 秒一次执行
+    ULONGLONG now = GetTickCount64();
+    if (m_last_slow_tick == 0 || now - m_last_slow_tick >= SAMPLE_INTERVAL_MS - SAMPLE_INTERVAL_MS / 10) {
+        m_last_slow_tick = now;
+        // 一次遍历轮询所有 GPU；驱动卡住时只等待有限时间，保留旧数据并标记为无响应
+        // 没有设备时也要发出请求，NVML 的重新初始化由轮询线程顺带完成
+        if (m_gpu_worker.Poll(m_gpu_samples, GPU_POLL_TIMEOUT_MS) == CGpuPollWorker::POLL_OK) {
+            m_nvml_state = m_gpu_worker.GetState();
+            // 有 NVML Xid 事件监听时 nvlddmkm 不进入日志查询，显卡错误由 Xid 计数报告
+            // 监听状态由工作线程写入，只有取到结果后才能读取；超时期间保持上一次的设置
+            m_error_monitor.SetSuppressed(L"nvlddmkm", m_gpu_worker.IsXidListenerRunning());
+            if (m_gpu_worker.GetGeneration() != m_gpu_generation) {
+                RemapGpuEnergy(m_gpu_worker.GetDevices());
+                m_gpu_devices = m_gpu_worker.GetDevices();
+                m_gpu_generation = m_gpu_worker.GetGeneration();
+            }
+            // 每次成功轮询的能耗差值只累加一次；丢失的设备保留的是旧值，不能再计
+            for (size_t i = 0; i < m_gpu_samples.size(); ++i) {
+                if (m_gpu_samples[i].health == GPU_HEALTH_OK) m_gpu_energy_j[i] += m_gpu_samples[i].energy_mj / 1000.0;
+            }
+        } else {
+            for (CGpuSample& sample : m_gpu_samples) sample.health = GPU_HEALTH_UNRESPONSIVE;
+        }
+
+        // 来源或订阅模式变化后重建读取器，窗口从头统计
+        if (m_error_config_dirty.exchange(false, std::memory_order_acquire)) {
+            std::lock_guard<std::mutex> lock(m_error_config_mutex);
+            m_error_monitor.Configure(m_pending_error_providers, m_pending_error_subscribe);
+        }
+
+        // 推送订阅只需取走已到达的事件，每次都检查；轮询模式 60 秒检查一次
+        // 只读取书签之后的新事件，过期的桶整桶丢弃，不再重新扫描整个 24 小时
+        FILETIME now;
+        GetSystemTimeAsFileTime(&now);
+        m_error_monitor.Update(GetTickCount64(), (static_cast<ULONGLONG>(now.dwHighDateTime) << 32) | now.dwLowDateTime);
+    }
+    snapshot.gpus.assign(m_gpu_samples.begin(), m_gpu_samples.end());
+    if (snapshot.gpu_generation != m_gpu_generation) {
+        snapshot.gpu_devices = m_gpu_devices;
+        snapshot.gpu_generation = m_gpu_generation;
+    }
+    snapshot.nvml_state = m_nvml_state;
+    snapshot.gpu_energy_j.assign(m_gpu_energy_j.begin(), m_gpu_energy_j.end());
+    snapshot.error_level = m_error_monitor.GetLevel();
+    snapshot.error_provider_count = m_error_monitor.GetProviderCount();
+    for (int i = 0; i < snapshot.error_provider_count; ++i) {
+        snapshot.error_counts[i] = m_error_monitor.GetCount(i);
     }
+    const CWheaErrorLog& whea_log = m_error_monitor.GetWheaLog();
+    for (int s = 0; s < WHEA_SEVERITY_COUNT; ++s) {
+        snapshot.whea_counts[s] = whea_log.GetCount(static_cast<WheaSeverity>(s));
+    }
+    snapshot.has_whea_record = whea_log.GetRecordCount() > 0;
+    if (snapshot.has_whea_record) snapshot.last_whea = whea_log.GetRecord(0);
+
+    snapshot.sequence = ++m_snapshot_sequence;
+    m_snapshots.Publish();
 }
 
 void CCPUCoreBarsPlugin::OnMonitorInfo(const ITMPlugin::MonitorInfo& monitor_info)
@@ -463,167 +939,416 @@ void CCPUCoreBarsPlugin::OnMonitorInfo(const ITMPlugin::MonitorInfo& monitor_inf
     m_gpu_temp = monitor_info.gpu_temperature;
 }
 
-const wchar_t* CCPUCoreBarsPlugin::GetInfo(PluginInfoIndex index)
+const wchar_t* CCPUCoreBarsPlugin::GetTooltipInfo()
 {
-    switch (index) {
-    case TMI_NAME: return L"性能/错误监控";
-    case TMI_DESCRIPTION: return L"CPU核心条形图/GPU受限&错误/WHEA错误";
-    case TMI_AUTHOR: return L"Your Name";
-    case TMI_COPYRIGHT: return L"Copyright (C) 2025";
-    case TMI_URL: return L"";
-    case TMI_VERSION: return L"3.8.0";
-    default: return L"";
+    m_tooltip_text.clear();
+    wchar_t line[128];
+    if (m_settings.high_freq_enabled) {
+        // 列出窗口内峰值最高的几个核心
+        const CSampleSnapshot& snapshot = m_snapshots.Read();
+        const int TOP_N = 3;
+        int top[TOP_N] = { -1, -1, -1 };
+        for (int i = 0; i < m_num_cores; ++i) {
+            for (int k = 0; k < TOP_N; ++k) {
+                if (top[k] < 0 || snapshot.core_peak[i] > snapshot.core_peak[top[k]]) {
+                    for (int m = TOP_N - 1; m > k; --m) top[m] = top[m - 1];
+                    top[k] = i;
+                    break;
+                }
+            }
+        }
+        for (int k = 0; k < TOP_N && top[k] >= 0; ++k) {
+            int i = top[k];
+            swprintf_s(line, L"核心 %d: 平均 %.0f%% / P95 %.0f%% / 峰值 %.0f%%\r\n", i,
+                snapshot.core_usage[i] * 100.0, snapshot.core_p95[i] * 100.0, snapshot.core_peak[i] * 100.0);
+            m_tooltip_text += line;
+        }
     }
-}
 
-void CCPUCoreBarsPlugin::InitNVML()
-{
-    m_nvml_dll = LoadLibrary(L"nvml.dll");
-    if (!m_nvml_dll) return;
+    // 每个 GPU 的批量遥测；进程列表只在提示显示期间由轮询线程读取，这里先发出请求
+    m_gpu_monitor->RequestProcesses();
+    const CSampleSnapshot& gpu_snapshot = m_snapshots.Read();
+    if (gpu_snapshot.nvml_state == NVML_LOST || gpu_snapshot.nvml_state == NVML_REINITIALIZING) {
+        m_tooltip_text += L"NVML: 驱动已重置或设备丢失，正在等待重新初始化\r\n";
+    }
+    for (size_t i = 0; i < gpu_snapshot.gpus.size() && i < gpu_snapshot.gpu_devices.size(); ++i) {
+        const CGpuSample& gpu = gpu_snapshot.gpus[i];
+        const CGpuTelemetry& telemetry = gpu.telemetry;
+        swprintf_s(line, L"GPU%u:", gpu_snapshot.gpu_devices[i].index);
+        m_tooltip_text += line;
+        if (gpu.health == GPU_HEALTH_UNRESPONSIVE) m_tooltip_text += L" NVML 无响应，以下为旧数据";
+        else if (gpu.health == GPU_HEALTH_LOST) m_tooltip_text += L" 设备已从总线上丢失，以下为旧数据";
+        if (telemetry.Has(GPU_FIELD_POWER)) {
+            swprintf_s(line, L" 功耗 %.1f W", telemetry.values[GPU_FIELD_POWER] / 1000.0);
+            m_tooltip_text += line;
+            if (telemetry.Has(GPU_FIELD_POWER_LIMIT)) {
+                swprintf_s(line, L" / %.0f W", telemetry.values[GPU_FIELD_POWER_LIMIT] / 1000.0);
+                m_tooltip_text += line;
+            }
+        }
+        if (telemetry.Has(GPU_FIELD_MEMORY_TEMP)) {
+            swprintf_s(line, L" 显存 %llu°C", telemetry.values[GPU_FIELD_MEMORY_TEMP]);
+            m_tooltip_text += line;
+        }
+        if (telemetry.Has(GPU_FIELD_SLOWDOWN_TEMP)) {
+            swprintf_s(line, L" 降频阈值 %llu°C", telemetry.values[GPU_FIELD_SLOWDOWN_TEMP]);
+            m_tooltip_text += line;
+        }
+        m_tooltip_text += L"\r\n";
 
-    p_nvmlInit = (decltype(p_nvmlInit))GetProcAddress(m_nvml_dll, "nvmlInit_v2");
-    p_nvmlShutdown = (decltype(p_nvmlShutdown))GetProcAddress(m_nvml_dll, "nvmlShutdown");
-    p_nvmlDeviceGetHandleByIndex = (decltype(p_nvmlDeviceGetHandleByIndex))GetProcAddress(m_nvml_dll, "nvmlDeviceGetHandleByIndex_v2");
-    p_nvmlDeviceGetCurrentClocksThrottleReasons = (decltype(p_nvmlDeviceGetCurrentClocksThrottleReasons))GetProcAddress(m_nvml_dll, "nvmlDeviceGetCurrentClocksThrottleReasons");
+        if (gpu.xid_count > 0) {
+            swprintf_s(line, L"  Xid 错误: %u 次 (最近 Xid %u)\r\n", gpu.xid_count, gpu.last_xid);
+            m_tooltip_text += line;
+        }
 
-    if (!p_nvmlInit || !p_nvmlShutdown || !p_nvmlDeviceGetHandleByIndex || !p_nvmlDeviceGetCurrentClocksThrottleReasons) {
-        ShutdownNVML();
-        return;
+        // 显存占用和占用最多的进程
+        if (gpu.memory.total > 0) {
+            const double MB = 1024.0 * 1024.0;
+            swprintf_s(line, L"  显存 %.0f / %.0f MB (保留 %.0f MB)", gpu.memory.used / MB, gpu.memory.total / MB, gpu.memory.reserved / MB);
+            m_tooltip_text += line;
+            if (gpu.memory.bar1_total > 0) {
+                swprintf_s(line, L" BAR1 %.0f / %.0f MB", gpu.memory.bar1_used / MB, gpu.memory.bar1_total / MB);
+                m_tooltip_text += line;
+            }
+            m_tooltip_text += L"\r\n";
+        }
+        for (int p = 0; p < gpu.process_count; ++p) {
+            const CGpuProcess& process = gpu.top_processes[p];
+            if (process.used_memory == GPU_PROCESS_MEMORY_UNAVAILABLE) {
+                swprintf_s(line, L"    %s (%u): 显存用量不可用\r\n", process.name, process.pid);
+            } else {
+                swprintf_s(line, L"    %s (%u): %.0f MB\r\n", process.name, process.pid, process.used_memory / (1024.0 * 1024.0));
+            }
+            m_tooltip_text += line;
+        }
+
+        // 能耗计数求出的平均功耗和累计电量
+        if (gpu.average_power_w >= 0.0f && i < gpu_snapshot.gpu_energy_j.size()) {
+            double session_kwh = gpu_snapshot.gpu_energy_j[i] / 3.6e6;
+            swprintf_s(line, L"  平均功耗 %.1f W，本次 %.3f kWh", gpu.average_power_w, session_kwh);
+            m_tooltip_text += line;
+            if (gpu_snapshot.gpu_generation == m_gpu_item_generation && i < m_gpu_device_slots.size()) {
+                int slot = m_gpu_device_slots[i];
+                if (m_gpu_energy_base_kwh[slot] >= 0.0) {
+                    swprintf_s(line, L"，累计 %.3f kWh", m_gpu_energy_base_kwh[slot] + session_kwh);
+                    m_tooltip_text += line;
+                }
+            }
+            m_tooltip_text += L"\r\n";
+        }
+
+        // 间隔内的亚秒级利用率采样
+        static const wchar_t* const util_names[GPU_UTIL_COUNT] = { L"核心", L"显存", L"编码", L"解码" };
+        bool has_util = false;
+        for (int u = 0; u < GPU_UTIL_COUNT; ++u) {
+            const CGpuUtilization& util = gpu.utilization[u];
+            if (util.count == 0) continue;
+            if (!has_util) m_tooltip_text += L"  利用率:";
+            has_util = true;
+            swprintf_s(line, L" %s %u%% (%u-%u)", util_names[u], util.mean, util.min, util.max);
+            m_tooltip_text += line;
+        }
+        if (has_util) m_tooltip_text += L"\r\n";
+
+        // 上一个间隔内各策略的降频时间
+        if (gpu.violation.valid && gpu.violation.interval_ns > 0) {
+            static const wchar_t* const violation_names[GPU_VIOLATION_COUNT] = {
+                L"功耗", L"温度", L"同步加速", L"板卡限制", L"低负载", L"可靠性"
+            };
+            m_tooltip_text += L"  降频时间:";
+            for (int v = 0; v < GPU_VIOLATION_COUNT; ++v) {
+                double percent = gpu.violation.throttled_ns[v] * 100.0 / gpu.violation.interval_ns;
+                if (percent < 1.0) continue;
+                swprintf_s(line, L" %s %.0f%%", violation_names[v], percent);
+                m_tooltip_text += line;
+            }
+            m_tooltip_text += L"\r\n";
+        }
+
+        // 各时钟事件原因在最近窗口内的时间占比
+        if (gpu.reason_window_ms > 0) {
+            DWORD minutes = max(1ul, (gpu.reason_window_ms + 30000) / 60000);
+            for (int r = 0; r < CLOCK_REASON_COUNT; ++r) {
+                float fraction = gpu.reason_fraction[r];
+                if (fraction < 0.01f) continue;
+                swprintf_s(line, L"  %s: 最近 %lu 分钟内 %.0f%%\r\n", GetClockEventReason(r).name, minutes, fraction * 100.0f);
+                m_tooltip_text += line;
+            }
+        }
     }
-    if (p_nvmlInit() != NVML_SUCCESS) {
-        ShutdownNVML();
-        return;
+
+    // 最近 24 小时各来源的系统错误数
+    const CSampleSnapshot& error_snapshot = m_snapshots.Read();
+    int provider_count = min(error_snapshot.error_provider_count, static_cast<int>(m_settings.error_providers.size()));
+    for (int i = 0; i < provider_count; ++i) {
+        if (error_snapshot.error_counts[i] == 0) continue;
+        swprintf_s(line, L"%s: 24 小时内 %lu 条\r\n", m_settings.error_providers[i].c_str(), error_snapshot.error_counts[i]);
+        m_tooltip_text += line;
     }
-    if (p_nvmlDeviceGetHandleByIndex(0, &m_nvml_device) != NVML_SUCCESS) {
-        ShutdownNVML();
-        return;
+
+    // WHEA 按严重程度的计数和最新一条记录的位置
+    if (error_snapshot.has_whea_record) {
+        swprintf_s(line, L"WHEA: 已纠正 %u / 未纠正 %u / 致命 %u\r\n", error_snapshot.whea_counts[WHEA_CORRECTED],
+            error_snapshot.whea_counts[WHEA_UNCORRECTED], error_snapshot.whea_counts[WHEA_FATAL]);
+        m_tooltip_text += line;
+        const CWheaRecord& record = error_snapshot.last_whea;
+        swprintf_s(line, L"  最近: 事件 %u 来源 %s", record.event_id, GetWheaSourceName(record.source));
+        m_tooltip_text += line;
+        if (record.HasErrorType()) {
+            swprintf_s(line, L" 类型 %u", record.error_type);
+            m_tooltip_text += line;
+        }
+        if (record.HasApicId()) {
+            swprintf_s(line, L" APIC %u", record.apic_id);
+            m_tooltip_text += line;
+        }
+        if (record.HasPciAddress()) {
+            swprintf_s(line, L" PCI %04x:%02x:%02x.%x", record.pci_segment, record.pci_bus, record.pci_device, record.pci_function);
+            m_tooltip_text += line;
+        }
+        m_tooltip_text += L"\r\n";
+    }
+
+    // 绘制缓存命中率，用于确认空闲时跳过的重绘
+    unsigned long long total = CDrawCacheStats::hits + CDrawCacheStats::misses;
+    if (total > 0) {
+        swprintf_s(line, L"绘制缓存: 命中 %llu / 重绘 %llu (%.0f%%)", CDrawCacheStats::hits,
+            CDrawCacheStats::misses, CDrawCacheStats::hits * 100.0 / total);
+        m_tooltip_text += line;
+    }
+    return m_tooltip_text.c_str();
+}
+
+void CCPUCoreBarsPlugin::OnExtenedInfo(ExtendedInfoIndex index, const wchar_t* data)
+{
+    if (index == EI_CONFIG_DIR) {
+        m_settings.Load(data);
+        ApplySettings();
+        SaveGpuEnergy();        // 读取已绑定显卡的历史能耗
+    }
+}
+
+void CCPUCoreBarsPlugin::ApplySettings()
+{
+    DWORD interval = SAMPLE_INTERVAL_MS;
+    if (m_settings.high_freq_enabled) {
+        // 实际频率受系统定时器精度（通常 15.6ms）限制
+        interval = 1000 / m_settings.high_freq_hz;
+    }
+    m_sampler_thread.SetInterval(interval);
+    m_gpu_monitor->SetFieldMask(m_settings.gpu_field_mask);
+    m_gpu_monitor->SetLibraryPath(m_settings.nvml_path.c_str());
+    m_gpu_monitor->SetBar1Enabled(m_settings.gpu_show_bar1);
+    ApplyErrorSourceSettings();
+    for (auto gpu_item : m_gpu_items) gpu_item->SetColorByViolation(m_settings.gpu_color_by_violation);
+
+    for (int i = 0; i < m_num_cores; ++i) {
+        if (auto cpu_item = dynamic_cast<CCpuUsageItem*>(m_all_items[i]))
+        {
+            cpu_item->SetSparklineMode(m_settings.sparkline_mode);
+        }
     }
-    m_nvml_initialized = true;
-    m_gpu_item = new CNvidiaMonitorItem();
 }
 
-void CCPUCoreBarsPlugin::ShutdownNVML()
+int CCPUCoreBarsPlugin::GetCommandCount()
 {
-    if (m_nvml_initialized && p_nvmlShutdown) {
-        p_nvmlShutdown();
+    return CMD_COUNT;
+}
+
+const wchar_t* CCPUCoreBarsPlugin::GetCommandName(int command_index)
+{
+    switch (command_index) {
+    case CMD_HIGH_FREQ_SAMPLING: return L"高频采样（峰值保持）";
+    case CMD_SPARKLINE_MODE: return L"核心历史曲线";
+    case CMD_GPU_COLOR_BY_VIOLATION: return L"GPU 按降频时间着色";
+    case CMD_ERROR_SUBSCRIPTION: return L"实时订阅系统错误事件";
+    case CMD_GPU_SHOW_BAR1: return L"显存项显示 BAR1 占用";
+    default: return nullptr;
     }
-    if (m_nvml_dll) {
-        FreeLibrary(m_nvml_dll);
+}
+
+void CCPUCoreBarsPlugin::OnPluginCommand(int command_index, void* hWnd, void* para)
+{
+    switch (command_index) {
+    case CMD_HIGH_FREQ_SAMPLING:
+        m_settings.high_freq_enabled = !m_settings.high_freq_enabled;
+        break;
+    case CMD_SPARKLINE_MODE:
+        m_settings.sparkline_mode = !m_settings.sparkline_mode;
+        break;
+    case CMD_GPU_COLOR_BY_VIOLATION:
+        m_settings.gpu_color_by_violation = !m_settings.gpu_color_by_violation;
+        break;
+    case CMD_ERROR_SUBSCRIPTION:
+        m_settings.error_subscription = !m_settings.error_subscription;
+        break;
+    case CMD_GPU_SHOW_BAR1:
+        m_settings.gpu_show_bar1 = !m_settings.gpu_show_bar1;
+        break;
+    default:
+        return;
     }
-    m_nvml_initialized = false;
-    m_nvml_dll = nullptr;
+    m_settings.Save();
+    SaveGpuEnergy();
+    ApplySettings();
 }
 
-void CCPUCoreBarsPlugin::UpdateGpuLimitReason()
+int CCPUCoreBarsPlugin::IsCommandChecked(int command_index)
 {
-    if (!m_nvml_initialized || !m_gpu_item) return;
+    switch (command_index) {
+    case CMD_HIGH_FREQ_SAMPLING: return m_settings.high_freq_enabled;
+    case CMD_SPARKLINE_MODE: return m_settings.sparkline_mode;
+    case CMD_GPU_COLOR_BY_VIOLATION: return m_settings.gpu_color_by_violation;
+    case CMD_ERROR_SUBSCRIPTION: return m_settings.error_subscription;
+    case CMD_GPU_SHOW_BAR1: return m_settings.gpu_show_bar1;
+    default: return false;
+    }
+}
 
-    unsigned long long reasons = 0;
-    if (p_nvmlDeviceGetCurrentClocksThrottleReasons(m_nvml_device, &reasons) == NVML_SUCCESS) {
-        if (reasons & nvmlClocksThrottleReasonHwThermalSlowdown) { m_gpu_item->SetValue(L"过热"); }
-        else if (reasons & nvmlClocksThrottleReasonSwThermalSlowdown) { m_gpu_item->SetValue(L"过热"); }
-        else if (reasons & nvmlClocksThrottleReasonHwPowerBrakeSlowdown) { m_gpu_item->SetValue(L"功耗"); }
-        else if (reasons & nvmlClocksThrottleReasonSwPowerCap) { m_gpu_item->SetValue(L"功耗"); }
-        else if (reasons & nvmlClocksThrottleReasonGpuIdle) { m_gpu_item->SetValue(L"空闲"); }
-        else if (reasons == nvmlClocksThrottleReasonApplicationsClocksSetting) { m_gpu_item->SetValue(L"无限"); }
-        else { m_gpu_item->SetValue(L"无"); }
-    } else {
-        m_gpu_item->SetValue(L"错误");
+const wchar_t* CCPUCoreBarsPlugin::GetInfo(PluginInfoIndex index)
+{
+    switch (index) {
+    case TMI_NAME: return L"性能/错误监控";
+    case TMI_DESCRIPTION: return L"CPU核心条形图/GPU受限&错误/WHEA错误";
+    case TMI_AUTHOR: return L"Your Name";
+    case TMI_COPYRIGHT: return L"Copyright (C) 2025";
+    case TMI_URL: return L"";
+    case TMI_VERSION: return L"3.8.0";
+    default: return L"";
     }
 }
 
-void CCPUCoreBarsPlugin::UpdateCpuUsage()
+void CCPUCoreBarsPlugin::SyncGpuItems(const std::vector<CGpuDeviceInfo>& devices)
 {
-    if (!m_query) return;
-    if (PdhCollectQueryData(m_query) == ERROR_SUCCESS) {
-        for (int i = 0; i < m_num_cores; ++i) {
-            PDH_FMT_COUNTERVALUE value;
-            if (PdhGetFormattedCounterValue(m_counters[i], PDH_FMT_DOUBLE, nullptr, &value) == ERROR_SUCCESS) {
-                if(auto cpu_item = dynamic_cast<CCpuUsageItem*>(m_all_items[i]))
-                {
-                    cpu_item->SetUsage(value.doubleValue / 100.0);
-                }
-            } else {
-                if(auto cpu_item = dynamic_cast<CCpuUsageItem*>(m_all_items[i]))
-                {
-                    cpu_item->SetUsage(0.0);
-                }
+    // 按 PCI 总线号找回已有的显示项，新设备先占用占位项，再追加显示项
+    // 本次没有枚举到、但曾经绑定过设备的显示项标记为丢失；占位项从未见过设备，不算丢失
+    std::vector<bool> mapped(m_gpu_items.size(), false);
+    m_gpu_device_slots.assign(devices.size(), -1);
+    for (size_t i = 0; i < devices.size(); ++i) {
+        int slot = -1;
+        for (size_t k = 0; k < m_gpu_slot_bus_ids.size(); ++k) {
+            if (m_gpu_slot_bus_ids[k] == devices[i].pci_bus_id) {
+                slot = static_cast<int>(k);
+                break;
             }
         }
+        for (size_t k = 0; slot < 0 && k < m_gpu_slot_bus_ids.size(); ++k) {
+            if (m_gpu_slot_bus_ids[k].empty()) {
+                slot = static_cast<int>(k);
+                m_gpu_slot_bus_ids[k] = devices[i].pci_bus_id;
+            }
+        }
+        if (slot < 0) {
+            slot = AddGpuItems(devices[i].index, devices[i].pci_bus_id);
+            mapped.push_back(false);
+        }
+        m_gpu_device_slots[i] = slot;
+        mapped[slot] = true;
+    }
+    for (size_t k = 0; k < m_gpu_items.size(); ++k) {
+        if (!mapped[k] && !m_gpu_slot_bus_ids[k].empty()) m_gpu_items[k]->SetHealth(GPU_HEALTH_LOST);
     }
 }
 
-void CCPUCoreBarsPlugin::DetectCoreTypes()
-{
-    m_core_efficiency.assign(m_num_cores, 1);
-    DWORD length = 0;
-    GetLogicalProcessorInformationEx(RelationProcessorCore, nullptr, &length);
-    if (GetLastError() != ERROR_INSUFFICIENT_BUFFER) return;
-
-    std::vector<char> buffer(length);
-    PSYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX proc_info = (PSYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX)buffer.data();
-    if (!GetLogicalProcessorInformationEx(RelationProcessorCore, proc_info, &length)) return;
-
-    char* ptr = buffer.data();
-    while (ptr < buffer.data() + length) {
-        PSYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX current_info = (PSYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX)ptr;
-        if (current_info->Relationship == RelationProcessorCore) {
-            BYTE efficiency = current_info->Processor.EfficiencyClass;
-            for (int i = 0; i < current_info->Processor.GroupCount; ++i) {
-                KAFFINITY mask = current_info->Processor.GroupMask[i].Mask;
-                for (int j = 0; j < sizeof(KAFFINITY) * 8; ++j) {
-                    if ((mask >> j) & 1) {
-                        int logical_proc_index = j;
-                        if (logical_proc_index < m_num_cores) {
-                            m_core_efficiency[logical_proc_index] = efficiency;
-                        }
-                    }
-                }
+int CCPUCoreBarsPlugin::AddGpuItems(unsigned int index, const char* pci_bus_id)
+{
+    // 名称按枚举序号，ID 按 PCI 总线号，增减或重排显卡后已有的显示设置不会错位
+    // 第一组显示项的 ID 不含总线号：加载时 NVML 可能还没就绪，占位项和直接枚举到的设备 ID 相同
+    // 运行中新增的显示项要等主程序下次枚举插件项目时才会出现
+    const bool first = m_gpu_items.empty();
+    wchar_t bus_id[NVML_DEVICE_PCI_BUS_ID_BUFFER_SIZE];
+    size_t converted = 0;
+    mbstowcs_s(&converted, bus_id, pci_bus_id, _TRUNCATE);
+
+    wchar_t name[64], id[64];
+    swprintf_s(name, L"GPU%u/WHEA", index);
+    // 第一块 GPU 沿用单卡版本的 ID，升级后原来的显示设置仍然有效
+    if (first) wcscpy_s(id, L"gpu_system_status");
+    else swprintf_s(id, L"gpu_status_%s", bus_id);
+    auto status_item = new CNvidiaMonitorItem(name, id);
+    status_item->SetColorByViolation(m_settings.gpu_color_by_violation);
+    m_gpu_items.push_back(status_item);
+    m_all_items.push_back(status_item);
+
+    swprintf_s(name, L"GPU%u温度(NVML)", index);
+    if (first) wcscpy_s(id, L"gpu_nvml_temp");
+    else swprintf_s(id, L"gpu_temp_%s", bus_id);
+    auto temp_item = new CTempMonitorItem(name, id, L"");
+    m_gpu_nvml_temp_items.push_back(temp_item);
+    m_all_items.push_back(temp_item);
+
+    swprintf_s(name, L"GPU%u使用率(NVML)", index);
+    if (first) wcscpy_s(id, L"gpu_util");
+    else swprintf_s(id, L"gpu_util_%s", bus_id);
+    auto util_item = new CGpuUtilItem(name, id);
+    m_gpu_util_items.push_back(util_item);
+    m_all_items.push_back(util_item);
+
+    swprintf_s(name, L"GPU%u功耗(NVML)", index);
+    if (first) wcscpy_s(id, L"gpu_power");
+    else swprintf_s(id, L"gpu_power_%s", bus_id);
+    auto power_item = new CGpuPowerItem(name, id);
+    m_gpu_power_items.push_back(power_item);
+    m_all_items.push_back(power_item);
+    swprintf_s(name, L"GPU%u显存(NVML)", index);
+    if (first) wcscpy_s(id, L"gpu_memory");
+    else swprintf_s(id, L"gpu_memory_%s", bus_id);
+    auto memory_item = new CGpuMemoryItem(name, id);
+    m_gpu_memory_items.push_back(memory_item);
+    m_all_items.push_back(memory_item);
+
+    m_gpu_energy_base_kwh.push_back(-1.0);
+    m_gpu_session_kwh.push_back(0.0);
+
+    m_gpu_slot_bus_ids.push_back(pci_bus_id);
+    return static_cast<int>(m_gpu_items.size()) - 1;
+}
+
+void CCPUCoreBarsPlugin::RemapGpuEnergy(const std::vector<CGpuDeviceInfo>& devices)
+{
+    // 同一块卡重新初始化后继续累计本次运行的能耗
+    std::vector<double> energy(devices.size(), 0.0);
+    for (size_t i = 0; i < devices.size(); ++i) {
+        for (size_t k = 0; k < m_gpu_devices.size() && k < m_gpu_energy_j.size(); ++k) {
+            if (strcmp(devices[i].pci_bus_id, m_gpu_devices[k].pci_bus_id) == 0) {
+                energy[i] = m_gpu_energy_j[k];
+                break;
             }
         }
-        ptr += current_info->Size;
     }
+    m_gpu_energy_j.swap(energy);
 }
 
-// 优化的事件日志查询函数
-DWORD CCPUCoreBarsPlugin::QueryEventLogCount(LPCWSTR provider_name)
+void CCPUCoreBarsPlugin::SaveGpuEnergy()
 {
-    // 使用更高效的查询字符串
-    wchar_t query[256];
-    swprintf_s(query, 
-        L"*[System[Provider[@Name='%s'] and TimeCreated[timediff(@SystemTime) <= 86400000]]]",
-        provider_name);
-        
-    EVT_HANDLE hResults = EvtQuery(NULL, L"System", query, 
-        EvtQueryChannelPath | EvtQueryReverseDirection);
-    if (hResults == NULL) return 0;
-
-    DWORD total_count = 0;
-    EVT_HANDLE hEvents[256]; // 增大批处理大小
-    DWORD returned = 0;
-    
-    while (EvtNext(hResults, ARRAYSIZE(hEvents), hEvents, 1000, 0, &returned)) {
-        total_count += returned;
-        // 批量关闭事件句柄
-        for (DWORD i = 0; i < returned; i++) {
-            EvtClose(hEvents[i]);
-        }
+    // 历史值在配置目录可用后只读取一次，之后写回的都是历史值 + 本次运行的值
+    // 读写配置文件会阻塞，只在加载配置、保存设置和卸载插件时调用，不放在 DataRequired 里
+    if (!m_settings.IsLoaded()) return;
+    for (size_t slot = 0; slot < m_gpu_slot_bus_ids.size(); ++slot) {
+        if (m_gpu_slot_bus_ids[slot].empty()) continue;     // 还没绑定设备的占位项
+        const char* bus_id = m_gpu_slot_bus_ids[slot].c_str();
+        if (m_gpu_energy_base_kwh[slot] < 0.0) m_gpu_energy_base_kwh[slot] = m_settings.LoadGpuEnergy(bus_id);
+        m_settings.SaveGpuEnergy(bus_id, m_gpu_energy_base_kwh[slot] + m_gpu_session_kwh[slot]);
     }
-    
-    EvtClose(hResults);
-    return total_count;
 }
 
-void CCPUCoreBarsPlugin::UpdateWheaErrorCount()
+void CCPUCoreBarsPlugin::UpdateCpuUsage(CSampleSnapshot& snapshot)
 {
-    m_cached_whea_count = QueryEventLogCount(L"WHEA-Logger");
-    m_whea_error_count = m_cached_whea_count;
+    // 采样失败时统计窗口不变，窗口为空则沿用上一次的采样
+    if (m_cpu_sampler && m_cpu_sampler->Sample(m_sample_buffer.data(), m_num_cores)) {
+        m_core_stats.Add(m_sample_buffer.data());
+    }
+    m_core_stats.GetStats(snapshot.core_usage.data(), snapshot.core_peak.data(),
+        snapshot.core_p95.data(), m_sample_buffer.data());
 }
 
-void CCPUCoreBarsPlugin::UpdateNvlddmkmErrorCount()
+// 把设置中的错误来源和订阅方式交给采样线程，由它在下一次采样时重建读取器
+void CCPUCoreBarsPlugin::ApplyErrorSourceSettings()
 {
-    m_cached_nvlddmkm_count = QueryEventLogCount(L"nvlddmkm");
-    m_nvlddmkm_error_count = m_cached_nvlddmkm_count;
+    std::lock_guard<std::mutex> lock(m_error_config_mutex);
+    m_pending_error_providers = m_settings.error_providers;
+    m_pending_error_subscribe = m_settings.error_subscription;
+    m_error_config_dirty.store(true, std::memory_order_release);
 }
 
 extern "C" __declspec(dllexport) ITMPlugin* TMPluginGetInstance()
@@ -2,14 +2,37 @@
 #pragma once
 #include <windows.h>
 #include <vector>
-#include <Pdh.h>
+#include <memory>
+#include <atomic>
+#include <string>
+#include <mutex>
 // GDI+ headers must be included after windows.h
 #include <gdiplus.h> 
 #include "PluginInterface.h"
-#include "nvml.h"
+#include "CpuTopology.h"
+#include "GpuMonitor.h"
+#include "GpuPollWorker.h"
+#include "CpuSampler.h"
+#include "CoreHistory.h"
+#include "CoreRender.h"
+#include "SamplerThread.h"
+#include "PluginSettings.h"
+#include "EventLogReader.h"
+#include "EventWindow.h"
+#include "SystemErrorMonitor.h"
+#include "WheaRecords.h"
 
 using namespace Gdiplus;
 
+// =================================================================
+// 绘制缓存命中统计（只在主线程访问）
+// =================================================================
+struct CDrawCacheStats
+{
+    static unsigned long long hits;     // 状态未变，直接输出缓存位图
+    static unsigned long long misses;   // 状态变化，重新绘制
+};
+
 // =================================================================
 // CPU Core Item - 优化版本
 // =================================================================
@@ -29,9 +52,11 @@ public:
     void DrawItem(void* hDC, int x, int y, int w, int h, bool dark_mode) override;
 
     void SetUsage(double usage);
+    void SetPeak(double peak);
+    void SetHistory(const CCoreHistory* history) { m_history = history; }
+    void SetSparklineMode(bool enabled) { m_sparkline_mode = enabled; }
 
 private:
-    void DrawECoreSymbol(HDC hDC, const RECT& rect, bool dark_mode);
     
     // 新增：内联函数声明
     inline COLORREF CalculateBarColor() const;
@@ -39,20 +64,68 @@ private:
     // 原有成员变量
     int m_core_index;
     double m_usage = 0.0;
+    double m_peak = 0.0;        // 高频采样窗口内的峰值，用于绘制峰值刻度
     wchar_t m_item_name[32];
     wchar_t m_item_id[32];
     bool m_is_e_core;
-    
-    // 新增：静态字体缓存
-    static HFONT s_symbolFont;
-    static int s_fontRefCount;
-    
-    // 新增：GDI对象缓存
-    mutable HBRUSH m_cachedBgBrush;
-    mutable HBRUSH m_cachedBarBrush;
-    mutable COLORREF m_lastBgColor;
-    mutable COLORREF m_lastBarColor;
-    mutable bool m_lastDarkMode;
+
+    // 历史曲线模式
+    const CCoreHistory* m_history = nullptr;
+    bool m_sparkline_mode = false;
+    static const int SPARKLINE_WIDTH = 30;
+
+    // 条形图的离屏像素缓冲区，同时作为上一帧的缓存
+    CPixelCanvas m_canvas;
+
+    // 上一次绘制时的量化状态；相同则跳过光栅化
+    struct BarRenderState
+    {
+        int w, h;
+        int bar_height;
+        int peak_height;
+        COLORREF bar_color;
+        bool dark_mode;
+    };
+    BarRenderState m_last_state = {};
+    bool m_has_last_state = false;
+
+};
+
+
+// =================================================================
+// All-Cores Heatmap Item - 所有核心绘制在一个网格中
+// =================================================================
+class CCpuHeatmapItem : public IPluginItem
+{
+public:
+    // usage/e_core_flags 由插件持有，按核心索引连续排列
+    CCpuHeatmapItem(const double* usage, const BYTE* e_core_flags, int num_cores);
+    virtual ~CCpuHeatmapItem() = default;
+
+    const wchar_t* GetItemName() const override;
+    const wchar_t* GetItemId() const override;
+    const wchar_t* GetItemLableText() const override;
+    const wchar_t* GetItemValueText() const override;
+    const wchar_t* GetItemValueSampleText() const override;
+    bool IsCustomDraw() const override;
+    int GetItemWidth() const override;
+    void DrawItem(void* hDC, int x, int y, int w, int h, bool dark_mode) override;
+
+private:
+    // 在 w x h 内放下所有核心的最大单元格边长，行数随之确定
+
+    static const int NOMINAL_HEIGHT = 20;   // 计算宽度时假定的高度（96 DPI）
+    static const int NOMINAL_CELL = 4;
+
+    const double* m_usage;
+    const BYTE* m_e_core_flags;
+    int m_num_cores;
+
+    static const uint32_t s_light_levels[HEATMAP_COLOR_LEVELS];
+    static const uint32_t s_dark_levels[HEATMAP_COLOR_LEVELS];
+
+    // 整个网格画到离屏缓冲区后一次输出
+    CPixelCanvas m_canvas;
 };
 
 
@@ -62,7 +135,7 @@ private:
 class CNvidiaMonitorItem : public IPluginItem
 {
 public:
-    CNvidiaMonitorItem();
+    CNvidiaMonitorItem(const wchar_t* name, const wchar_t* id);
     virtual ~CNvidiaMonitorItem();
 
     const wchar_t* GetItemName() const override;
@@ -75,23 +148,111 @@ public:
     int GetItemWidth() const override;
     void DrawItem(void* hDC, int x, int y, int w, int h, bool dark_mode) override;
 
-    void SetValue(const wchar_t* value);
-    void SetSystemErrorStatus(bool has_error);
+    void SetReason(int reason);
+    void SetSystemErrorLevel(SystemErrorLevel level);
+    void SetHealth(GpuHealth health);
+
+    // 按间隔内降频时间占比着色；fraction < 0 表示没有违规计数
+    void SetViolationFraction(float fraction);
+    void SetColorByViolation(bool enable);
 
 private:
-    // 新增：内联函数声明
-    inline COLORREF CalculateTextColor(bool dark_mode) const;
     
     // 原有成员变量
+    wchar_t m_item_name[64];
+    wchar_t m_item_id[64];                  // 多 GPU 时按 PCI 总线号区分，设备顺序变化也不影响
     wchar_t m_value_text[128];
+    int m_reason = CLOCK_REASON_UNAVAILABLE;
+    float m_violation_fraction = -1.0f;
+    bool m_color_by_violation = false;
     int m_width = 100;
-    bool m_has_system_error = false;
+    SystemErrorLevel m_error_level = SYSTEM_ERROR_NONE;
+    GpuHealth m_health = GPU_HEALTH_OK;
     
     // 新增：Graphics对象缓存
     mutable Graphics* m_cachedGraphics;
     mutable HDC m_lastHdc;
 };
 
+// =================================================================
+// GPU 利用率项：显示间隔内的均值和最小/最大值，由主程序绘制占用图
+// =================================================================
+class CGpuUtilItem : public IPluginItem
+{
+public:
+    CGpuUtilItem(const wchar_t* name, const wchar_t* id);
+
+    const wchar_t* GetItemName() const override;
+    const wchar_t* GetItemId() const override;
+    const wchar_t* GetItemLableText() const override;
+    const wchar_t* GetItemValueText() const override;
+    const wchar_t* GetItemValueSampleText() const override;
+
+    int IsDrawResourceUsageGraph() const override;
+    float GetResourceUsageGraphValue() const override;
+
+    void SetUtilization(const CGpuUtilization& utilization);
+
+private:
+    wchar_t m_item_name[64];
+    wchar_t m_item_id[64];
+    wchar_t m_value_text[32];
+    float m_graph_value = 0.0f;
+};
+
+// =================================================================
+// GPU 功耗项：显示能耗计数求出的间隔平均功耗，占用图为功耗 / 生效的功耗上限
+// =================================================================
+class CGpuPowerItem : public IPluginItem
+{
+public:
+    CGpuPowerItem(const wchar_t* name, const wchar_t* id);
+
+    const wchar_t* GetItemName() const override;
+    const wchar_t* GetItemId() const override;
+    const wchar_t* GetItemLableText() const override;
+    const wchar_t* GetItemValueText() const override;
+    const wchar_t* GetItemValueSampleText() const override;
+
+    int IsDrawResourceUsageGraph() const override;
+    float GetResourceUsageGraphValue() const override;
+
+    // 小于 0 表示无效
+    void SetPower(float watts, float limit_watts);
+
+private:
+    wchar_t m_item_name[64];
+    wchar_t m_item_id[64];
+    wchar_t m_value_text[32];
+    float m_graph_value = 0.0f;
+};
+
+// =================================================================
+// GPU 显存项：已用 / 总量，可附带 BAR1 占用，占用图为显存占用率
+// =================================================================
+class CGpuMemoryItem : public IPluginItem
+{
+public:
+    CGpuMemoryItem(const wchar_t* name, const wchar_t* id);
+
+    const wchar_t* GetItemName() const override;
+    const wchar_t* GetItemId() const override;
+    const wchar_t* GetItemLableText() const override;
+    const wchar_t* GetItemValueText() const override;
+    const wchar_t* GetItemValueSampleText() const override;
+
+    int IsDrawResourceUsageGraph() const override;
+    float GetResourceUsageGraphValue() const override;
+
+    void SetMemory(const CGpuMemory& memory);
+
+private:
+    wchar_t m_item_name[64];
+    wchar_t m_item_id[64];
+    wchar_t m_value_text[48];
+    float m_graph_value = 0.0f;
+};
+
 // =================================================================
 // Temperature Item (for CPU and GPU) - With Custom Colors
 // =================================================================
@@ -99,7 +260,7 @@ class CTempMonitorItem : public IPluginItem
 {
 public:
     CTempMonitorItem(const wchar_t* name, const wchar_t* id, const wchar_t* label);
-    virtual ~CTempMonitorItem() = default;
+    virtual ~CTempMonitorItem();
 
     const wchar_t* GetItemName() const override;
     const wchar_t* GetItemId() const override;
@@ -116,13 +277,49 @@ public:
 
 private:
     COLORREF GetTemperatureColor() const;
+    void RenderToCache(HDC dc, int w, int h, bool dark_mode);
+    void ReleaseCache();
 
-    wchar_t m_item_name[32];
-    wchar_t m_item_id[32];
+    wchar_t m_item_name[64];
+    wchar_t m_item_id[64];
     wchar_t m_label[16];
     wchar_t m_value_text[32];
     int m_temp = 0;
     int m_width = 0;
+
+    // 绘制缓存：文本、尺寸、模式和字体都没变时直接 BitBlt
+    int m_text_id = 0;              // 文本每变化一次加一
+    HDC m_cache_dc = nullptr;
+    HBITMAP m_cache_bitmap = nullptr;
+    HGDIOBJ m_cache_old_bitmap = nullptr;
+    int m_cache_text_id = -1;
+    int m_cache_w = 0;
+    int m_cache_h = 0;
+    bool m_cache_dark_mode = false;
+    HGDIOBJ m_cache_font = nullptr;
+};
+
+
+// =================================================================
+// 采样快照：由采样线程写入，DataRequired 只读取最新一份
+// =================================================================
+struct CSampleSnapshot
+{
+    unsigned int sequence = 0;              // 每发布一次递增，0 表示还没有发布过
+    std::vector<double> core_usage;         // 按核心索引排列的使用率 (0~1)，高频模式下为窗口均值
+    std::vector<float> core_peak;           // 窗口内峰值
+    std::vector<float> core_p95;            // 窗口内 P95
+    std::vector<CGpuSample> gpus;           // 按 gpu_devices 顺序排列
+    std::vector<CGpuDeviceInfo> gpu_devices;    // 只在 gpu_generation 变化时重新复制
+    std::vector<double> gpu_energy_j;           // 本次运行以来各 GPU 的累计能耗，与 gpus 对应
+    unsigned int gpu_generation = 0;
+    NvmlState nvml_state = NVML_UNINITIALIZED;
+    SystemErrorLevel error_level = SYSTEM_ERROR_NONE;
+    DWORD error_counts[CPluginSettings::MAX_ERROR_PROVIDERS] = {};     // 按采样线程当前的来源列表排列
+    int error_provider_count = 0;
+    unsigned int whea_counts[WHEA_SEVERITY_COUNT] = {};              // 24 小时内按严重程度计数
+    CWheaRecord last_whea;                                          // 最新一条 WHEA 记录
+    bool has_whea_record = false;
 };
 
 
@@ -137,6 +334,13 @@ public:
     void DataRequired() override;
     const wchar_t* GetInfo(PluginInfoIndex index) override;
     void OnMonitorInfo(const ITMPlugin::MonitorInfo& monitor_info) override;
+    const wchar_t* GetTooltipInfo() override;
+    void OnExtenedInfo(ExtendedInfoIndex index, const wchar_t* data) override;
+
+    int GetCommandCount() override;
+    const wchar_t* GetCommandName(int command_index) override;
+    void OnPluginCommand(int command_index, void* hWnd, void* para) override;
+    int IsCommandChecked(int command_index) override;
 
 private:
     CCPUCoreBarsPlugin();
@@ -144,30 +348,61 @@ private:
     CCPUCoreBarsPlugin(const CCPUCoreBarsPlugin&) = delete;
     CCPUCoreBarsPlugin& operator=(const CCPUCoreBarsPlugin&) = delete;
     
+    enum PluginCommand
+    {
+        CMD_HIGH_FREQ_SAMPLING,
+        CMD_SPARKLINE_MODE,
+        CMD_GPU_COLOR_BY_VIOLATION,
+        CMD_ERROR_SUBSCRIPTION,
+        CMD_GPU_SHOW_BAR1,
+        CMD_COUNT
+    };
+
+    void ApplySettings();
+
+    // 采样线程上运行
+    void SampleTick();
+    void UpdateCpuUsage(CSampleSnapshot& snapshot);
+
     // 原有函数
-    void UpdateCpuUsage();
-    void DetectCoreTypes();
-    void InitNVML();
-    void ShutdownNVML();
-    void UpdateGpuLimitReason();
-    void UpdateWheaErrorCount();
-    void UpdateNvlddmkmErrorCount();
-    
-    // 新增：优化的事件日志查询函数
-    DWORD QueryEventLogCount(LPCWSTR provider_name);
+    void SyncGpuItems(const std::vector<CGpuDeviceInfo>& devices);
+    int AddGpuItems(unsigned int index, const char* pci_bus_id);     // pci_bus_id 为空表示占位项
+    void RemapGpuEnergy(const std::vector<CGpuDeviceInfo>& devices);
+    void SaveGpuEnergy();
+    void ApplyErrorSourceSettings();
 
     // 成员变量
     std::vector<IPluginItem*> m_all_items;
     int m_num_cores;
-    PDH_HQUERY m_query = nullptr;
-    std::vector<PDH_HCOUNTER> m_counters;
-    std::vector<BYTE> m_core_efficiency;
-    CNvidiaMonitorItem* m_gpu_item = nullptr;
-    bool m_nvml_initialized = false;
-    HMODULE m_nvml_dll = nullptr;
-    nvmlDevice_t m_nvml_device;
-    int m_whea_error_count = 0;
-    int m_nvlddmkm_error_count = 0;
+    std::unique_ptr<ICpuSampler> m_cpu_sampler;
+    CCpuTopology m_topology;
+
+    // 每个 GPU 一个状态项、一个温度项（温度来自 NVML）和一个利用率项
+    // 显示项按出现过的 GPU 排列（槽位），NVML 重新初始化后按 PCI 总线号重新对应，只增不删
+    // 放在堆上：轮询线程卡在驱动里被放弃时，监控对象随它一起泄漏，不在卸载插件时析构
+    std::unique_ptr<CGpuMonitor> m_gpu_monitor{ new CGpuMonitor() };
+    std::vector<CNvidiaMonitorItem*> m_gpu_items;
+    std::vector<CTempMonitorItem*> m_gpu_nvml_temp_items;
+    std::vector<CGpuUtilItem*> m_gpu_util_items;
+    std::vector<CGpuPowerItem*> m_gpu_power_items;
+    std::vector<CGpuMemoryItem*> m_gpu_memory_items;
+    std::vector<std::string> m_gpu_slot_bus_ids;
+    std::vector<int> m_gpu_device_slots;        // 当前设备下标 -> 槽位，仅主线程访问
+    unsigned int m_gpu_item_generation = 0;
+
+    // 能耗累计：配置文件中的历史值 + 本次运行的值，按槽位排列，仅主线程访问
+    std::vector<double> m_gpu_energy_base_kwh;  // 小于 0 表示还没从配置文件读取
+    std::vector<double> m_gpu_session_kwh;
+
+    // 最近一次轮询结果与对应的设备列表，仅采样线程访问
+    std::vector<CGpuSample> m_gpu_samples;
+    std::vector<CGpuDeviceInfo> m_gpu_devices;
+    unsigned int m_gpu_generation = 0;
+    NvmlState m_nvml_state = NVML_UNINITIALIZED;
+    std::vector<double> m_gpu_energy_j;         // 与 m_gpu_devices 对应，设备列表变化时按 PCI 总线号带过去
+    CGpuPollWorker m_gpu_worker;                // 所有轮询期间的 NVML 调用都在这个线程上
+    static const DWORD GPU_POLL_TIMEOUT_MS = 500;
+    static const DWORD GPU_STOP_TIMEOUT_MS = 2000;
 
     // 温度监控项
     CTempMonitorItem* m_cpu_temp_item = nullptr;
@@ -177,14 +412,38 @@ private:
 
     ULONG_PTR m_gdiplusToken;
 
-    decltype(nvmlInit_v2)* p_nvmlInit;
-    decltype(nvmlShutdown)* p_nvmlShutdown;
-    decltype(nvmlDeviceGetHandleByIndex_v2)* p_nvmlDeviceGetHandleByIndex;
-    decltype(nvmlDeviceGetCurrentClocksThrottleReasons)* p_nvmlDeviceGetCurrentClocksThrottleReasons;
-    
-    // 事件日志查询缓存和频率控制
-    DWORD m_cached_whea_count;
-    DWORD m_cached_nvlddmkm_count;
-    DWORD m_last_error_check_time;
-    static const DWORD ERROR_CHECK_INTERVAL_MS = 60000; // 60秒检查间隔
+
+    // 事件日志错误计数，仅采样线程访问
+    static const DWORD ERROR_WINDOW_MS = 86400000;      // 统计最近 24 小时
+    CSystemErrorMonitor m_error_monitor;
+
+    // 主线程提交的来源配置，采样线程在下一次检查时重建读取器
+    std::mutex m_error_config_mutex;
+    std::vector<std::wstring> m_pending_error_providers;
+    bool m_pending_error_subscribe = true;
+    std::atomic<bool> m_error_config_dirty{ false };
+
+    // 后台采样：采样线程写快照，主线程无锁读取
+    CTripleBuffer<CSampleSnapshot> m_snapshots;
+    CSamplerThread m_sampler_thread;
+    static const DWORD SAMPLE_INTERVAL_MS = 1000;
+
+    // 高频采样：DataRequired 每读取一次就递增 epoch，采样线程据此开始新的统计窗口
+    CPluginSettings m_settings;
+    CCoreStatsAggregator m_core_stats;
+    std::vector<double> m_sample_buffer;        // 最近一次采样，仅采样线程访问
+    std::atomic<unsigned int> m_consume_epoch{ 0 };
+    unsigned int m_stats_epoch = 0;
+    unsigned int m_snapshot_sequence = 0;       // 仅采样线程访问
+    ULONGLONG m_last_slow_tick = 0;
+    std::wstring m_tooltip_text;
+
+    // 每核心历史，仅在主线程（DataRequired）写入，每个快照只写入一次
+    CCoreHistory m_core_history;
+    unsigned int m_history_sequence = 0;
+
+    // 热力图项读取的连续数组，仅在主线程写入
+    std::vector<double> m_display_usage;
+    std::vector<BYTE> m_e_core_flags;
+    CCpuHeatmapItem* m_heatmap_item = nullptr;
 };
\ No newline at end of file
@@ -0,0 +1,27 @@
+﻿// CPUCoreBars/CircuitBreaker.cpp - 连续失败后按指数退避暂停调用（不依赖 Windows API）
+#include "CircuitBreaker.h"
+
+CCircuitBreaker::CCircuitBreaker(unsigned int failure_threshold, unsigned long long initial_backoff_ms, unsigned long long max_backoff_ms)
+    : m_failure_threshold(failure_threshold > 0 ? failure_threshold : 1),
+      m_initial_backoff_ms(initial_backoff_ms),
+      m_max_backoff_ms(max_backoff_ms),
+      m_backoff_ms(initial_backoff_ms)
+{
+}
+
+void CCircuitBreaker::RecordSuccess()
+{
+    m_failures = 0;
+    m_backoff_ms = m_initial_backoff_ms;
+    m_open_until = 0;
+}
+
+void CCircuitBreaker::RecordFailure(unsigned long long now)
+{
+    ++m_failures;
+    if (m_failures < m_failure_threshold) return;
+
+    // 断开后每次试探失败都让退避时间加倍
+    m_open_until = now + m_backoff_ms;
+    m_backoff_ms = (m_backoff_ms * 2 < m_max_backoff_ms) ? m_backoff_ms * 2 : m_max_backoff_ms;
+}
@@ -0,0 +1,27 @@
+// CPUCoreBars/CircuitBreaker.h - 连续失败后按指数退避暂停调用（不依赖 Windows API）
+#pragma once
+
+// =================================================================
+// 熔断器：连续失败达到阈值后断开，退避期间不再发起调用
+// 退避结束后放行一次试探，再失败则退避时间加倍，成功则完全恢复
+// 时间单位为毫秒，由调用方提供（通常是 GetTickCount64）
+// =================================================================
+class CCircuitBreaker
+{
+public:
+    explicit CCircuitBreaker(unsigned int failure_threshold = 3,
+        unsigned long long initial_backoff_ms = 2000, unsigned long long max_backoff_ms = 300000);
+
+    bool AllowRequest(unsigned long long now) const { return now >= m_open_until; }
+    void RecordSuccess();
+    void RecordFailure(unsigned long long now);
+
+private:
+    unsigned int m_failure_threshold;
+    unsigned long long m_initial_backoff_ms;
+    unsigned long long m_max_backoff_ms;
+
+    unsigned int m_failures = 0;
+    unsigned long long m_backoff_ms;
+    unsigned long long m_open_until = 0;
+};
@@ -0,0 +1,46 @@
+﻿// CPUCoreBars/CoreHistory.cpp - 每核心使用率历史（结构数组环形缓冲区）
+#include "CoreHistory.h"
+#include <algorithm>
+
+void CCoreHistory::Init(int num_cores)
+{
+    m_num_cores = num_cores;
+    m_samples.assign(static_cast<size_t>(num_cores) * CAPACITY, 0);
+    m_head = 0;
+    m_size = 0;
+}
+
+void CCoreHistory::Push(const double* usage)
+{
+    uint8_t* row = m_samples.data() + static_cast<size_t>(m_head) * m_num_cores;
+    for (int i = 0; i < m_num_cores; ++i) {
+        row[i] = static_cast<uint8_t>(usage[i] * 255.0 + 0.5);
+    }
+    m_head = (m_head + 1) % CAPACITY;
+    if (m_size < CAPACITY) ++m_size;
+}
+
+void RenderSparkline(const CCoreHistory& history, int core, CPixelCanvas& canvas, uint32_t color)
+{
+    int w = canvas.GetWidth();
+    int h = canvas.GetHeight();
+    int count = history.GetSize();
+    if (w <= 0 || h < 2 || count < 1) return;
+
+    // 第 c 列（从右数）覆盖 age 为 [first, last) 的样本；样本不多于列数时每列一个
+    int columns = std::min(w, count);
+    for (int c = 0; c < columns; ++c) {
+        int first = c * count / columns;
+        int last = (c + 1) * count / columns;
+        int lo = 255, hi = 0;
+        for (int age = (c > 0 ? first - 1 : first); age < last; ++age) {
+            int value = history.Get(core, age);
+            lo = std::min(lo, value);
+            hi = std::max(hi, value);
+        }
+        int x = w - 1 - c;
+        int top = h - 1 - hi * (h - 1) / 255;
+        int bottom = h - 1 - lo * (h - 1) / 255;
+        canvas.FillRect(x, top, x + 1, bottom + 1, color);
+    }
+}
@@ -0,0 +1,41 @@
+// CPUCoreBars/CoreHistory.h - 每核心使用率历史（结构数组环形缓冲区）
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include "PixelCanvas.h"
+
+// =================================================================
+// 同一 tick 的所有核心样本连续存放，量化为 uint8_t（0~255）
+// 256 核 x 120 个样本 = 30 KB
+// =================================================================
+class CCoreHistory
+{
+public:
+    static const int CAPACITY = 120;
+
+    void Init(int num_cores);
+
+    // 追加一个 tick：usage[0, num_cores)
+    void Push(const double* usage);
+
+    int GetSize() const { return m_size; }
+
+    // age = 0 为最新样本
+    uint8_t Get(int core, int age) const
+    {
+        int slot = m_head - 1 - age;
+        if (slot < 0) slot += CAPACITY;
+        return m_samples[static_cast<size_t>(slot) * m_num_cores + core];
+    }
+
+private:
+    std::vector<uint8_t> m_samples;     // [槽位 * num_cores + 核心]
+    int m_num_cores = 0;
+    int m_head = 0;                     // 下一次写入的槽位
+    int m_size = 0;
+};
+
+// 把 core 的全部历史压缩进画布宽度，最新样本在最右侧，画布高度对应 0~255
+// 样本多于列数时每列画出它覆盖的样本的最小~最大值，并与右侧一列相连
+void RenderSparkline(const CCoreHistory& history, int core, CPixelCanvas& canvas, uint32_t color);
@@ -0,0 +1,70 @@
+﻿// CPUCoreBars/CoreRender.cpp - 核心条形图与热力图的光栅化（与平台无关）
+#include "CoreRender.h"
+#include <algorithm>
+
+const uint8_t E_CORE_GLYPH[E_CORE_GLYPH_SIZE] = {
+    0b01110,
+    0b11011,
+    0b01110,
+    0b00100,
+    0b01000,
+};
+
+void DrawECoreGlyph(CPixelCanvas& canvas, uint32_t color)
+{
+    canvas.DrawMask((canvas.GetWidth() - E_CORE_GLYPH_SIZE) / 2, (canvas.GetHeight() - E_CORE_GLYPH_SIZE) / 2,
+        E_CORE_GLYPH, E_CORE_GLYPH_SIZE, E_CORE_GLYPH_SIZE, color);
+}
+
+void RenderCoreBar(CPixelCanvas& canvas, int bar_height, int peak_height, uint32_t background, uint32_t bar_color)
+{
+    int w = canvas.GetWidth();
+    int h = canvas.GetHeight();
+    canvas.Clear(background);
+    if (bar_height > 0) {
+        canvas.FillRect(0, h - bar_height, w, h, bar_color);
+    }
+    if (peak_height > 0) {
+        canvas.FillRect(0, h - peak_height, w, h - peak_height + 1, bar_color);
+    }
+}
+
+void CalculateHeatmapLayout(int num_cores, int w, int h, int& cell, int& rows)
+{
+    for (cell = (std::min)(w, h); cell > 1; --cell) {
+        rows = h / cell;
+        int cols = (num_cores + rows - 1) / rows;
+        if (cols * cell <= w) return;
+    }
+    cell = 1;
+    rows = (std::max)(1, h);
+}
+
+void RenderHeatmap(CPixelCanvas& canvas, const double* usage, const uint8_t* e_core_flags, int num_cores,
+    const uint32_t* levels, uint32_t background, uint32_t border)
+{
+    int w = canvas.GetWidth();
+    int h = canvas.GetHeight();
+    canvas.Clear(background);
+    if (num_cores <= 0 || w <= 0 || h <= 0) return;
+
+    int cell = 0, rows = 0;
+    CalculateHeatmapLayout(num_cores, w, h, cell, rows);
+    int gap = (cell >= 4) ? 1 : 0;
+
+    // 按列填充：相邻核心（通常是同一物理核心的超线程）上下相邻
+    for (int i = 0; i < num_cores; ++i) {
+        int col = i / rows;
+        int row = i % rows;
+        if ((col + 1) * cell > w) break;    // 空间不足时不画出界
+        int left = col * cell, top = row * cell;
+        int right = left + cell - gap, bottom = top + cell - gap;
+        int level = static_cast<int>(usage[i] * (HEATMAP_COLOR_LEVELS - 1) + 0.5);
+        level = (std::max)(0, (std::min)(HEATMAP_COLOR_LEVELS - 1, level));
+        canvas.FillRect(left, top, right, bottom, levels[level]);
+        // E-Core 用边框标记，代替逐个绘制符号文本
+        if (e_core_flags[i] && cell - gap >= 3) {
+            canvas.FrameRect(left, top, right, bottom, border);
+        }
+    }
+}
@@ -0,0 +1,30 @@
+// CPUCoreBars/CoreRender.h - 核心条形图与热力图的光栅化（与平台无关）
+#pragma once
+#include <cstdint>
+#include "PixelCanvas.h"
+
+// =================================================================
+// 只写入 CPixelCanvas，由调用方负责输出到 DC；颜色均为 0x00RRGGBB
+// =================================================================
+
+// 5x5 三叶草点阵，对应原来的 U+2618 符号
+const int E_CORE_GLYPH_SIZE = 5;
+extern const uint8_t E_CORE_GLYPH[E_CORE_GLYPH_SIZE];
+
+// E-Core 标记画在画布中央
+void DrawECoreGlyph(CPixelCanvas& canvas, uint32_t color);
+
+// 从底部向上填充 bar_height 行；peak_height > 0 时在该高度画 1 像素的峰值刻度
+void RenderCoreBar(CPixelCanvas& canvas, int bar_height, int peak_height, uint32_t background, uint32_t bar_color);
+
+// =================================================================
+// 热力图：每个核心一个方格，按列填充，usage 量化到 levels[0, level_count)
+// =================================================================
+const int HEATMAP_COLOR_LEVELS = 8;
+
+// 在 w x h 内放下 num_cores 个方格的最大边长，以及每列的方格数
+void CalculateHeatmapLayout(int num_cores, int w, int h, int& cell, int& rows);
+
+// e_core_flags[i] 非 0 时该方格加 border 颜色的边框
+void RenderHeatmap(CPixelCanvas& canvas, const double* usage, const uint8_t* e_core_flags, int num_cores,
+    const uint32_t* levels, uint32_t background, uint32_t border);
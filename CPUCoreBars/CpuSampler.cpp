@@ -0,0 +1,85 @@
+﻿// CPUCoreBars/CpuSampler.cpp - CPU 使用率采样后端
+#include "CpuSampler.h"
+#include <algorithm>
+#ifdef _WIN32
+#include "PdhSampler.h"
+#else
+#include "LinuxProcStatSampler.h"
+#endif
+
+std::unique_ptr<ICpuSampler> CreateCpuSampler(const CCpuTopology& topology, int num_cores)
+{
+#ifdef _WIN32
+    // 优先使用单个通配符计数器，每次采样只需一次数组读取
+    auto array_sampler = std::make_unique<CPdhArraySampler>(topology);
+    if (array_sampler->Init()) return array_sampler;
+
+    auto counter_sampler = std::make_unique<CPdhCounterSampler>();
+    if (counter_sampler->Init(num_cores)) return counter_sampler;
+    return nullptr;
+#else
+    (void)topology;
+    auto proc_stat_sampler = std::make_unique<CLinuxProcStatSampler>();
+    if (proc_stat_sampler->Init(num_cores)) return proc_stat_sampler;
+    return nullptr;
+#endif
+}
+
+// =================================================================
+// CCoreStatsAggregator implementation
+// =================================================================
+void CCoreStatsAggregator::Init(int num_cores)
+{
+    m_num_cores = num_cores;
+    m_sum.assign(num_cores, 0.0);
+    m_max.assign(num_cores, 0.0f);
+    m_hist.assign(static_cast<size_t>(num_cores) * HIST_BINS, 0);
+    m_sample_count = 0;
+}
+
+void CCoreStatsAggregator::Reset()
+{
+    if (m_sample_count == 0) return;
+    std::fill(m_sum.begin(), m_sum.end(), 0.0);
+    std::fill(m_max.begin(), m_max.end(), 0.0f);
+    std::fill(m_hist.begin(), m_hist.end(), static_cast<uint16_t>(0));
+    m_sample_count = 0;
+}
+
+void CCoreStatsAggregator::Add(const double* usage)
+{
+    bool count_hist = (m_sample_count < MAX_HIST_SAMPLES);
+    uint16_t* hist = m_hist.data();
+    for (int i = 0; i < m_num_cores; ++i, hist += HIST_BINS) {
+        double value = usage[i];
+        m_sum[i] += value;
+        if (value > m_max[i]) m_max[i] = static_cast<float>(value);
+        if (count_hist) hist[static_cast<int>(value * (HIST_BINS - 1) + 0.5)]++;
+    }
+    ++m_sample_count;
+}
+
+void CCoreStatsAggregator::GetStats(double* mean, float* peak, float* p95, const double* fallback) const
+{
+    if (m_sample_count == 0) {
+        for (int i = 0; i < m_num_cores; ++i) {
+            mean[i] = fallback[i];
+            peak[i] = p95[i] = static_cast<float>(fallback[i]);
+        }
+        return;
+    }
+
+    int hist_samples = min(m_sample_count, static_cast<int>(MAX_HIST_SAMPLES));
+    int rank = (hist_samples * 95 + 99) / 100;      // ceil(0.95 * n)
+    const uint16_t* hist = m_hist.data();
+    for (int i = 0; i < m_num_cores; ++i, hist += HIST_BINS) {
+        mean[i] = m_sum[i] / m_sample_count;
+        peak[i] = m_max[i];
+        int bin = 0;
+        for (int seen = 0; bin < HIST_BINS - 1; ++bin) {
+            seen += hist[bin];
+            if (seen >= rank) break;
+        }
+        p95[i] = min(peak[i], static_cast<float>(bin) / (HIST_BINS - 1));
+    }
+}
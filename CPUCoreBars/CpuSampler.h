@@ -0,0 +1,45 @@
+// CPUCoreBars/CpuSampler.h - CPU 使用率采样后端
+#pragma once
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include "CpuTopology.h"
+
+// =================================================================
+// CPU 采样后端接口
+// =================================================================
+class ICpuSampler
+{
+public:
+    virtual ~ICpuSampler() = default;
+
+    // 采样一次，把每个逻辑处理器的使用率 (0~1) 写入 usage[0, num_cores)
+    virtual bool Sample(double* usage, int num_cores) = 0;
+};
+
+// 按系统能力选择后端（Windows 上为 PDH，Linux 上为 /proc/stat），失败时返回 nullptr
+std::unique_ptr<ICpuSampler> CreateCpuSampler(const CCpuTopology& topology, int num_cores);
+
+// =================================================================
+// 高频采样统计：两次读取之间每个核心的均值/峰值/P95，运行期不分配内存
+// =================================================================
+class CCoreStatsAggregator
+{
+public:
+    void Init(int num_cores);
+    void Reset();
+    void Add(const double* usage);
+
+    // 输出当前窗口的统计；窗口内还没有样本时输出 fallback
+    void GetStats(double* mean, float* peak, float* p95, const double* fallback) const;
+
+private:
+    static const int HIST_BINS = 21;                // 5% 一档，用于估算 P95
+    static const int MAX_HIST_SAMPLES = 0xFFFF;     // uint16_t 计数上限
+
+    int m_num_cores = 0;
+    int m_sample_count = 0;
+    std::vector<double> m_sum;
+    std::vector<float> m_max;
+    std::vector<uint16_t> m_hist;                   // [核心 * HIST_BINS + 档位]
+};
@@ -0,0 +1,143 @@
+﻿// CPUCoreBars/CpuTopology.cpp - 跨处理器组的逻辑处理器拓扑
+#include "CpuTopology.h"
+#include <cstddef>
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+namespace
+{
+    int CountBits(KAFFINITY mask)
+    {
+        int count = 0;
+        while (mask) {
+            mask &= mask - 1;
+            ++count;
+        }
+        return count;
+    }
+
+    // 剩余部分至少能放下 Relationship 和 Size 时才读取下一条记录，之后的零头忽略
+    bool HasRecordHeader(const BYTE* ptr, const BYTE* end)
+    {
+        return static_cast<size_t>(end - ptr) >= sizeof(LOGICAL_PROCESSOR_RELATIONSHIP) + sizeof(DWORD);
+    }
+
+    // 记录中的组数不能让后面的数组超出记录本身
+    bool IsRecordConsistent(const SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX* info)
+    {
+        size_t header = 0, count = 0, element = 0;
+        if (info->Relationship == RelationGroup) {
+            header = offsetof(SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX, Group) + offsetof(GROUP_RELATIONSHIP, GroupInfo);
+            if (info->Size < header) return false;
+            count = info->Group.ActiveGroupCount;
+            element = sizeof(PROCESSOR_GROUP_INFO);
+        } else if (info->Relationship == RelationProcessorCore) {
+            header = offsetof(SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX, Processor) + offsetof(PROCESSOR_RELATIONSHIP, GroupMask);
+            if (info->Size < header) return false;
+            count = info->Processor.GroupCount;
+            element = sizeof(GROUP_AFFINITY);
+        }
+        return header + count * element <= info->Size;
+    }
+}
+
+bool CCpuTopology::Detect()
+{
+#ifdef _WIN32
+    DWORD length = 0;
+    GetLogicalProcessorInformationEx(RelationAll, nullptr, &length);
+    if (GetLastError() != ERROR_INSUFFICIENT_BUFFER) return false;
+
+    std::vector<BYTE> buffer(length);
+    if (!GetLogicalProcessorInformationEx(RelationAll, (PSYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX)buffer.data(), &length)) return false;
+    return LoadFromBuffer(buffer.data(), length);
+#else
+    // Linux 的 CPU 编号本身就是全局连续的，按每组 64 个排成等价的处理器组
+    long count = sysconf(_SC_NPROCESSORS_CONF);
+    if (count <= 0) return false;
+    const int GROUP_SIZE = static_cast<int>(sizeof(KAFFINITY) * 8);
+    m_groups.clear();
+    for (int offset = 0; offset < count; offset += GROUP_SIZE) {
+        int size = min(GROUP_SIZE, static_cast<int>(count) - offset);
+        KAFFINITY mask = (size == GROUP_SIZE) ? ~static_cast<KAFFINITY>(0) : ((static_cast<KAFFINITY>(1) << size) - 1);
+        m_groups.push_back({ offset, mask });
+    }
+    m_count = static_cast<int>(count);
+    m_efficiency.assign(m_count, 0);
+    m_max_efficiency = 0;
+    return true;
+#endif
+}
+
+bool CCpuTopology::LoadFromBuffer(const BYTE* data, DWORD length)
+{
+    m_groups.clear();
+    m_efficiency.clear();
+    m_max_efficiency = 0;
+    m_count = 0;
+
+    // 第一遍：处理器组 -> 全局索引起点，同时检查每条记录的大小，第二遍不再重复
+    const BYTE* end = data + length;
+    const BYTE* ptr = data;
+    while (HasRecordHeader(ptr, end)) {
+        auto info = (const SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX*)ptr;
+        if (info->Size == 0 || info->Size > static_cast<size_t>(end - ptr) || !IsRecordConsistent(info)) return false;
+        if (info->Relationship == RelationGroup) {
+            for (WORD g = 0; g < info->Group.ActiveGroupCount; ++g) {
+                KAFFINITY mask = info->Group.GroupInfo[g].ActiveProcessorMask;
+                m_groups.push_back({ m_count, mask });
+                m_count += CountBits(mask);
+            }
+        }
+        ptr += info->Size;
+    }
+    if (m_count == 0) return false;
+
+    // 第二遍：每个物理核心的能效等级写到它所有逻辑处理器上（组号来自 GroupMask[i].Group）
+    m_efficiency.assign(m_count, 0);
+    ptr = data;
+    while (HasRecordHeader(ptr, end)) {
+        auto info = (const SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX*)ptr;
+        if (info->Relationship == RelationProcessorCore) {
+            BYTE efficiency = info->Processor.EfficiencyClass;
+            m_max_efficiency = max(m_max_efficiency, efficiency);
+            for (WORD i = 0; i < info->Processor.GroupCount; ++i) {
+                const GROUP_AFFINITY& affinity = info->Processor.GroupMask[i];
+                for (int j = 0; j < static_cast<int>(sizeof(KAFFINITY) * 8); ++j) {
+                    if ((affinity.Mask >> j) & 1) {
+                        int index = GetGlobalIndex(affinity.Group, static_cast<BYTE>(j));
+                        if (index >= 0) m_efficiency[index] = efficiency;
+                    }
+                }
+            }
+        }
+        ptr += info->Size;
+    }
+    return true;
+}
+
+void CCpuTopology::LoadSingleGroup(int count)
+{
+    count = max(1, min(count, static_cast<int>(sizeof(KAFFINITY) * 8)));
+    KAFFINITY mask = (count == sizeof(KAFFINITY) * 8) ? ~static_cast<KAFFINITY>(0) : ((static_cast<KAFFINITY>(1) << count) - 1);
+    m_groups.assign(1, { 0, mask });
+    m_efficiency.assign(count, 0);
+    m_max_efficiency = 0;
+    m_count = count;
+}
+
+int CCpuTopology::GetGlobalIndex(WORD group, BYTE number) const
+{
+    if (group >= m_groups.size() || number >= sizeof(KAFFINITY) * 8) return -1;
+    const GroupInfo& info = m_groups[group];
+    KAFFINITY bit = static_cast<KAFFINITY>(1) << number;
+    if (!(info.active_mask & bit)) return -1;
+    return info.offset + CountBits(info.active_mask & (bit - 1));
+}
+
+bool CCpuTopology::IsEfficiencyCore(int index) const
+{
+    if (index < 0 || index >= m_count) return false;
+    return m_efficiency[index] < m_max_efficiency;
+}
@@ -0,0 +1,42 @@
+// CPUCoreBars/CpuTopology.h - 跨处理器组的逻辑处理器拓扑
+#pragma once
+#include "Platform.h"
+#include <vector>
+
+// =================================================================
+// CPU 拓扑：为每个逻辑处理器分配跨处理器组稳定的全局索引
+// 全局索引 = 所在组的起始偏移 + 该处理器在组活动掩码中的序号
+// =================================================================
+class CCpuTopology
+{
+public:
+    // 从系统读取拓扑（Windows 上为 GetLogicalProcessorInformationEx(RelationAll)，Linux 上按 CPU 编号每 64 个一组）
+    bool Detect();
+
+    // 解析 SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX 序列
+    // Detect 也走这条路径，因此可以直接喂入录制或合成的数据（如 256/512 核布局）
+    bool LoadFromBuffer(const BYTE* data, DWORD length);
+
+    // 无法读取拓扑时的后备：单个处理器组，全部视为同一能效等级
+    void LoadSingleGroup(int count);
+
+    int GetCount() const { return m_count; }
+
+    // (组, 组内编号) -> 全局索引，无效时返回 -1
+    int GetGlobalIndex(WORD group, BYTE number) const;
+
+    // 仅在混合架构（存在多个能效等级）上才区分 E-Core
+    bool IsEfficiencyCore(int index) const;
+
+private:
+    struct GroupInfo
+    {
+        int offset;
+        KAFFINITY active_mask;
+    };
+
+    std::vector<GroupInfo> m_groups;
+    std::vector<BYTE> m_efficiency;     // 按全局索引排列的 EfficiencyClass
+    BYTE m_max_efficiency = 0;
+    int m_count = 0;
+};
@@ -0,0 +1,274 @@
+﻿// CPUCoreBars/EventLogReader.cpp - 增量读取 Windows 事件日志
+#include "EventLogReader.h"
+
+#pragma comment(lib, "wevtapi.lib")
+
+namespace
+{
+    enum RenderField
+    {
+        FIELD_PROVIDER,
+        FIELD_TIME,
+        FIELD_EVENT_ID,
+        FIELD_LEVEL,
+        FIELD_COUNT
+    };
+
+    LPCWSTR s_render_paths[FIELD_COUNT] = {
+        L"Event/System/Provider/@Name",
+        L"Event/System/TimeCreated/@SystemTime",
+        L"Event/System/EventID",
+        L"Event/System/Level",
+    };
+
+    enum WheaField
+    {
+        WHEA_FIELD_SOURCE,
+        WHEA_FIELD_TYPE,
+        WHEA_FIELD_APIC_ID,
+        WHEA_FIELD_SEGMENT,
+        WHEA_FIELD_BUS,
+        WHEA_FIELD_DEVICE,
+        WHEA_FIELD_FUNCTION,
+        WHEA_FIELD_COUNT
+    };
+
+    LPCWSTR s_whea_paths[WHEA_FIELD_COUNT] = {
+        L"Event/EventData/Data[@Name='ErrorSource']",
+        L"Event/EventData/Data[@Name='ErrorType']",
+        L"Event/EventData/Data[@Name='ApicId']",
+        L"Event/EventData/Data[@Name='Segment']",
+        L"Event/EventData/Data[@Name='Bus']",
+        L"Event/EventData/Data[@Name='Device']",
+        L"Event/EventData/Data[@Name='Function']",
+    };
+
+    // 事件数据里的整数可能以不同宽度或十六进制类型出现
+    bool ReadUInt(const EVT_VARIANT& value, unsigned int& result)
+    {
+        switch (value.Type) {
+        case EvtVarTypeByte: result = value.ByteVal; return true;
+        case EvtVarTypeUInt16: result = value.UInt16Val; return true;
+        case EvtVarTypeUInt32:
+        case EvtVarTypeHexInt32: result = value.UInt32Val; return true;
+        case EvtVarTypeUInt64:
+        case EvtVarTypeHexInt64: result = static_cast<unsigned int>(value.UInt64Val); return true;
+        default: return false;
+        }
+    }
+
+    // 所有来源合并成一条 XPath，日志只扫描一遍
+    std::wstring BuildQuery(const std::vector<std::wstring>& providers, DWORD lookback_ms)
+    {
+        std::wstring query = L"*[System[(";
+        for (size_t i = 0; i < providers.size(); ++i) {
+            if (i > 0) query += L" or ";
+            query += L"Provider[@Name='";
+            query += providers[i];
+            query += L"']";
+        }
+        wchar_t tail[128];
+        swprintf_s(tail, L") and (Level=1 or Level=2 or Level=3) and TimeCreated[timediff(@SystemTime) <= %lu]]]", lookback_ms);
+        query += tail;
+        return query;
+    }
+}
+
+std::unique_ptr<IEventLogReader> CreateEventLogReader(const wchar_t* channel, const std::vector<std::wstring>& providers, DWORD lookback_ms, bool subscribe)
+{
+    if (providers.empty()) return nullptr;
+    if (subscribe) {
+        std::unique_ptr<CEvtSubscriptionReader> reader(new CEvtSubscriptionReader());
+        if (reader->Subscribe(channel, providers, lookback_ms)) return std::move(reader);
+    }
+    return std::unique_ptr<IEventLogReader>(new CEvtBookmarkReader(channel, providers, lookback_ms));
+}
+
+// =================================================================
+// CEventRenderer
+// =================================================================
+CEventRenderer::~CEventRenderer()
+{
+    if (m_whea_context) EvtClose(m_whea_context);
+    if (m_context) EvtClose(m_context);
+}
+
+bool CEventRenderer::Init(const std::vector<std::wstring>& providers)
+{
+    m_providers = providers;
+    m_buffer.resize(512);
+    m_context = EvtCreateRenderContext(FIELD_COUNT, s_render_paths, EvtRenderContextValues);
+
+    for (size_t i = 0; i < m_providers.size(); ++i) {
+        if (_wcsicmp(m_providers[i].c_str(), WHEA_PROVIDER_NAME) == 0) m_whea_provider = static_cast<int>(i);
+    }
+    if (m_whea_provider >= 0) {
+        m_whea_buffer.resize(512);
+        m_whea_context = EvtCreateRenderContext(WHEA_FIELD_COUNT, s_whea_paths, EvtRenderContextValues);
+    }
+    return m_context != nullptr;
+}
+
+bool CEventRenderer::Render(EVT_HANDLE event, CLogEvent& result)
+{
+    if (!m_context) return false;
+    DWORD used = 0, count = 0;
+    if (!EvtRender(m_context, event, EvtRenderEventValues, static_cast<DWORD>(m_buffer.size()), m_buffer.data(), &used, &count)) {
+        if (GetLastError() != ERROR_INSUFFICIENT_BUFFER) return false;
+        m_buffer.resize(used);
+        if (!EvtRender(m_context, event, EvtRenderEventValues, static_cast<DWORD>(m_buffer.size()), m_buffer.data(), &used, &count)) return false;
+    }
+    if (count < FIELD_COUNT) return false;
+
+    const EVT_VARIANT* values = reinterpret_cast<const EVT_VARIANT*>(m_buffer.data());
+    if (values[FIELD_PROVIDER].Type != EvtVarTypeString || values[FIELD_TIME].Type != EvtVarTypeFileTime) return false;
+    result.provider = -1;
+    for (size_t i = 0; i < m_providers.size(); ++i) {
+        if (_wcsicmp(values[FIELD_PROVIDER].StringVal, m_providers[i].c_str()) == 0) {
+            result.provider = static_cast<int>(i);
+            break;
+        }
+    }
+    if (result.provider < 0) return false;
+    result.time = values[FIELD_TIME].FileTimeVal;
+    result.count = 1;
+    result.event_id = (values[FIELD_EVENT_ID].Type == EvtVarTypeUInt16) ? values[FIELD_EVENT_ID].UInt16Val : 0;
+    result.level = (values[FIELD_LEVEL].Type == EvtVarTypeByte) ? values[FIELD_LEVEL].ByteVal : 0;
+    result.has_whea = false;
+    if (result.provider == m_whea_provider) RenderWhea(event, result);
+    return true;
+}
+
+void CEventRenderer::RenderWhea(EVT_HANDLE event, CLogEvent& result)
+{
+    CWheaRecord& record = result.whea;
+    record = CWheaRecord();
+    record.time = result.time;
+    record.event_id = result.event_id;
+    record.severity = static_cast<unsigned char>(ClassifyWheaEvent(result.event_id, result.level));
+    result.has_whea = true;
+    if (!m_whea_context) return;
+
+    DWORD used = 0, count = 0;
+    if (!EvtRender(m_whea_context, event, EvtRenderEventValues, static_cast<DWORD>(m_whea_buffer.size()), m_whea_buffer.data(), &used, &count)) {
+        if (GetLastError() != ERROR_INSUFFICIENT_BUFFER) return;
+        m_whea_buffer.resize(used);
+        if (!EvtRender(m_whea_context, event, EvtRenderEventValues, static_cast<DWORD>(m_whea_buffer.size()), m_whea_buffer.data(), &used, &count)) return;
+    }
+    if (count < WHEA_FIELD_COUNT) return;
+
+    // 不存在的字段渲染为 EvtVarTypeNull，对应成员保持“无效”
+    const EVT_VARIANT* values = reinterpret_cast<const EVT_VARIANT*>(m_whea_buffer.data());
+    unsigned int value = 0;
+    if (ReadUInt(values[WHEA_FIELD_SOURCE], value)) record.source = static_cast<unsigned char>(value);
+    if (ReadUInt(values[WHEA_FIELD_TYPE], value)) record.error_type = static_cast<unsigned short>(value);
+    if (ReadUInt(values[WHEA_FIELD_APIC_ID], value)) record.apic_id = value;
+    if (ReadUInt(values[WHEA_FIELD_BUS], value)) {
+        record.pci_bus = static_cast<unsigned char>(value);
+        if (ReadUInt(values[WHEA_FIELD_SEGMENT], value)) record.pci_segment = static_cast<unsigned short>(value);
+        if (ReadUInt(values[WHEA_FIELD_DEVICE], value)) record.pci_device = static_cast<unsigned char>(value);
+        if (ReadUInt(values[WHEA_FIELD_FUNCTION], value)) record.pci_function = static_cast<unsigned char>(value);
+    }
+}
+
+// =================================================================
+// CEvtBookmarkReader
+// =================================================================
+CEvtBookmarkReader::CEvtBookmarkReader(const wchar_t* channel, const std::vector<std::wstring>& providers, DWORD lookback_ms)
+    : m_channel(channel), m_query(BuildQuery(providers, lookback_ms))
+{
+    m_bookmark = EvtCreateBookmark(nullptr);
+    m_renderer.Init(providers);
+}
+
+CEvtBookmarkReader::~CEvtBookmarkReader()
+{
+    if (m_bookmark) EvtClose(m_bookmark);
+}
+
+EVT_HANDLE CEvtBookmarkReader::OpenResults(bool& skip_first)
+{
+    skip_first = false;
+    EVT_HANDLE results = EvtQuery(nullptr, m_channel.c_str(), m_query.c_str(), EvtQueryChannelPath | EvtQueryForwardDirection);
+    if (!results || !m_has_bookmark) return results;
+
+    // 定位到书签所在的事件，它本身已经计过数
+    if (EvtSeek(results, 0, m_bookmark, 0, EvtSeekRelativeToBookmark | EvtSeekStrict)) {
+        skip_first = true;
+        return results;
+    }
+
+    // 书签对应的记录已被覆盖或移出查询范围，重新查询并按时间过滤
+    EvtClose(results);
+    return EvtQuery(nullptr, m_channel.c_str(), m_query.c_str(), EvtQueryChannelPath | EvtQueryForwardDirection);
+}
+
+bool CEvtBookmarkReader::ReadNewEvents(const std::function<void(const CLogEvent&)>& on_event)
+{
+    if (!m_bookmark) return false;
+
+    bool skip_first = false;
+    bool filter_by_time = m_has_bookmark;
+    EVT_HANDLE results = OpenResults(skip_first);
+    if (!results) return false;
+    if (skip_first) filter_by_time = false;
+
+    EVT_HANDLE events[64];
+    DWORD returned = 0;
+    while (EvtNext(results, ARRAYSIZE(events), events, 1000, 0, &returned)) {
+        for (DWORD i = 0; i < returned; ++i) {
+            if (skip_first) {
+                skip_first = false;
+            } else {
+                CLogEvent event;
+                if (m_renderer.Render(events[i], event) && (!filter_by_time || event.time > m_last_time)) {
+                    on_event(event);
+                    m_last_time = max(m_last_time, event.time);
+                }
+            }
+            // 书签只需要指向本批最后一条
+            if (i + 1 == returned && EvtUpdateBookmark(m_bookmark, events[i])) m_has_bookmark = true;
+            EvtClose(events[i]);
+        }
+    }
+    EvtClose(results);
+    return true;
+}
+
+// =================================================================
+// CEvtSubscriptionReader
+// =================================================================
+CEvtSubscriptionReader::~CEvtSubscriptionReader()
+{
+    // 关闭订阅会等待正在执行的回调返回
+    if (m_subscription) EvtClose(m_subscription);
+}
+
+bool CEvtSubscriptionReader::Subscribe(const wchar_t* channel, const std::vector<std::wstring>& providers, DWORD lookback_ms)
+{
+    if (!m_renderer.Init(providers)) return false;
+    std::wstring query = BuildQuery(providers, lookback_ms);
+    m_subscription = EvtSubscribe(nullptr, nullptr, channel, query.c_str(), nullptr, this, OnEvent, EvtSubscribeStartAtOldestRecord);
+    return m_subscription != nullptr;
+}
+
+DWORD WINAPI CEvtSubscriptionReader::OnEvent(EVT_SUBSCRIBE_NOTIFY_ACTION action, PVOID context, EVT_HANDLE event)
+{
+    auto self = static_cast<CEvtSubscriptionReader*>(context);
+    if (action == EvtSubscribeActionError) {
+        // 此时 event 是 Win32 错误码；订阅不会自己恢复，交给采样线程重建
+        self->m_failed.store(true, std::memory_order_release);
+        return ERROR_SUCCESS;
+    }
+    if (action != EvtSubscribeActionDeliver) return ERROR_SUCCESS;
+    CLogEvent log_event;
+    if (self->m_renderer.Render(event, log_event)) self->m_inbox.Post(log_event);
+    return ERROR_SUCCESS;
+}
+
+bool CEvtSubscriptionReader::ReadNewEvents(const std::function<void(const CLogEvent&)>& on_event)
+{
+    // 出错前已经到达的事件照常取走
+    m_inbox.Drain(on_event);
+    return !m_failed.load(std::memory_order_acquire);
+}
@@ -0,0 +1,92 @@
+// CPUCoreBars/EventLogReader.h - 增量读取 Windows 事件日志
+#pragma once
+#include <windows.h>
+#include <winevt.h>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+#include "LogEventSource.h"
+#include "EventWindow.h"
+
+// 一条 XPath 覆盖所有来源，只统计警告及以上级别
+// 首次读取回溯 lookback_ms 内的事件，之后从书签处继续
+// subscribe 为 true 时优先使用 EvtSubscribe 推送订阅，失败时退回书签轮询
+std::unique_ptr<IEventLogReader> CreateEventLogReader(const wchar_t* channel, const std::vector<std::wstring>& providers, DWORD lookback_ms, bool subscribe);
+
+// =================================================================
+// 预编译的渲染上下文：只取 Provider/@Name、TimeCreated、EventID 和 Level
+// WHEA 事件再用第二个上下文取错误来源、APIC ID 和 PCI 地址
+// =================================================================
+class CEventRenderer
+{
+public:
+    CEventRenderer() = default;
+    ~CEventRenderer();
+    CEventRenderer(const CEventRenderer&) = delete;
+    CEventRenderer& operator=(const CEventRenderer&) = delete;
+
+    bool Init(const std::vector<std::wstring>& providers);
+    bool Render(EVT_HANDLE event, CLogEvent& result);
+
+private:
+    void RenderWhea(EVT_HANDLE event, CLogEvent& result);
+
+    EVT_HANDLE m_context = nullptr;
+    EVT_HANDLE m_whea_context = nullptr;
+    int m_whea_provider = -1;
+    std::vector<std::wstring> m_providers;
+    std::vector<BYTE> m_buffer;         // 复用的渲染缓冲区
+    std::vector<BYTE> m_whea_buffer;
+};
+
+// =================================================================
+// Windows 实现：EvtQuery + 书签，读取结束时把书签更新到最后一条事件
+// =================================================================
+class CEvtBookmarkReader : public IEventLogReader
+{
+public:
+    CEvtBookmarkReader(const wchar_t* channel, const std::vector<std::wstring>& providers, DWORD lookback_ms);
+    ~CEvtBookmarkReader();
+    CEvtBookmarkReader(const CEvtBookmarkReader&) = delete;
+    CEvtBookmarkReader& operator=(const CEvtBookmarkReader&) = delete;
+
+    bool ReadNewEvents(const std::function<void(const CLogEvent&)>& on_event) override;
+
+private:
+    EVT_HANDLE OpenResults(bool& skip_first);
+
+    std::wstring m_channel;
+    std::wstring m_query;
+    EVT_HANDLE m_bookmark = nullptr;
+    CEventRenderer m_renderer;
+    bool m_has_bookmark = false;
+    ULONGLONG m_last_time = 0;          // 书签失效时据此跳过已经计过的事件
+};
+
+// =================================================================
+// Windows 实现：EvtSubscribe 推送订阅，回调线程把事件投进收件箱
+// 订阅报告错误（例如日志服务重启）后 ReadNewEvents 返回 false，由调用方重建
+// =================================================================
+class CEvtSubscriptionReader : public IEventLogReader
+{
+public:
+    CEvtSubscriptionReader() = default;
+    ~CEvtSubscriptionReader();
+    CEvtSubscriptionReader(const CEvtSubscriptionReader&) = delete;
+    CEvtSubscriptionReader& operator=(const CEvtSubscriptionReader&) = delete;
+
+    // 先投递 lookback_ms 内已有的事件，再持续接收新事件
+    bool Subscribe(const wchar_t* channel, const std::vector<std::wstring>& providers, DWORD lookback_ms);
+
+    bool ReadNewEvents(const std::function<void(const CLogEvent&)>& on_event) override;
+    bool IsPushBased() const override { return true; }
+
+private:
+    static DWORD WINAPI OnEvent(EVT_SUBSCRIBE_NOTIFY_ACTION action, PVOID context, EVT_HANDLE event);
+
+    EVT_HANDLE m_subscription = nullptr;
+    CEventRenderer m_renderer;          // 仅回调线程访问（同一订阅的回调不会并发）
+    CEventInbox<CLogEvent> m_inbox;
+    std::atomic<bool> m_failed{ false };
+};
@@ -0,0 +1,47 @@
+﻿// CPUCoreBars/EventWindow.cpp - 按时间分桶的滑动窗口事件计数（不依赖 Windows API）
+#include "EventWindow.h"
+
+void CEventWindowCounter::Add(unsigned long long time, unsigned int count)
+{
+    unsigned long long bucket = time / BUCKET_LENGTH;
+    if (bucket > m_newest_bucket) Advance(time);
+    if (bucket + BUCKET_COUNT <= m_newest_bucket) return;
+
+    int slot = static_cast<int>(bucket % BUCKET_COUNT);
+    if (m_bucket_ids[slot] != bucket) {
+        m_total -= m_counts[slot];
+        m_counts[slot] = 0;
+        m_bucket_ids[slot] = bucket;
+    }
+    m_counts[slot] += count;
+    m_total += count;
+}
+
+void CEventWindowCounter::Advance(unsigned long long now)
+{
+    unsigned long long bucket = now / BUCKET_LENGTH;
+    if (bucket <= m_newest_bucket) return;
+
+    // 只需要清理新进入窗口的槽位，跨度超过整个窗口时全部清空
+    unsigned long long steps = bucket - m_newest_bucket;
+    if (steps >= BUCKET_COUNT) {
+        Reset();
+    } else {
+        for (unsigned long long b = m_newest_bucket + 1; b <= bucket; ++b) {
+            int slot = static_cast<int>(b % BUCKET_COUNT);
+            m_total -= m_counts[slot];
+            m_counts[slot] = 0;
+            m_bucket_ids[slot] = b;
+        }
+    }
+    m_newest_bucket = bucket;
+}
+
+void CEventWindowCounter::Reset()
+{
+    for (int i = 0; i < BUCKET_COUNT; ++i) {
+        m_counts[i] = 0;
+        m_bucket_ids[i] = 0;
+    }
+    m_total = 0;
+}
@@ -0,0 +1,83 @@
+// CPUCoreBars/EventWindow.h - 按时间分桶的滑动窗口事件计数（不依赖 Windows API）
+#pragma once
+#include <mutex>
+#include <vector>
+
+// =================================================================
+// 滑动窗口计数：窗口切成固定数量的时间桶，过期时整桶清零
+// 时间单位与 FILETIME 相同（100ns），也可以使用任意单调的整数时间
+// =================================================================
+class CEventWindowCounter
+{
+public:
+    static const int BUCKET_COUNT = 96;
+    static const unsigned long long BUCKET_LENGTH = 15ull * 60 * 10000000;     // 15 分钟，96 个桶共 24 小时
+
+    // 事件时间早于窗口时直接丢弃
+    void Add(unsigned long long time, unsigned int count = 1);
+
+    // 把窗口推进到 now，清掉过期的桶；每个桶最多清一次
+    void Advance(unsigned long long now);
+
+    unsigned int GetCount() const { return m_total; }
+    void Reset();
+
+private:
+    unsigned int m_counts[BUCKET_COUNT] = {};
+    unsigned long long m_bucket_ids[BUCKET_COUNT] = {};    // 每个槽位当前对应的桶编号（时间 / 桶长）
+    unsigned long long m_newest_bucket = 0;
+    unsigned int m_total = 0;
+};
+
+// =================================================================
+// 累计计数器求差：硬件只提供单调递增的总数时，用差值喂给滑动窗口
+// 首次读取只记录基准；计数变小（驱动重载或计数器清零）时重新取基准
+// =================================================================
+class CCounterDelta
+{
+public:
+    unsigned long long Update(unsigned long long value)
+    {
+        unsigned long long delta = (m_valid && value >= m_last) ? value - m_last : 0;
+        m_last = value;
+        m_valid = true;
+        return delta;
+    }
+
+    void Reset() { m_valid = false; }
+
+private:
+    unsigned long long m_last = 0;
+    bool m_valid = false;
+};
+
+// =================================================================
+// 事件收件箱：推送线程随时投递，消费线程批量取走
+// =================================================================
+template <typename T>
+class CEventInbox
+{
+public:
+    void Post(const T& event)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_pending.push_back(event);
+    }
+
+    // 按投递顺序回调并清空，回调在锁外执行
+    template <typename F>
+    void Drain(F on_event)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_draining.swap(m_pending);
+        }
+        for (const T& event : m_draining) on_event(event);
+        m_draining.clear();
+    }
+
+private:
+    std::mutex m_mutex;
+    std::vector<T> m_pending;
+    std::vector<T> m_draining;      // 仅消费线程访问，与 m_pending 交换以复用内存
+};
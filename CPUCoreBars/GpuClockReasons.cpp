@@ -0,0 +1,140 @@
+﻿// CPUCoreBars/GpuClockReasons.cpp - GPU 时钟事件（降频）原因解码与持续时间统计
+#include "GpuClockReasons.h"
+#include "nvml.h"
+
+namespace
+{
+    constexpr CClockEventReason s_reasons[CLOCK_REASON_COUNT] = {
+        { nvmlClocksThrottleReasonHwThermalSlowdown,    90, GPU_REASON_CRITICAL, RGB(217, 66, 53),  L"热降", L"硬件过热降频" },
+        { nvmlClocksThrottleReasonHwPowerBrakeSlowdown, 80, GPU_REASON_CRITICAL, RGB(217, 66, 53),  L"制动", L"外部功耗制动" },
+        { nvmlClocksThrottleReasonHwSlowdown,           70, GPU_REASON_CRITICAL, RGB(217, 66, 53),  L"硬降", L"硬件降频" },
+        { nvmlClocksEventReasonSwThermalSlowdown,       60, GPU_REASON_WARNING,  RGB(217, 66, 53),  L"温控", L"软件温控降频" },
+        { nvmlClocksEventReasonSwPowerCap,              50, GPU_REASON_WARNING,  RGB(246, 182, 78), L"功耗", L"功耗墙" },
+        { nvmlClocksEventReasonSyncBoost,               40, GPU_REASON_NOTICE,   RGB(246, 182, 78), L"同步", L"同步加速组限制" },
+        { nvmlClocksEventReasonDisplayClockSetting,     30, GPU_REASON_NOTICE,   CLR_INVALID,       L"显示", L"显示时钟设置" },
+        { nvmlClocksEventReasonGpuIdle,                 20, GPU_REASON_INFO,     CLR_INVALID,       L"空闲", L"空闲" },
+        { nvmlClocksEventReasonApplicationsClocksSetting, 10, GPU_REASON_INFO,   CLR_INVALID,       L"无限", L"应用时钟设置" },
+    };
+
+    constexpr bool IsSortedByPriority()
+    {
+        for (int i = 1; i < CLOCK_REASON_COUNT; ++i) {
+            if (s_reasons[i - 1].priority <= s_reasons[i].priority) return false;
+        }
+        return true;
+    }
+
+    constexpr bool CoversAllReasons()
+    {
+        unsigned long long covered = 0;
+        for (int i = 0; i < CLOCK_REASON_COUNT; ++i) {
+            if (covered & s_reasons[i].bit) return false;
+            covered |= s_reasons[i].bit;
+        }
+        return covered == nvmlClocksEventReasonAll;
+    }
+
+    constexpr bool SameText(const wchar_t* a, const wchar_t* b)
+    {
+        while (*a && *a == *b) {
+            ++a;
+            ++b;
+        }
+        return *a == *b;
+    }
+
+    // 显示项只有两个字的空间，不同原因的简称必须能区分
+    constexpr bool HasDistinctShortTexts()
+    {
+        for (int i = 0; i < CLOCK_REASON_COUNT; ++i) {
+            for (int j = i + 1; j < CLOCK_REASON_COUNT; ++j) {
+                if (SameText(s_reasons[i].short_text, s_reasons[j].short_text)) return false;
+            }
+        }
+        return true;
+    }
+
+    static_assert(IsSortedByPriority(), "s_reasons 必须按优先级从高到低排列");
+    static_assert(CoversAllReasons(), "s_reasons 必须覆盖所有 nvmlClocksEventReason 位且不重复");
+    static_assert(HasDistinctShortTexts(), "s_reasons 的简称不能重复");
+}
+
+const CClockEventReason& GetClockEventReason(int index)
+{
+    return s_reasons[index];
+}
+
+int DecodeClockEventReasons(unsigned long long reasons)
+{
+    for (int i = 0; i < CLOCK_REASON_COUNT; ++i) {
+        if (reasons & s_reasons[i].bit) return i;
+    }
+    return CLOCK_REASON_NONE;
+}
+
+WORD CompactClockEventReasons(unsigned long long reasons)
+{
+    WORD compact = 0;
+    for (int i = 0; i < CLOCK_REASON_COUNT; ++i) {
+        if (reasons & s_reasons[i].bit) compact |= static_cast<WORD>(1 << i);
+    }
+    return compact;
+}
+
+const wchar_t* GetClockReasonText(int reason)
+{
+    switch (reason) {
+    case CLOCK_REASON_UNAVAILABLE: return L"N/A";
+    case CLOCK_REASON_ERROR: return L"错误";
+    case CLOCK_REASON_NONE: return L"无";
+    default: return s_reasons[reason].short_text;
+    }
+}
+
+COLORREF GetClockReasonColor(int reason, bool dark_mode)
+{
+    COLORREF color = (reason >= 0) ? s_reasons[reason].color : CLR_INVALID;
+    if (color == CLR_INVALID) color = dark_mode ? RGB(255, 255, 255) : RGB(0, 0, 0);
+    return color;
+}
+
+// =================================================================
+// CClockReasonTimer
+// =================================================================
+CClockReasonTimer::CClockReasonTimer()
+    : m_slots(CAPACITY)
+{
+}
+
+void CClockReasonTimer::Add(WORD compact_reasons, DWORD elapsed_ms)
+{
+    if (m_size == CAPACITY) PopOldest();
+    Slot& slot = m_slots[(m_head + m_size) % CAPACITY];
+    slot.reasons = compact_reasons;
+    slot.elapsed_ms = elapsed_ms;
+    ++m_size;
+
+    m_total_ms += elapsed_ms;
+    for (int i = 0; i < CLOCK_REASON_COUNT; ++i) {
+        if (compact_reasons & (1 << i)) m_reason_ms[i] += elapsed_ms;
+    }
+    // 至少保留最新一项
+    while (m_size > 1 && m_total_ms - m_slots[m_head].elapsed_ms >= WINDOW_MS) PopOldest();
+}
+
+void CClockReasonTimer::PopOldest()
+{
+    const Slot& slot = m_slots[m_head];
+    m_total_ms -= slot.elapsed_ms;
+    for (int i = 0; i < CLOCK_REASON_COUNT; ++i) {
+        if (slot.reasons & (1 << i)) m_reason_ms[i] -= slot.elapsed_ms;
+    }
+    m_head = (m_head + 1) % CAPACITY;
+    --m_size;
+}
+
+float CClockReasonTimer::GetFraction(int reason) const
+{
+    if (m_total_ms == 0 || reason < 0 || reason >= CLOCK_REASON_COUNT) return 0.0f;
+    return static_cast<float>(static_cast<double>(m_reason_ms[reason]) / m_total_ms);
+}
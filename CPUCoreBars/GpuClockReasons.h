@@ -0,0 +1,77 @@
+// CPUCoreBars/GpuClockReasons.h - GPU 时钟事件（降频）原因解码与持续时间统计
+#pragma once
+#include "Platform.h"
+#include <vector>
+
+// =================================================================
+// 解码表：每个 nvmlClocksEventReason* 位对应一项，按优先级从高到低排列
+// =================================================================
+enum GpuReasonSeverity
+{
+    GPU_REASON_INFO,
+    GPU_REASON_NOTICE,
+    GPU_REASON_WARNING,
+    GPU_REASON_CRITICAL
+};
+
+struct CClockEventReason
+{
+    unsigned long long bit;
+    int priority;                   // 多个原因同时存在时显示优先级最高的
+    GpuReasonSeverity severity;
+    COLORREF color;                 // CLR_INVALID 表示使用默认文字颜色
+    const wchar_t* short_text;      // 状态项上显示的文本
+    const wchar_t* name;            // 提示信息中的完整名称
+};
+
+static const int CLOCK_REASON_COUNT = 9;
+
+// 解码结果中的特殊值（非负值为解码表下标）
+static const int CLOCK_REASON_UNAVAILABLE = -1;    // 尚未查询或无 NVML
+static const int CLOCK_REASON_ERROR = -2;          // 查询失败
+static const int CLOCK_REASON_NONE = -3;           // 没有任何原因位
+
+const CClockEventReason& GetClockEventReason(int index);
+
+// 返回优先级最高的原因下标，没有时返回 CLOCK_REASON_NONE
+int DecodeClockEventReasons(unsigned long long reasons);
+
+// 把原因位转换成按解码表下标排列的紧凑掩码
+WORD CompactClockEventReasons(unsigned long long reasons);
+
+const wchar_t* GetClockReasonText(int reason);
+COLORREF GetClockReasonColor(int reason, bool dark_mode);
+
+// =================================================================
+// 各原因在最近一段时间内的累计时长（按实际间隔加权）
+// =================================================================
+class CClockReasonTimer
+{
+public:
+    CClockReasonTimer();
+
+    void Add(WORD compact_reasons, DWORD elapsed_ms);
+
+    // 窗口内处于该原因的时间占比 (0~1)
+    float GetFraction(int reason) const;
+    DWORD GetWindowMs() const { return static_cast<DWORD>(m_total_ms); }
+
+    static const DWORD WINDOW_MS = 10 * 60 * 1000;
+
+private:
+    struct Slot
+    {
+        WORD reasons;
+        DWORD elapsed_ms;
+    };
+
+    static const int CAPACITY = 720;    // 慢速采样约每秒一次，足够覆盖 10 分钟
+
+    void PopOldest();
+
+    std::vector<Slot> m_slots;
+    int m_head = 0;     // 最旧的一项
+    int m_size = 0;
+    unsigned long long m_reason_ms[CLOCK_REASON_COUNT] = {};
+    unsigned long long m_total_ms = 0;
+};
@@ -0,0 +1,657 @@
+﻿// CPUCoreBars/GpuMonitor.cpp - NVIDIA GPU 监控（运行时加载 nvml.dll / libnvidia-ml.so）
+#include "GpuMonitor.h"
+#include <algorithm>
+#ifndef _WIN32
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#endif
+
+namespace
+{
+    // GpuTelemetryField -> NVML 字段 ID
+    const unsigned int s_field_ids[GPU_FIELD_COUNT] = {
+        NVML_FI_DEV_POWER_INSTANT,
+        NVML_FI_DEV_POWER_CURRENT_LIMIT,
+        NVML_FI_DEV_TOTAL_ENERGY_CONSUMPTION,
+        NVML_FI_DEV_MEMORY_TEMP,
+        NVML_FI_DEV_TEMPERATURE_SLOWDOWN_TLIMIT,
+    };
+
+    // nvmlPerfPolicyType_t -> NVML 字段 ID；字段的时间戳对应 nvmlViolationTime_t::referenceTime
+    const unsigned int s_violation_field_ids[GPU_VIOLATION_COUNT] = {
+        NVML_FI_DEV_PERF_POLICY_POWER,
+        NVML_FI_DEV_PERF_POLICY_THERMAL,
+        NVML_FI_DEV_PERF_POLICY_SYNC_BOOST,
+        NVML_FI_DEV_PERF_POLICY_BOARD_LIMIT,
+        NVML_FI_DEV_PERF_POLICY_LOW_UTILIZATION,
+        NVML_FI_DEV_PERF_POLICY_RELIABILITY,
+    };
+
+    const nvmlSamplingType_t s_sampling_types[GPU_UTIL_COUNT] = {
+        NVML_GPU_UTILIZATION_SAMPLES,
+        NVML_MEMORY_UTILIZATION_SAMPLES,
+        NVML_ENC_UTILIZATION_SAMPLES,
+        NVML_DEC_UTILIZATION_SAMPLES,
+    };
+
+    // 各类采样的驱动缓冲区大小可能不同，按较大的值分配
+    const unsigned int MIN_SAMPLE_BUFFER = 256;
+
+    bool DecodeFieldValue(const nvmlFieldValue_t& field, unsigned long long& value)
+    {
+        if (field.nvmlReturn != NVML_SUCCESS) return false;
+        switch (field.valueType) {
+        case NVML_VALUE_TYPE_DOUBLE: value = field.value.dVal > 0 ? static_cast<unsigned long long>(field.value.dVal) : 0; return true;
+        case NVML_VALUE_TYPE_UNSIGNED_INT: value = field.value.uiVal; return true;
+        case NVML_VALUE_TYPE_UNSIGNED_LONG: value = field.value.ulVal; return true;
+        case NVML_VALUE_TYPE_UNSIGNED_LONG_LONG: value = field.value.ullVal; return true;
+        case NVML_VALUE_TYPE_SIGNED_LONG_LONG: value = field.value.sllVal > 0 ? field.value.sllVal : 0; return true;
+        case NVML_VALUE_TYPE_SIGNED_INT: value = field.value.siVal > 0 ? field.value.siVal : 0; return true;
+        case NVML_VALUE_TYPE_UNSIGNED_SHORT: value = field.value.usVal; return true;
+        default: return false;
+        }
+    }
+
+    // 进程名（不含路径），取不到时为 "?"
+    void GetProcessName(unsigned int pid, wchar_t (&name)[32])
+    {
+        wcscpy_s(name, L"?");
+#ifdef _WIN32
+        HANDLE process = OpenProcess(PROCESS_QUERY_LIMITED_INFORMATION, FALSE, pid);
+        if (!process) return;
+        wchar_t path[MAX_PATH];
+        DWORD length = MAX_PATH;
+        if (QueryFullProcessImageNameW(process, 0, path, &length)) {
+            const wchar_t* file_name = wcsrchr(path, L'\\');
+            wcsncpy_s(name, file_name ? file_name + 1 : path, _TRUNCATE);
+        }
+        CloseHandle(process);
+#else
+        char path[64];
+        sprintf_s(path, "/proc/%u/comm", pid);
+        FILE* file = fopen(path, "r");
+        if (!file) return;
+        char comm[32] = {};
+        if (fgets(comm, sizeof(comm), file)) {
+            comm[strcspn(comm, "\n")] = '\0';
+            wchar_t wide[32];
+            size_t length = mbstowcs(wide, comm, ARRAYSIZE(wide) - 1);
+            if (length != static_cast<size_t>(-1) && length > 0) wcsncpy_s(name, wide, length);
+        }
+        fclose(file);
+#endif
+    }
+}
+
+#ifdef _WIN32
+const wchar_t* const CGpuMonitor::DEFAULT_LIBRARY = L"nvml.dll";
+#else
+const wchar_t* const CGpuMonitor::DEFAULT_LIBRARY = L"libnvidia-ml.so.1";
+#endif
+
+CGpuMonitor::~CGpuMonitor()
+{
+    Shutdown();
+}
+
+bool CGpuMonitor::Init()
+{
+    m_nvml_dll = LoadLibraryW(m_library_path.c_str());
+    if (!m_nvml_dll) return false;
+
+    p_nvmlInit = (decltype(p_nvmlInit))GetProcAddress(m_nvml_dll, "nvmlInit_v2");
+    p_nvmlShutdown = (decltype(p_nvmlShutdown))GetProcAddress(m_nvml_dll, "nvmlShutdown");
+    p_nvmlDeviceGetCount = (decltype(p_nvmlDeviceGetCount))GetProcAddress(m_nvml_dll, "nvmlDeviceGetCount_v2");
+    p_nvmlDeviceGetHandleByIndex = (decltype(p_nvmlDeviceGetHandleByIndex))GetProcAddress(m_nvml_dll, "nvmlDeviceGetHandleByIndex_v2");
+    p_nvmlDeviceGetUUID = (decltype(p_nvmlDeviceGetUUID))GetProcAddress(m_nvml_dll, "nvmlDeviceGetUUID");
+    p_nvmlDeviceGetPciInfo = (decltype(p_nvmlDeviceGetPciInfo))GetProcAddress(m_nvml_dll, "nvmlDeviceGetPciInfo_v3");
+    // 旧驱动只有已弃用的 ThrottleReasons 版本，两者签名和位定义相同
+    p_nvmlDeviceGetCurrentClocksEventReasons = (decltype(p_nvmlDeviceGetCurrentClocksEventReasons))GetProcAddress(m_nvml_dll, "nvmlDeviceGetCurrentClocksEventReasons");
+    if (!p_nvmlDeviceGetCurrentClocksEventReasons) {
+        p_nvmlDeviceGetCurrentClocksEventReasons = (decltype(p_nvmlDeviceGetCurrentClocksEventReasons))GetProcAddress(m_nvml_dll, "nvmlDeviceGetCurrentClocksThrottleReasons");
+    }
+    p_nvmlDeviceGetTemperature = (decltype(p_nvmlDeviceGetTemperature))GetProcAddress(m_nvml_dll, "nvmlDeviceGetTemperature");
+    p_nvmlDeviceGetFieldValues = (decltype(p_nvmlDeviceGetFieldValues))GetProcAddress(m_nvml_dll, "nvmlDeviceGetFieldValues");
+    p_nvmlDeviceGetViolationStatus = (decltype(p_nvmlDeviceGetViolationStatus))GetProcAddress(m_nvml_dll, "nvmlDeviceGetViolationStatus");
+    p_nvmlDeviceGetSamples = (decltype(p_nvmlDeviceGetSamples))GetProcAddress(m_nvml_dll, "nvmlDeviceGetSamples");
+    p_nvmlDeviceGetMemoryInfo = (decltype(p_nvmlDeviceGetMemoryInfo))GetProcAddress(m_nvml_dll, "nvmlDeviceGetMemoryInfo_v2");
+    p_nvmlDeviceGetBAR1MemoryInfo = (decltype(p_nvmlDeviceGetBAR1MemoryInfo))GetProcAddress(m_nvml_dll, "nvmlDeviceGetBAR1MemoryInfo");
+    p_nvmlDeviceGetComputeRunningProcesses = (decltype(p_nvmlDeviceGetComputeRunningProcesses))GetProcAddress(m_nvml_dll, "nvmlDeviceGetComputeRunningProcesses_v3");
+    p_nvmlDeviceGetGraphicsRunningProcesses = (decltype(p_nvmlDeviceGetGraphicsRunningProcesses))GetProcAddress(m_nvml_dll, "nvmlDeviceGetGraphicsRunningProcesses_v3");
+    p_nvmlDeviceGetSupportedEventTypes = (decltype(p_nvmlDeviceGetSupportedEventTypes))GetProcAddress(m_nvml_dll, "nvmlDeviceGetSupportedEventTypes");
+    p_nvmlEventSetCreate = (decltype(p_nvmlEventSetCreate))GetProcAddress(m_nvml_dll, "nvmlEventSetCreate");
+    p_nvmlDeviceRegisterEvents = (decltype(p_nvmlDeviceRegisterEvents))GetProcAddress(m_nvml_dll, "nvmlDeviceRegisterEvents");
+    p_nvmlEventSetWait = (decltype(p_nvmlEventSetWait))GetProcAddress(m_nvml_dll, "nvmlEventSetWait_v2");
+    p_nvmlEventSetFree = (decltype(p_nvmlEventSetFree))GetProcAddress(m_nvml_dll, "nvmlEventSetFree");
+
+    if (!p_nvmlInit || !p_nvmlShutdown || !p_nvmlDeviceGetCount || !p_nvmlDeviceGetHandleByIndex
+        || !p_nvmlDeviceGetCurrentClocksEventReasons) {
+        Shutdown();
+        return false;
+    }
+    if (p_nvmlInit() != NVML_SUCCESS) {
+        Shutdown();
+        return false;
+    }
+    m_initialized = true;
+
+    unsigned int count = 0;
+    if (p_nvmlDeviceGetCount(&count) != NVML_SUCCESS) count = 0;
+    for (unsigned int i = 0; i < count; ++i) {
+        CGpuDeviceInfo info = {};
+        if (p_nvmlDeviceGetHandleByIndex(i, &info.handle) != NVML_SUCCESS) continue;
+        info.index = i;
+
+        nvmlPciInfo_t pci = {};
+        if (p_nvmlDeviceGetPciInfo && p_nvmlDeviceGetPciInfo(info.handle, &pci) == NVML_SUCCESS) {
+            strcpy_s(info.pci_bus_id, pci.busId);
+        } else {
+            sprintf_s(info.pci_bus_id, "index%u", i);
+        }
+        if (!p_nvmlDeviceGetUUID || p_nvmlDeviceGetUUID(info.handle, info.uuid, sizeof(info.uuid)) != NVML_SUCCESS) {
+            info.uuid[0] = '\0';
+        }
+        m_devices.push_back(info);
+    }
+    if (m_devices.empty()) {
+        Shutdown();
+        return false;
+    }
+    m_reason_timers.assign(m_devices.size(), CClockReasonTimer());
+    m_violation_counters.assign(m_devices.size(), ViolationCounter());
+    m_utilization_states.assign(m_devices.size(), UtilizationState());
+    m_energy_states.assign(m_devices.size(), EnergyState());
+    m_lost_breakers.assign(m_devices.size(), CCircuitBreaker(1));
+    m_xid_counts.reset(new std::atomic<unsigned int>[m_devices.size()]);
+    m_last_xid.reset(new std::atomic<unsigned int>[m_devices.size()]);
+    for (size_t i = 0; i < m_devices.size(); ++i) {
+        m_xid_counts[i].store(0, std::memory_order_relaxed);
+        m_last_xid[i].store(0, std::memory_order_relaxed);
+        // 同一块卡的原因窗口、违规计数基准、掉卡退避和 Xid 计数接着上一次初始化
+        for (const CarriedState& carried : m_carried) {
+            if (strcmp(carried.pci_bus_id, m_devices[i].pci_bus_id) != 0) continue;
+            m_reason_timers[i] = carried.reason_timer;
+            m_violation_counters[i] = carried.violation;
+            m_lost_breakers[i] = carried.lost_breaker;
+            m_xid_counts[i].store(carried.xid_count, std::memory_order_relaxed);
+            m_last_xid[i].store(carried.last_xid, std::memory_order_relaxed);
+            break;
+        }
+    }
+    m_state = NVML_READY;
+    m_ready_tick = GetTickCount64();
+    ++m_generation;
+    return true;
+}
+
+void CGpuMonitor::Shutdown()
+{
+    // 放弃后 NVML 和 Xid 监听线程都可能还在使用，什么都不释放
+    if (m_abandoned) return;
+    StopXidListener();
+    if (m_initialized && p_nvmlShutdown) {
+        p_nvmlShutdown();
+    }
+    if (m_nvml_dll) {
+        FreeLibrary(m_nvml_dll);
+    }
+    m_initialized = false;
+    m_nvml_dll = nullptr;
+    m_devices.clear();
+    m_reason_timers.clear();
+    m_violation_counters.clear();
+    m_utilization_states.clear();
+    m_energy_states.clear();
+    m_lost_breakers.clear();
+    m_last_poll_tick = 0;
+}
+
+void CGpuMonitor::SetLibraryPath(const wchar_t* path)
+{
+    std::lock_guard<std::mutex> lock(m_path_mutex);
+    m_pending_path = (path && *path) ? path : DEFAULT_LIBRARY;
+    m_path_dirty.store(true, std::memory_order_release);
+}
+
+bool CGpuMonitor::Maintain()
+{
+    // 换了库文件就立即重新初始化，不受退避限制
+    if (m_path_dirty.load(std::memory_order_relaxed) && m_path_dirty.exchange(false, std::memory_order_acquire)) {
+        std::lock_guard<std::mutex> lock(m_path_mutex);
+        if (m_pending_path != m_library_path) {
+            m_library_path = m_pending_path;
+            m_state = NVML_REINITIALIZING;
+            m_reinit_breaker.RecordSuccess();
+        }
+    }
+    if (m_state == NVML_READY || m_abandoned) return false;
+    ULONGLONG now = GetTickCount64();
+    if (!m_reinit_breaker.AllowRequest(now)) return false;
+
+    // 旧句柄在驱动重置后全部失效，整体卸载后重新枚举；显示项由插件按 PCI 总线号重新对应
+    // 每次尝试都先计入退避：初始化成功但设备随即再次丢失时也不会每秒重建一次
+    m_state = NVML_REINITIALIZING;
+    m_reinit_breaker.RecordFailure(now);
+    bool restart_xid = m_xid_requested;
+    SaveCarriedState();
+    Shutdown();
+    if (!Init()) {
+        m_state = m_generation > 0 ? NVML_LOST : NVML_UNINITIALIZED;
+        return false;
+    }
+    if (restart_xid) StartXidListener();
+    return true;
+}
+
+void CGpuMonitor::Abandon()
+{
+    // Xid 监听线程同样可能卡在驱动里：只通知它退出，不等待；它用到的成员随监控对象一起保留
+    m_abandoned = true;
+    if (m_xid_stop_event) SetEvent(m_xid_stop_event);
+    if (m_xid_thread.joinable()) m_xid_thread.detach();
+}
+
+void CGpuMonitor::SaveCarriedState()
+{
+    for (size_t i = 0; i < m_devices.size(); ++i) {
+        size_t k = 0;
+        while (k < m_carried.size() && strcmp(m_carried[k].pci_bus_id, m_devices[i].pci_bus_id) != 0) ++k;
+        if (k == m_carried.size()) {
+            m_carried.emplace_back();
+            strcpy_s(m_carried[k].pci_bus_id, m_devices[i].pci_bus_id);
+        }
+        CarriedState& carried = m_carried[k];
+        carried.reason_timer = m_reason_timers[i];
+        carried.violation = m_violation_counters[i];
+        carried.lost_breaker = m_lost_breakers[i];
+        carried.xid_count = GetXidErrorCount(i);
+        carried.last_xid = GetLastXid(i);
+    }
+}
+
+void CGpuMonitor::Poll(CGpuSample* samples)
+{
+    if (!m_initialized) return;
+    unsigned int mask = m_field_mask.load(std::memory_order_relaxed);
+    if (mask != m_built_field_mask) BuildFieldRequest(mask);
+
+    ULONGLONG now = GetTickCount64();
+    DWORD elapsed_ms = m_last_poll_tick ? static_cast<DWORD>(now - m_last_poll_tick) : 0;
+    m_last_poll_tick = now;
+
+    ULONGLONG request_tick = m_process_request_tick.load(std::memory_order_relaxed);
+    bool want_processes = request_tick != 0 && now - request_tick < PROCESS_REQUEST_MS;
+
+    for (size_t i = 0; i < m_devices.size(); ++i) {
+        nvmlDevice_t device = m_devices[i].handle;
+        CCircuitBreaker& breaker = m_lost_breakers[i];
+        if (!breaker.AllowRequest(now)) {
+            samples[i].health = GPU_HEALTH_LOST;
+            continue;
+        }
+
+        // 第一个调用就报告掉卡时跳过该设备的其余调用，它们只会逐个失败或超时
+        // 掉卡或驱动被卸载后句柄不会自己恢复，转入丢失状态等待重新初始化
+        nvmlReturn_t result = NVML_SUCCESS;
+        int reason = QueryClockEventReason(i, elapsed_ms, samples[i], result);
+        if (result == NVML_ERROR_GPU_IS_LOST || result == NVML_ERROR_UNINITIALIZED || result == NVML_ERROR_DRIVER_NOT_LOADED) {
+            breaker.RecordFailure(now);
+            samples[i].health = GPU_HEALTH_LOST;
+            m_state = NVML_LOST;
+            continue;
+        }
+        breaker.RecordSuccess();
+        samples[i].health = GPU_HEALTH_OK;
+        samples[i].reason = reason;
+
+        unsigned int temp = 0;
+        if (!p_nvmlDeviceGetTemperature || p_nvmlDeviceGetTemperature(device, NVML_TEMPERATURE_GPU, &temp) != NVML_SUCCESS) {
+            temp = 0;
+        }
+        samples[i].temperature = temp;
+        PollFields(device, samples[i].telemetry);
+        UpdateEnergy(i, samples[i].telemetry, now, samples[i]);
+        PollViolation(i, samples[i].violation);
+        PollUtilization(i, samples[i].utilization);
+        PollMemory(device, samples[i].memory);
+        if (want_processes) PollProcesses(device, samples[i]);
+        else samples[i].process_count = -1;
+        samples[i].xid_count = GetXidErrorCount(i);
+        samples[i].last_xid = GetLastXid(i);
+    }
+
+    // 稳定运行一段时间后才清除退避，反复重置的驱动会逐渐拉长重试间隔
+    if (m_state == NVML_READY && now - m_ready_tick >= STABLE_RESET_MS) m_reinit_breaker.RecordSuccess();
+}
+
+void CGpuMonitor::BuildFieldRequest(unsigned int mask)
+{
+    m_field_request.clear();
+    m_field_kinds.clear();
+    for (int i = 0; i < GPU_FIELD_COUNT; ++i) {
+        if (!((mask >> i) & 1)) continue;
+        nvmlFieldValue_t field = {};
+        field.fieldId = s_field_ids[i];
+        m_field_request.push_back(field);
+        m_field_kinds.push_back(static_cast<GpuTelemetryField>(i));
+    }
+    for (int i = 0; i < GPU_VIOLATION_COUNT; ++i) {
+        nvmlFieldValue_t field = {};
+        field.fieldId = s_violation_field_ids[i];
+        m_field_request.push_back(field);
+    }
+    m_field_values.resize(m_field_request.size());
+    m_built_field_mask = mask;
+}
+
+void CGpuMonitor::PollFields(nvmlDevice_t device, CGpuTelemetry& telemetry)
+{
+    telemetry.valid_mask = 0;
+    std::fill(m_violation_field_valid, m_violation_field_valid + GPU_VIOLATION_COUNT, false);
+    if (!p_nvmlDeviceGetFieldValues) return;
+
+    // 每次都从模板复制，NVML 会覆盖返回值等字段
+    std::copy(m_field_request.begin(), m_field_request.end(), m_field_values.begin());
+    if (p_nvmlDeviceGetFieldValues(device, static_cast<int>(m_field_values.size()), m_field_values.data()) != NVML_SUCCESS) return;
+
+    size_t telemetry_count = m_field_kinds.size();
+    for (size_t i = 0; i < telemetry_count; ++i) {
+        GpuTelemetryField kind = m_field_kinds[i];
+        if (DecodeFieldValue(m_field_values[i], telemetry.values[kind])) {
+            telemetry.valid_mask |= 1u << kind;
+        }
+    }
+    for (int i = 0; i < GPU_VIOLATION_COUNT; ++i) {
+        const nvmlFieldValue_t& field = m_field_values[telemetry_count + i];
+        unsigned long long value = 0;
+        if (field.timestamp <= 0 || !DecodeFieldValue(field, value)) continue;
+        m_violation_fields[i].referenceTime = static_cast<unsigned long long>(field.timestamp);
+        m_violation_fields[i].violationTime = value;
+        m_violation_field_valid[i] = true;
+    }
+}
+
+void CGpuMonitor::UpdateEnergy(size_t device_index, const CGpuTelemetry& telemetry, ULONGLONG now, CGpuSample& sample)
+{
+    EnergyState& state = m_energy_states[device_index];
+    sample.average_power_w = -1.0f;
+    sample.energy_mj = 0;
+    if (!telemetry.Has(GPU_FIELD_ENERGY)) {
+        state.total.Reset();
+        state.last_tick = 0;
+        return;
+    }
+
+    // 首次读取或驱动重载后只记录基准；mJ / ms 正好是 W
+    unsigned long long delta = state.total.Update(telemetry.values[GPU_FIELD_ENERGY]);
+    if (state.last_tick != 0 && now > state.last_tick) {
+        sample.energy_mj = delta;
+        sample.average_power_w = static_cast<float>(static_cast<double>(delta) / (now - state.last_tick));
+    }
+    state.last_tick = now;
+}
+
+int CGpuMonitor::QueryClockEventReason(size_t device_index, DWORD elapsed_ms, CGpuSample& sample, nvmlReturn_t& result)
+{
+    unsigned long long reasons = 0;
+    result = p_nvmlDeviceGetCurrentClocksEventReasons(m_devices[device_index].handle, &reasons);
+    if (result != NVML_SUCCESS) return CLOCK_REASON_ERROR;
+
+    // 把本次状态计入上一个间隔，首次轮询没有间隔可计
+    CClockReasonTimer& timer = m_reason_timers[device_index];
+    if (elapsed_ms > 0) timer.Add(CompactClockEventReasons(reasons), elapsed_ms);
+    for (int i = 0; i < CLOCK_REASON_COUNT; ++i) {
+        sample.reason_fraction[i] = timer.GetFraction(i);
+    }
+    sample.reason_window_ms = timer.GetWindowMs();
+    return DecodeClockEventReasons(reasons);
+}
+
+void CGpuMonitor::PollViolation(size_t device_index, CGpuViolation& violation)
+{
+    violation = CGpuViolation();
+
+    // 批量请求读到了任意一个策略字段就说明驱动支持这些字段，否则退回逐个查询
+    bool use_fields = std::find(m_violation_field_valid, m_violation_field_valid + GPU_VIOLATION_COUNT, true)
+        != m_violation_field_valid + GPU_VIOLATION_COUNT;
+
+    nvmlDevice_t device = m_devices[device_index].handle;
+    ViolationCounter& counter = m_violation_counters[device_index];
+    for (int i = 0; i < GPU_VIOLATION_COUNT; ++i) {
+        nvmlViolationTime_t time = {};
+        if (use_fields) {
+            if (!m_violation_field_valid[i]) {
+                counter.valid[i] = false;
+                continue;
+            }
+            time = m_violation_fields[i];
+        } else if (!p_nvmlDeviceGetViolationStatus
+            || p_nvmlDeviceGetViolationStatus(device, static_cast<nvmlPerfPolicyType_t>(i), &time) != NVML_SUCCESS) {
+            counter.valid[i] = false;
+            continue;
+        }
+
+        // 计数器回绕或驱动重载时只记录新的基准
+        if (counter.valid[i] && time.referenceTime > counter.reference_us[i] && time.violationTime >= counter.violation_ns[i]) {
+            unsigned long long interval_ns = (time.referenceTime - counter.reference_us[i]) * 1000;
+            unsigned long long throttled_ns = min(time.violationTime - counter.violation_ns[i], interval_ns);
+            violation.throttled_ns[i] = throttled_ns;
+            violation.interval_ns = max(violation.interval_ns, interval_ns);
+            if (i != NVML_PERF_POLICY_LOW_UTILIZATION) {
+                violation.throttled_fraction = max(violation.throttled_fraction, static_cast<float>(static_cast<double>(throttled_ns) / interval_ns));
+            }
+            violation.valid = true;
+        }
+        counter.reference_us[i] = time.referenceTime;
+        counter.violation_ns[i] = time.violationTime;
+        counter.valid[i] = true;
+    }
+}
+
+void CGpuMonitor::PollUtilization(size_t device_index, CGpuUtilization* utilization)
+{
+    if (!p_nvmlDeviceGetSamples) return;
+
+    nvmlDevice_t device = m_devices[device_index].handle;
+    UtilizationState& state = m_utilization_states[device_index];
+    for (int kind = 0; kind < GPU_UTIL_COUNT; ++kind) {
+        nvmlValueType_t value_type;
+        unsigned int count = 0;
+        // 首次使用时查询驱动缓冲区的大小，之后复用同一块缓冲区
+        if (m_sample_buffer.empty()) {
+            if (p_nvmlDeviceGetSamples(device, s_sampling_types[kind], 0, &value_type, &count, nullptr) != NVML_SUCCESS || count == 0) {
+                utilization[kind] = state.last[kind];
+                continue;
+            }
+            m_sample_buffer.resize(max(count, MIN_SAMPLE_BUFFER));
+        }
+
+        count = static_cast<unsigned int>(m_sample_buffer.size());
+        nvmlReturn_t result = p_nvmlDeviceGetSamples(device, s_sampling_types[kind], state.last_seen[kind], &value_type, &count, m_sample_buffer.data());
+        if (result == NVML_SUCCESS && count > 0) {
+            unsigned int lo = 100, hi = 0, sum = 0;
+            for (unsigned int i = 0; i < count; ++i) {
+                const nvmlSample_t& sample = m_sample_buffer[i];
+                unsigned int value = min(sample.sampleValue.uiVal, 100u);
+                lo = min(lo, value);
+                hi = max(hi, value);
+                sum += value;
+                state.last_seen[kind] = max(state.last_seen[kind], sample.timeStamp);
+            }
+            CGpuUtilization& stats = state.last[kind];
+            stats.min = static_cast<BYTE>(lo);
+            stats.max = static_cast<BYTE>(hi);
+            stats.mean = static_cast<BYTE>((sum + count / 2) / count);
+            stats.count = static_cast<WORD>(min(count, 0xFFFFu));
+        }
+        // NVML_ERROR_NOT_FOUND 表示没有新采样，沿用上一次的统计
+        utilization[kind] = state.last[kind];
+    }
+}
+
+void CGpuMonitor::PollMemory(nvmlDevice_t device, CGpuMemory& memory)
+{
+    memory = CGpuMemory();
+    if (p_nvmlDeviceGetMemoryInfo) {
+        nvmlMemory_v2_t info = {};
+        info.version = nvmlMemory_v2;
+        if (p_nvmlDeviceGetMemoryInfo(device, &info) == NVML_SUCCESS) {
+            memory.total = info.total;
+            memory.used = info.used;
+            memory.reserved = info.reserved;
+        }
+    }
+    if (p_nvmlDeviceGetBAR1MemoryInfo && m_bar1_enabled.load(std::memory_order_relaxed)) {
+        nvmlBAR1Memory_t bar1 = {};
+        if (p_nvmlDeviceGetBAR1MemoryInfo(device, &bar1) == NVML_SUCCESS) {
+            memory.bar1_total = bar1.bar1Total;
+            memory.bar1_used = bar1.bar1Used;
+        }
+    }
+}
+
+bool CGpuMonitor::QueryProcesses(decltype(nvmlDeviceGetComputeRunningProcesses_v3)* query, nvmlDevice_t device, unsigned int offset, unsigned int& count)
+{
+    // 缓冲区不够时按驱动报告的数量扩大后重试一次，之后一直复用
+    count = static_cast<unsigned int>(m_process_buffer.size()) - offset;
+    nvmlReturn_t result = query(device, &count, m_process_buffer.data() + offset);
+    if (result == NVML_ERROR_INSUFFICIENT_SIZE) {
+        m_process_buffer.resize(offset + count + 16);
+        count = static_cast<unsigned int>(m_process_buffer.size()) - offset;
+        result = query(device, &count, m_process_buffer.data() + offset);
+    }
+    if (result != NVML_SUCCESS) count = 0;
+    return result == NVML_SUCCESS;
+}
+
+void CGpuMonitor::PollProcesses(nvmlDevice_t device, CGpuSample& sample)
+{
+    sample.process_count = -1;
+    if (!p_nvmlDeviceGetComputeRunningProcesses || !p_nvmlDeviceGetGraphicsRunningProcesses) return;
+    if (m_process_buffer.empty()) m_process_buffer.resize(64);
+
+    unsigned int compute_count = 0, graphics_count = 0;
+    bool ok = QueryProcesses(p_nvmlDeviceGetComputeRunningProcesses, device, 0, compute_count);
+    ok = QueryProcesses(p_nvmlDeviceGetGraphicsRunningProcesses, device, compute_count, graphics_count) || ok;
+    if (!ok) return;
+
+    // 同一进程可能同时有计算和图形上下文，按 PID 只取一次；按显存从大到小插入前 N 名
+    CGpuProcess* top = sample.top_processes;
+    int count = 0;
+    unsigned int total = compute_count + graphics_count;
+    for (unsigned int i = 0; i < total; ++i) {
+        const nvmlProcessInfo_t& info = m_process_buffer[i];
+        bool duplicate = false;
+        for (unsigned int k = 0; k < i && !duplicate; ++k) duplicate = m_process_buffer[k].pid == info.pid;
+        if (duplicate) continue;
+
+        unsigned long long used = (info.usedGpuMemory == static_cast<unsigned long long>(NVML_VALUE_NOT_AVAILABLE))
+            ? GPU_PROCESS_MEMORY_UNAVAILABLE : info.usedGpuMemory;
+        // 不可用的排在最后
+        unsigned long long rank = (used == GPU_PROCESS_MEMORY_UNAVAILABLE) ? 0 : used + 1;
+        int pos = count;
+        while (pos > 0) {
+            const CGpuProcess& prev = top[pos - 1];
+            unsigned long long prev_rank = (prev.used_memory == GPU_PROCESS_MEMORY_UNAVAILABLE) ? 0 : prev.used_memory + 1;
+            if (prev_rank >= rank) break;
+            --pos;
+        }
+        if (pos >= GPU_TOP_PROCESS_COUNT) continue;
+        int last = min(count, GPU_TOP_PROCESS_COUNT - 1);
+        for (int m = last; m > pos; --m) top[m] = top[m - 1];
+        top[pos].pid = info.pid;
+        top[pos].used_memory = used;
+        if (count < GPU_TOP_PROCESS_COUNT) ++count;
+    }
+
+    // 只为入选的进程查询名称
+    for (int i = 0; i < count; ++i) GetProcessName(top[i].pid, top[i].name);
+    sample.process_count = count;
+}
+
+// =================================================================
+// Xid 事件监听
+// =================================================================
+bool CGpuMonitor::StartXidListener()
+{
+    m_xid_requested = true;
+    if (!m_initialized || m_xid_thread.joinable()) return false;
+    if (!p_nvmlDeviceGetSupportedEventTypes || !p_nvmlEventSetCreate || !p_nvmlDeviceRegisterEvents
+        || !p_nvmlEventSetWait || !p_nvmlEventSetFree) return false;
+    if (p_nvmlEventSetCreate(&m_event_set) != NVML_SUCCESS) {
+        m_event_set = nullptr;
+        return false;
+    }
+
+    // 只要有一个设备注册成功就启动监听
+    bool registered = false;
+    for (const CGpuDeviceInfo& device : m_devices) {
+        unsigned long long supported = 0;
+        if (p_nvmlDeviceGetSupportedEventTypes(device.handle, &supported) != NVML_SUCCESS) continue;
+        if (!(supported & nvmlEventTypeXidCriticalError)) continue;
+        if (p_nvmlDeviceRegisterEvents(device.handle, nvmlEventTypeXidCriticalError, m_event_set) == NVML_SUCCESS) {
+            registered = true;
+        }
+    }
+    m_xid_stop_event = registered ? CreateEventW(nullptr, TRUE, FALSE, nullptr) : nullptr;
+    if (!m_xid_stop_event) {
+        p_nvmlEventSetFree(m_event_set);
+        m_event_set = nullptr;
+        return false;
+    }
+
+    m_xid_thread = std::thread(&CGpuMonitor::RunXidListener, this);
+    return true;
+}
+
+void CGpuMonitor::StopXidListener()
+{
+    if (m_abandoned) return;
+    if (m_xid_stop_event) SetEvent(m_xid_stop_event);
+    if (m_xid_thread.joinable()) m_xid_thread.join();
+    if (m_xid_stop_event) {
+        CloseHandle(m_xid_stop_event);
+        m_xid_stop_event = nullptr;
+    }
+    if (m_event_set) {
+        p_nvmlEventSetFree(m_event_set);
+        m_event_set = nullptr;
+    }
+}
+
+void CGpuMonitor::RunXidListener()
+{
+    // 等待超时决定了停止时的最长延迟，事件本身会立即唤醒
+    const unsigned int WAIT_TIMEOUT_MS = 250;
+    while (WaitForSingleObject(m_xid_stop_event, 0) != WAIT_OBJECT_0) {
+        nvmlEventData_t data = {};
+        nvmlReturn_t result = p_nvmlEventSetWait(m_event_set, &data, WAIT_TIMEOUT_MS);
+        if (result == NVML_ERROR_TIMEOUT) continue;
+        if (result != NVML_SUCCESS) {
+            // 出错时不要空转
+            if (WaitForSingleObject(m_xid_stop_event, 1000) == WAIT_OBJECT_0) break;
+            continue;
+        }
+        if (!(data.eventType & nvmlEventTypeXidCriticalError)) continue;
+        for (size_t i = 0; i < m_devices.size(); ++i) {
+            if (m_devices[i].handle == data.device) {
+                m_last_xid[i].store(static_cast<unsigned int>(data.eventData), std::memory_order_relaxed);
+                m_xid_counts[i].fetch_add(1, std::memory_order_release);
+                break;
+            }
+        }
+    }
+}
+
+unsigned int CGpuMonitor::GetXidErrorCount(size_t device_index) const
+{
+    if (!m_xid_counts || device_index >= m_devices.size()) return 0;
+    return m_xid_counts[device_index].load(std::memory_order_acquire);
+}
+
+unsigned int CGpuMonitor::GetLastXid(size_t device_index) const
+{
+    if (!m_last_xid || device_index >= m_devices.size()) return 0;
+    return m_last_xid[device_index].load(std::memory_order_relaxed);
+}
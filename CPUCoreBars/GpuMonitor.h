@@ -0,0 +1,320 @@
+// CPUCoreBars/GpuMonitor.h - NVIDIA GPU 监控（运行时加载 nvml.dll / libnvidia-ml.so）
+#pragma once
+#include "Platform.h"
+#include <vector>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <string>
+#include "nvml.h"
+#include "GpuClockReasons.h"
+#include "EventWindow.h"
+#include "CircuitBreaker.h"
+
+// =================================================================
+// 批量读取的遥测字段：每个设备每次轮询只调用一次 nvmlDeviceGetFieldValues
+// =================================================================
+enum GpuTelemetryField
+{
+    GPU_FIELD_POWER,            // 当前功耗 (mW)
+    GPU_FIELD_POWER_LIMIT,      // 当前生效的功耗上限 (mW)
+    GPU_FIELD_ENERGY,           // 驱动加载以来的总能耗 (mJ)
+    GPU_FIELD_MEMORY_TEMP,      // 显存温度 (°C)
+    GPU_FIELD_SLOWDOWN_TEMP,    // 开始硬件降频的温度 (°C)
+    GPU_FIELD_COUNT
+};
+
+static const unsigned int GPU_FIELD_ALL = (1u << GPU_FIELD_COUNT) - 1;
+
+struct CGpuTelemetry
+{
+    unsigned int valid_mask = 0;                    // 第 i 位表示 values[i] 有效
+    unsigned long long values[GPU_FIELD_COUNT] = {};
+
+    bool Has(GpuTelemetryField field) const { return (valid_mask >> field) & 1; }
+};
+
+// =================================================================
+// 违规时间计数器：前 6 种性能策略，随遥测字段一起用 NVML_FI_DEV_PERF_POLICY_* 批量读取
+// 驱动不支持这些字段时才逐个调用 nvmlDeviceGetViolationStatus
+// 计数器是累计纳秒数，相邻两次轮询的差值能反映间隔内的短暂降频
+// =================================================================
+static const int GPU_VIOLATION_COUNT = NVML_PERF_POLICY_RELIABILITY + 1;
+
+struct CGpuViolation
+{
+    unsigned long long throttled_ns[GPU_VIOLATION_COUNT] = {};     // 上次轮询以来各策略的降频时长
+    unsigned long long interval_ns = 0;                            // 对应的时间间隔
+    float throttled_fraction = 0.0f;    // 除低负载外各策略中最大的降频时间占比 (0~1)
+    bool valid = false;
+};
+
+// =================================================================
+// 利用率：nvmlDeviceGetSamples 返回驱动内部缓冲区中上次时间戳之后的所有采样
+// 每次轮询一次调用即可取回间隔内的全部亚秒级采样
+// =================================================================
+enum GpuUtilizationKind
+{
+    GPU_UTIL_GPU,
+    GPU_UTIL_MEMORY,
+    GPU_UTIL_ENCODER,
+    GPU_UTIL_DECODER,
+    GPU_UTIL_COUNT
+};
+
+struct CGpuUtilization
+{
+    BYTE min = 0;       // 百分比
+    BYTE mean = 0;
+    BYTE max = 0;
+    WORD count = 0;     // 本次统计用到的采样数，0 表示无效
+};
+
+// =================================================================
+// 显存：nvmlDeviceGetMemoryInfo_v2 把驱动/固件保留的部分单独列出并计入已用
+// BAR1 是 CPU 可直接映射的显存窗口，只在开启时读取
+// =================================================================
+struct CGpuMemory
+{
+    unsigned long long total = 0;       // 字节，0 表示无效
+    unsigned long long used = 0;
+    unsigned long long reserved = 0;
+    unsigned long long bar1_total = 0;  // 0 表示未读取
+    unsigned long long bar1_used = 0;
+};
+
+// =================================================================
+// 显存占用最多的进程：只在请求后的几秒内（鼠标停在提示上时）读取
+// =================================================================
+static const int GPU_TOP_PROCESS_COUNT = 5;
+static const unsigned long long GPU_PROCESS_MEMORY_UNAVAILABLE = ~0ull;    // WDDM 下驱动不提供单进程显存
+
+struct CGpuProcess
+{
+    unsigned int pid = 0;
+    unsigned long long used_memory = 0;     // 字节
+    wchar_t name[32] = {};
+};
+
+// =================================================================
+// 设备响应状态：超时由轮询线程判定，掉卡（NVML_ERROR_GPU_IS_LOST）由 Poll 判定
+// =================================================================
+enum GpuHealth
+{
+    GPU_HEALTH_OK,
+    GPU_HEALTH_UNRESPONSIVE,    // NVML 调用超时，可能在 TDR 恢复中
+    GPU_HEALTH_LOST             // 设备已从总线上消失，退避后再试探
+};
+
+// =================================================================
+// 单个 GPU 一次轮询的结果（POD，可直接放进快照）
+// =================================================================
+struct CGpuSample
+{
+    GpuHealth health = GPU_HEALTH_OK;               // 不是 OK 时其余字段为上一次成功轮询的值
+    int reason = CLOCK_REASON_UNAVAILABLE;          // 优先级最高的时钟事件原因（解码表下标或特殊值）
+    float reason_fraction[CLOCK_REASON_COUNT] = {}; // 最近窗口内各原因的时间占比
+    DWORD reason_window_ms = 0;
+    unsigned int temperature = 0;       // 摄氏度，0 表示无效
+    CGpuTelemetry telemetry;
+    CGpuViolation violation;
+    CGpuUtilization utilization[GPU_UTIL_COUNT];
+    float average_power_w = -1.0f;      // 两次轮询之间能耗计数的差值 / 时间，小于 0 表示无效
+    unsigned long long energy_mj = 0;   // 上一次轮询以来消耗的能量
+    CGpuMemory memory;
+    CGpuProcess top_processes[GPU_TOP_PROCESS_COUNT];
+    int process_count = -1;             // -1 表示本次没有读取进程列表
+    unsigned int xid_count = 0;         // 插件启动以来收到的 Xid 严重错误数（重新初始化后按 PCI 总线号延续）
+    unsigned int last_xid = 0;
+};
+
+struct CGpuDeviceInfo
+{
+    nvmlDevice_t handle;
+    unsigned int index;
+    char uuid[NVML_DEVICE_UUID_V2_BUFFER_SIZE];
+    char pci_bus_id[NVML_DEVICE_PCI_BUS_ID_BUFFER_SIZE];    // 用于生成稳定的显示项 ID
+};
+
+// =================================================================
+// NVML 生命周期：登录时驱动可能尚未加载，运行中驱动也可能被重置
+// 未就绪或丢失时由轮询线程按退避节奏重新初始化并重新枚举设备
+// =================================================================
+enum NvmlState
+{
+    NVML_UNINITIALIZED,     // 从未初始化成功
+    NVML_READY,
+    NVML_LOST,              // 驱动重置或设备掉卡，等待重新初始化
+    NVML_REINITIALIZING
+};
+
+// =================================================================
+// NVML 封装：枚举所有设备，一次轮询取回全部 GPU 的数据
+// =================================================================
+class CGpuMonitor
+{
+public:
+    CGpuMonitor() = default;
+    ~CGpuMonitor();
+    CGpuMonitor(const CGpuMonitor&) = delete;
+    CGpuMonitor& operator=(const CGpuMonitor&) = delete;
+
+    bool Init();
+    void Shutdown();
+
+    // 轮询线程卡在驱动里无法停止时调用：之后不再卸载 NVML，也不再等待 Xid 监听线程
+    // 被放弃的线程醒来后还会访问监控对象，调用方必须保留（泄漏）它，不能析构
+    void Abandon();
+
+    bool IsInitialized() const { return m_initialized; }
+    const std::vector<CGpuDeviceInfo>& GetDevices() const { return m_devices; }
+    NvmlState GetState() const { return m_state; }
+
+    // 每次初始化成功加一，设备列表随之可能变化
+    unsigned int GetGeneration() const { return m_generation; }
+
+    // 指定要加载的 NVML 库（如 tests/nvml_standin 的替身库），空字符串表示系统的 NVML
+    // 可在任意线程调用，路径变化时由下一次 Maintain 重新初始化
+    void SetLibraryPath(const wchar_t* path);
+
+    // 未就绪或已丢失时尝试重新初始化（限速），设备列表变化时返回 true
+    // 就绪状态下只是一次判断，不影响稳定轮询的开销
+    bool Maintain();
+
+    // samples 的大小必须等于设备数；可能阻塞在驱动里，应通过 CGpuPollWorker 调用
+    void Poll(CGpuSample* samples);
+
+    // Xid 严重错误事件监听，在独立线程上阻塞等待 NVML 事件
+    // Windows 驱动通常不支持 NVML 事件，此时返回 false，由事件日志扫描兜底
+    bool StartXidListener();
+    void StopXidListener();
+    bool IsXidListenerRunning() const { return m_xid_thread.joinable(); }
+
+    // 重新初始化会替换计数器，因此只在轮询线程上读取，其他线程使用 CGpuSample 中的副本
+    unsigned int GetXidErrorCount(size_t device_index) const;
+    unsigned int GetLastXid(size_t device_index) const;
+
+    // 选择批量读取的字段（GpuTelemetryField 位掩码），可在任意线程调用
+    void SetFieldMask(unsigned int mask) { m_field_mask.store(mask & GPU_FIELD_ALL, std::memory_order_relaxed); }
+
+    // 是否读取 BAR1 占用，可在任意线程调用
+    void SetBar1Enabled(bool enabled) { m_bar1_enabled.store(enabled, std::memory_order_relaxed); }
+
+    // 请求在接下来几次轮询中读取进程列表，可在任意线程调用（如显示提示时）
+    void RequestProcesses() { m_process_request_tick.store(GetTickCount64(), std::memory_order_relaxed); }
+
+private:
+    int QueryClockEventReason(size_t device_index, DWORD elapsed_ms, CGpuSample& sample, nvmlReturn_t& result);
+    void BuildFieldRequest(unsigned int mask);
+    void PollFields(nvmlDevice_t device, CGpuTelemetry& telemetry);
+    void PollViolation(size_t device_index, CGpuViolation& violation);
+    void PollUtilization(size_t device_index, CGpuUtilization* utilization);
+    void PollMemory(nvmlDevice_t device, CGpuMemory& memory);
+    void PollProcesses(nvmlDevice_t device, CGpuSample& sample);
+    bool QueryProcesses(decltype(nvmlDeviceGetComputeRunningProcesses_v3)* query, nvmlDevice_t device, unsigned int offset, unsigned int& count);
+    void UpdateEnergy(size_t device_index, const CGpuTelemetry& telemetry, ULONGLONG now, CGpuSample& sample);
+    void RunXidListener();
+    void SaveCarriedState();
+
+    // 上一次读到的累计计数，用于求差值
+    struct ViolationCounter
+    {
+        unsigned long long reference_us[GPU_VIOLATION_COUNT];
+        unsigned long long violation_ns[GPU_VIOLATION_COUNT];
+        bool valid[GPU_VIOLATION_COUNT];
+    };
+
+    HMODULE m_nvml_dll = nullptr;
+    std::wstring m_library_path = DEFAULT_LIBRARY;     // 仅在初始化所在的线程访问
+    std::mutex m_path_mutex;
+    std::wstring m_pending_path;
+    std::atomic<bool> m_path_dirty{ false };
+    static const wchar_t* const DEFAULT_LIBRARY;
+    bool m_initialized = false;
+    bool m_abandoned = false;
+    NvmlState m_state = NVML_UNINITIALIZED;
+    unsigned int m_generation = 0;
+    CCircuitBreaker m_reinit_breaker{ 1, 5000, 300000 };  // 重新初始化失败后 5 秒起倍增，最长 5 分钟
+    bool m_xid_requested = false;                       // 重新初始化后恢复 Xid 监听
+    ULONGLONG m_ready_tick = 0;
+    static const ULONGLONG STABLE_RESET_MS = 60000;
+    std::vector<CGpuDeviceInfo> m_devices;
+    std::vector<CClockReasonTimer> m_reason_timers;     // 与 m_devices 一一对应
+    std::vector<ViolationCounter> m_violation_counters; // 与 m_devices 一一对应
+    std::vector<CCircuitBreaker> m_lost_breakers;       // 掉卡后跳过该设备，按指数退避试探
+
+    // 重新初始化前按 PCI 总线号保存的累计状态，Init 枚举到同一块卡时接着使用
+    // 保留所有出现过的设备：某次只枚举到部分设备时，其余设备的状态留到下一次
+    struct CarriedState
+    {
+        char pci_bus_id[NVML_DEVICE_PCI_BUS_ID_BUFFER_SIZE];
+        CClockReasonTimer reason_timer;
+        ViolationCounter violation;
+        CCircuitBreaker lost_breaker;
+        unsigned int xid_count;
+        unsigned int last_xid;
+    };
+    std::vector<CarriedState> m_carried;
+
+    // 每个设备每种采样的上次时间戳，以及上次的统计结果（没有新采样时沿用）
+    struct UtilizationState
+    {
+        unsigned long long last_seen[GPU_UTIL_COUNT];
+        CGpuUtilization last[GPU_UTIL_COUNT];
+    };
+    std::vector<UtilizationState> m_utilization_states;
+    std::vector<nvmlSample_t> m_sample_buffer;          // 复用的采样缓冲区
+
+    // 能耗计数比瞬时功耗更准：差值除以间隔就是间隔内的平均功耗
+    struct EnergyState
+    {
+        CCounterDelta total;
+        ULONGLONG last_tick = 0;
+    };
+    std::vector<EnergyState> m_energy_states;           // 与 m_devices 一一对应
+
+    // 进程列表：计算和图形进程先后写入同一块复用的缓冲区
+    std::atomic<bool> m_bar1_enabled{ false };
+    std::atomic<ULONGLONG> m_process_request_tick{ 0 };
+    std::vector<nvmlProcessInfo_t> m_process_buffer;
+    static const ULONGLONG PROCESS_REQUEST_MS = 3000;
+
+    // Xid 监听线程，计数器按设备下标排列，在 Init 中按设备列表重新分配
+    nvmlEventSet_t m_event_set = nullptr;
+    std::thread m_xid_thread;
+    HANDLE m_xid_stop_event = nullptr;
+    std::unique_ptr<std::atomic<unsigned int>[]> m_xid_counts;
+    std::unique_ptr<std::atomic<unsigned int>[]> m_last_xid;
+    ULONGLONG m_last_poll_tick = 0;
+
+    // 字段请求模板与复用的结果缓冲区，仅轮询线程访问
+    std::atomic<unsigned int> m_field_mask{ GPU_FIELD_ALL };
+    unsigned int m_built_field_mask = ~0u;
+    std::vector<nvmlFieldValue_t> m_field_request;
+    std::vector<nvmlFieldValue_t> m_field_values;
+    std::vector<GpuTelemetryField> m_field_kinds;       // 请求中前 m_field_kinds.size() 项为遥测字段，之后是各违规策略
+    nvmlViolationTime_t m_violation_fields[GPU_VIOLATION_COUNT] = {};  // 本次 PollFields 读到的违规计数器
+    bool m_violation_field_valid[GPU_VIOLATION_COUNT] = {};
+
+    decltype(nvmlInit_v2)* p_nvmlInit = nullptr;
+    decltype(nvmlShutdown)* p_nvmlShutdown = nullptr;
+    decltype(nvmlDeviceGetCount_v2)* p_nvmlDeviceGetCount = nullptr;
+    decltype(nvmlDeviceGetHandleByIndex_v2)* p_nvmlDeviceGetHandleByIndex = nullptr;
+    decltype(nvmlDeviceGetUUID)* p_nvmlDeviceGetUUID = nullptr;
+    decltype(nvmlDeviceGetPciInfo_v3)* p_nvmlDeviceGetPciInfo = nullptr;
+    decltype(nvmlDeviceGetCurrentClocksEventReasons)* p_nvmlDeviceGetCurrentClocksEventReasons = nullptr;
+    decltype(nvmlDeviceGetTemperature)* p_nvmlDeviceGetTemperature = nullptr;
+    decltype(nvmlDeviceGetFieldValues)* p_nvmlDeviceGetFieldValues = nullptr;
+    decltype(nvmlDeviceGetViolationStatus)* p_nvmlDeviceGetViolationStatus = nullptr;
+    decltype(nvmlDeviceGetSamples)* p_nvmlDeviceGetSamples = nullptr;
+    decltype(nvmlDeviceGetMemoryInfo_v2)* p_nvmlDeviceGetMemoryInfo = nullptr;
+    decltype(nvmlDeviceGetBAR1MemoryInfo)* p_nvmlDeviceGetBAR1MemoryInfo = nullptr;
+    decltype(nvmlDeviceGetComputeRunningProcesses_v3)* p_nvmlDeviceGetComputeRunningProcesses = nullptr;
+    decltype(nvmlDeviceGetGraphicsRunningProcesses_v3)* p_nvmlDeviceGetGraphicsRunningProcesses = nullptr;
+    decltype(nvmlDeviceGetSupportedEventTypes)* p_nvmlDeviceGetSupportedEventTypes = nullptr;
+    decltype(nvmlEventSetCreate)* p_nvmlEventSetCreate = nullptr;
+    decltype(nvmlDeviceRegisterEvents)* p_nvmlDeviceRegisterEvents = nullptr;
+    decltype(nvmlEventSetWait_v2)* p_nvmlEventSetWait = nullptr;
+    decltype(nvmlEventSetFree)* p_nvmlEventSetFree = nullptr;
+};
@@ -0,0 +1,127 @@
+﻿// CPUCoreBars/GpuPollWorker.cpp - 在独立线程上执行 NVML 轮询，调用方只等待有限时间
+#include "GpuPollWorker.h"
+
+CGpuPollWorker::~CGpuPollWorker()
+{
+    Stop(INFINITE);
+}
+
+bool CGpuPollWorker::Start(CGpuMonitor* monitor)
+{
+    // 初始化失败时也要启动，之后由工作线程负责重试
+    if (m_thread.joinable() || m_abandoned || !monitor) return false;
+    SharedState& shared = *m_shared;
+    shared.monitor = monitor;
+    shared.devices = monitor->GetDevices();
+    shared.generation = monitor->GetGeneration();
+    shared.state = monitor->GetState();
+    shared.xid_listening = monitor->IsXidListenerRunning();
+    shared.results.assign(shared.devices.size(), CGpuSample());
+    shared.request_event = CreateEventW(nullptr, FALSE, FALSE, nullptr);
+    shared.done_event = CreateEventW(nullptr, FALSE, FALSE, nullptr);
+    shared.stop_event = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+    shared.exited_event = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+    if (!shared.request_event || !shared.done_event || !shared.stop_event || !shared.exited_event) {
+        Stop(0);
+        return false;
+    }
+    m_busy = false;
+    m_breaker = CCircuitBreaker();
+    m_thread = std::thread(&CGpuPollWorker::Run, m_shared.get());
+    return true;
+}
+
+bool CGpuPollWorker::Stop(DWORD wait_ms)
+{
+    if (m_abandoned) return false;
+    SharedState& shared = *m_shared;
+    if (m_thread.joinable()) {
+        SetEvent(shared.stop_event);
+        // 线程卡在驱动里时无法安全地等待或终止，只能放弃它；
+        // 它醒来后还会访问事件句柄和结果缓冲区，整个共享块交给它，不再释放
+        if (WaitForSingleObject(shared.exited_event, wait_ms) != WAIT_OBJECT_0) {
+            m_thread.detach();
+            static_cast<void>(m_shared.release());          // 故意泄漏
+            m_abandoned = true;
+            return false;
+        }
+        m_thread.join();
+    }
+    if (shared.request_event) CloseHandle(shared.request_event);
+    if (shared.done_event) CloseHandle(shared.done_event);
+    if (shared.stop_event) CloseHandle(shared.stop_event);
+    if (shared.exited_event) CloseHandle(shared.exited_event);
+    shared.request_event = nullptr;
+    shared.done_event = nullptr;
+    shared.stop_event = nullptr;
+    shared.exited_event = nullptr;
+    m_busy = false;
+    return true;
+}
+
+CGpuPollWorker::PollResult CGpuPollWorker::Poll(std::vector<CGpuSample>& samples, DWORD timeout_ms)
+{
+    if (m_abandoned) return POLL_BACKOFF;
+    SharedState& shared = *m_shared;
+    ULONGLONG now = GetTickCount64();
+    if (m_busy) {
+        // 上一次轮询还没返回就不再排队，避免请求在卡住的驱动后面堆积
+        // 卡住期间每次都计一次失败，驱动恢复后先退避，不立刻压上新的调用
+        if (WaitForSingleObject(shared.done_event, 0) != WAIT_OBJECT_0) {
+            m_breaker.RecordFailure(now);
+            return POLL_TIMEOUT;
+        }
+        m_busy = false;
+    }
+    if (!m_breaker.AllowRequest(now)) return POLL_BACKOFF;
+
+    m_busy = true;
+    SetEvent(shared.request_event);
+    if (WaitForSingleObject(shared.done_event, timeout_ms) != WAIT_OBJECT_0) {
+        m_breaker.RecordFailure(now);
+        return POLL_TIMEOUT;
+    }
+    m_busy = false;
+    m_breaker.RecordSuccess();
+    samples.assign(shared.results.begin(), shared.results.end());     // 大小不变时不重新分配
+    shared.delivered = true;
+    return POLL_OK;
+}
+
+void CGpuPollWorker::Run(SharedState* shared)
+{
+    // 只访问共享块和监控对象，不碰 CGpuPollWorker 本身：线程被放弃后它可能已经析构
+    CGpuMonitor* monitor = shared->monitor;
+    HANDLE handles[2] = { shared->stop_event, shared->request_event };
+    std::vector<unsigned long long> late_energy_mj;
+    while (WaitForMultipleObjects(2, handles, FALSE, INFINITE) == WAIT_OBJECT_0 + 1) {
+        // 上一次结果超时后才完成、没有被取走：记下它的能耗差值，轮询会覆盖结果
+        late_energy_mj.clear();
+        if (!shared->delivered) {
+            for (const CGpuSample& sample : shared->results) {
+                late_energy_mj.push_back(sample.health == GPU_HEALTH_OK ? sample.energy_mj : 0);
+            }
+        }
+        if (monitor->Maintain()) {
+            // 重新初始化后能耗计数从新的基准开始，设备顺序也可能变化，旧差值作废
+            late_energy_mj.clear();
+            shared->devices = monitor->GetDevices();
+            shared->results.assign(shared->devices.size(), CGpuSample());
+        }
+        shared->generation = monitor->GetGeneration();
+        if (monitor->IsInitialized()) {
+            monitor->Poll(shared->results.data());
+            for (size_t i = 0; i < late_energy_mj.size() && i < shared->results.size(); ++i) {
+                shared->results[i].energy_mj += late_energy_mj[i];
+            }
+        } else {
+            // 重新初始化失败，旧设备的句柄已经释放，保留旧数据并标记为丢失
+            for (CGpuSample& sample : shared->results) sample.health = GPU_HEALTH_LOST;
+        }
+        shared->state = monitor->GetState();
+        shared->xid_listening = monitor->IsXidListenerRunning();
+        shared->delivered = false;
+        SetEvent(shared->done_event);
+    }
+    SetEvent(shared->exited_event);
+}
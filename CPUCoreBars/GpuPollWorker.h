@@ -0,0 +1,73 @@
+// CPUCoreBars/GpuPollWorker.h - 在独立线程上执行 NVML 轮询，调用方只等待有限时间
+#pragma once
+#include "Platform.h"
+#include <memory>
+#include <thread>
+#include <vector>
+#include "GpuMonitor.h"
+#include "CircuitBreaker.h"
+
+// =================================================================
+// NVML 轮询线程：驱动挂起、TDR 恢复或掉卡时 NVML 调用可能阻塞数秒
+// 调用方在截止时间内拿不到结果就先返回，工作线程在后台继续等待驱动
+// 上一次轮询没结束前不会发起新的轮询，连续超时后熔断并指数退避
+// NVML 的重新初始化也在工作线程上进行，设备列表随结果一起交给调用方
+// 与工作线程共享的状态放在单独的堆块里：停止超时放弃线程时故意泄漏这块内存，
+// 线程从驱动里醒来后访问的事件句柄和结果缓冲区仍然有效，调用方的对象可以正常析构
+// =================================================================
+class CGpuPollWorker
+{
+public:
+    enum PollResult
+    {
+        POLL_OK,            // 在截止时间内完成，samples 已更新
+        POLL_TIMEOUT,       // 本次或之前的轮询仍卡在驱动里
+        POLL_BACKOFF        // 熔断中，本次没有发起轮询
+    };
+
+    CGpuPollWorker() = default;
+    ~CGpuPollWorker();
+    CGpuPollWorker(const CGpuPollWorker&) = delete;
+    CGpuPollWorker& operator=(const CGpuPollWorker&) = delete;
+
+    bool Start(CGpuMonitor* monitor);
+
+    // 最多等待 wait_ms 让工作线程退出；仍卡在驱动里时返回 false 并放弃该线程
+    bool Stop(DWORD wait_ms);
+
+    // 只能在同一个线程（采样线程）上调用；设备列表变化时 samples 随之改变大小
+    PollResult Poll(std::vector<CGpuSample>& samples, DWORD timeout_ms);
+
+    // 以下内容在 Poll 返回 POLL_OK 后有效，只在调用线程上读取
+    unsigned int GetGeneration() const { return m_shared->generation; }
+    const std::vector<CGpuDeviceInfo>& GetDevices() const { return m_shared->devices; }
+    NvmlState GetState() const { return m_shared->state; }
+    bool IsXidListenerRunning() const { return m_shared->xid_listening; }
+
+private:
+    struct SharedState
+    {
+        CGpuMonitor* monitor = nullptr;     // 放弃线程时调用方也必须保留监控对象
+        HANDLE request_event = nullptr;     // 自动重置：请求一次轮询
+        HANDLE done_event = nullptr;        // 自动重置：轮询完成
+        HANDLE stop_event = nullptr;
+        HANDLE exited_event = nullptr;      // 工作线程退出前置位，用于限时等待
+        // 工作线程在处理请求期间写，调用线程在 done_event 之后读
+        std::vector<CGpuSample> results;
+        std::vector<CGpuDeviceInfo> devices;
+        unsigned int generation = 0;
+        NvmlState state = NVML_UNINITIALIZED;
+        bool xid_listening = false;         // 重新初始化会重启 Xid 监听，只能在工作线程上查询
+        // 调用线程取走结果后置位，工作线程在下一次请求时读取（两者之间有 request_event 同步）
+        // 超时后才完成的轮询没有被取走，它的能耗差值并入下一次结果，本次运行的累计能耗不会少算
+        bool delivered = true;
+    };
+
+    static void Run(SharedState* shared);
+
+    std::unique_ptr<SharedState> m_shared{ new SharedState() };
+    std::thread m_thread;
+    bool m_abandoned = false;           // 工作线程停止超时后被放弃，m_shared 已泄漏
+    bool m_busy = false;                // 已发出请求但还没取到结果，仅调用线程访问
+    CCircuitBreaker m_breaker;          // 仅调用线程访问
+};
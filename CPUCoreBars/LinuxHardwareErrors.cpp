@@ -0,0 +1,236 @@
+﻿// CPUCoreBars/LinuxHardwareErrors.cpp - 基于 sysfs/procfs 累计计数的硬件错误读取器（Linux）
+#include "LinuxHardwareErrors.h"
+#include "Platform.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace
+{
+    // WHEA_ERROR_SOURCE_TYPE 中与 Linux 来源最接近的类型，GetWheaSourceName 据此显示
+    const unsigned char SOURCE_MCE = 0;
+    const unsigned char SOURCE_PCIE = 4;
+    const unsigned char SOURCE_GENERIC = 5;
+
+    inline bool IsDigit(char c)
+    {
+        return static_cast<unsigned char>(c - '0') < 10;
+    }
+
+    CWheaRecord MakeRecord(WheaSeverity severity, unsigned char source)
+    {
+        CWheaRecord record;
+        record.severity = static_cast<unsigned char>(severity);
+        record.source = source;
+        return record;
+    }
+
+    // 按名称排序后遍历子目录，设备顺序与 ls 一致
+    std::vector<std::string> ListEntries(const std::string& path, const char* prefix)
+    {
+        std::vector<std::string> names;
+        DIR* dir = opendir(path.c_str());
+        if (!dir) return names;
+        size_t prefix_length = strlen(prefix);
+        while (dirent* entry = readdir(dir)) {
+            if (entry->d_name[0] == '.' || strncmp(entry->d_name, prefix, prefix_length) != 0) continue;
+            names.push_back(entry->d_name);
+        }
+        closedir(dir);
+        std::sort(names.begin(), names.end());
+        return names;
+    }
+}
+
+namespace
+{
+    // 返回以 key 开头的行（忽略行首空格）中 key 之后的位置，key 为空时返回 data；找不到时返回 nullptr
+    const char* FindKey(const char* data, const char* end, const char* key)
+    {
+        const char* p = data;
+        if (!key) return p;
+        size_t key_length = strlen(key);
+        for (;;) {
+            while (p < end && *p == ' ') ++p;
+            if (static_cast<size_t>(end - p) >= key_length && memcmp(p, key, key_length) == 0) return p + key_length;
+            const char* line_end = static_cast<const char*>(memchr(p, '\n', end - p));
+            if (!line_end) return nullptr;
+            p = line_end + 1;
+        }
+    }
+
+    // 读取下一个用空格分隔的数字；遇到说明文字或换行时返回 false
+    bool NextColumn(const char*& p, const char* end, unsigned long long* value)
+    {
+        while (p < end && *p == ' ') ++p;
+        if (p >= end || !IsDigit(*p)) return false;
+        unsigned long long number = 0;
+        while (p < end && IsDigit(*p)) number = number * 10 + (*p++ - '0');
+        *value = number;
+        return true;
+    }
+}
+
+bool ParseErrorCounter(const char* data, size_t length, const char* key, unsigned long long* value)
+{
+    const char* end = data + length;
+    const char* p = FindKey(data, end, key);
+    if (!p) return false;
+
+    unsigned long long sum = 0, number = 0;
+    bool found = false;
+    while (NextColumn(p, end, &number)) {
+        sum += number;
+        found = true;
+    }
+    if (found) *value = sum;
+    return found;
+}
+
+int ParseErrorColumns(const char* data, size_t length, const char* key, unsigned long long* columns, int max_columns)
+{
+    const char* end = data + length;
+    const char* p = FindKey(data, end, key);
+    if (!p) return -1;
+
+    int count = 0;
+    unsigned long long number = 0;
+    while (NextColumn(p, end, &number)) {
+        if (count < max_columns) columns[count] = number;
+        ++count;
+    }
+    return count;
+}
+
+// =================================================================
+// CLinuxHardwareErrorReader implementation
+// =================================================================
+CLinuxHardwareErrorReader::CLinuxHardwareErrorReader(const std::vector<std::wstring>& providers, bool every_update, const char* root)
+    : m_every_update(every_update)
+{
+    for (size_t i = 0; i < providers.size(); ++i) {
+        if (_wcsicmp(providers[i].c_str(), WHEA_PROVIDER_NAME) == 0) m_provider = static_cast<int>(i);
+    }
+    if (m_provider < 0) return;
+
+    std::string base = root;
+    std::string edac = base + "/sys/devices/system/edac/mc";
+    for (const std::string& mc : ListEntries(edac, "mc")) {
+        AddCounter(edac + "/" + mc + "/ce_count", nullptr, MakeRecord(WHEA_CORRECTED, SOURCE_GENERIC));
+        AddCounter(edac + "/" + mc + "/ue_count", nullptr, MakeRecord(WHEA_UNCORRECTED, SOURCE_GENERIC));
+    }
+
+    // 没有 AER 能力的设备没有这些文件，打开失败即跳过
+    std::string pci = base + "/sys/bus/pci/devices";
+    for (const std::string& device : ListEntries(pci, "")) {
+        CWheaRecord record = MakeRecord(WHEA_CORRECTED, SOURCE_PCIE);
+        unsigned int segment = 0, bus = 0, slot = 0, function = 0;
+        if (sscanf(device.c_str(), "%x:%x:%x.%x", &segment, &bus, &slot, &function) == 4) {
+            record.pci_segment = static_cast<unsigned short>(segment);
+            record.pci_bus = static_cast<unsigned char>(bus);
+            record.pci_device = static_cast<unsigned char>(slot);
+            record.pci_function = static_cast<unsigned char>(function);
+        }
+        std::string prefix = pci + "/" + device + "/aer_dev_";
+        AddCounter(prefix + "correctable", "TOTAL_ERR_COR", record);
+        record.severity = WHEA_UNCORRECTED;
+        AddCounter(prefix + "nonfatal", "TOTAL_ERR_NONFATAL", record);
+        record.severity = WHEA_FATAL;
+        AddCounter(prefix + "fatal", "TOTAL_ERR_FATAL", record);
+    }
+
+    // 能走到计数这一步的机器检查都被内核处理过了，按未纠正计
+    AddCounter(base + "/proc/interrupts", "MCE:", MakeRecord(WHEA_UNCORRECTED, SOURCE_MCE), true);
+    if (!m_counters.empty()) m_buffer.resize(INITIAL_BUFFER);
+}
+
+CLinuxHardwareErrorReader::~CLinuxHardwareErrorReader()
+{
+    for (Counter& counter : m_counters) close(counter.fd);
+}
+
+void CLinuxHardwareErrorReader::AddCounter(const std::string& path, const char* key, const CWheaRecord& record, bool per_cpu)
+{
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return;
+    Counter counter;
+    counter.fd = fd;
+    counter.key = key;
+    counter.record = record;
+    counter.per_cpu = per_cpu;
+    m_counters.push_back(counter);
+}
+
+bool CLinuxHardwareErrorReader::ReadCounter(Counter& counter, unsigned long long* value)
+{
+    for (;;) {
+        ssize_t bytes = pread(counter.fd, m_buffer.data(), m_buffer.size(), 0);
+        if (bytes < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        // 处理器很多时 /proc/interrupts 可能超过缓冲区，填满时扩容重读；之后一直复用
+        if (static_cast<size_t>(bytes) == m_buffer.size()) {
+            m_buffer.resize(m_buffer.size() * 2);
+            continue;
+        }
+        if (counter.per_cpu) return ReadPerCpuCounter(counter, static_cast<size_t>(bytes), value);
+        return ParseErrorCounter(m_buffer.data(), static_cast<size_t>(bytes), counter.key, value);
+    }
+}
+
+bool CLinuxHardwareErrorReader::ReadPerCpuCounter(Counter& counter, size_t length, unsigned long long* value)
+{
+    int count = ParseErrorColumns(m_buffer.data(), length, counter.key, m_columns.data(), static_cast<int>(m_columns.size()));
+    if (count <= 0) return false;
+    if (static_cast<size_t>(count) > m_columns.size()) {
+        m_columns.resize(count);
+        ParseErrorColumns(m_buffer.data(), length, counter.key, m_columns.data(), count);
+    }
+
+    // 同一次事件在每一列都计一次，取增量最大的一列；处理器数变化时重新取基准
+    unsigned long long delta = 0;
+    if (counter.columns.size() == static_cast<size_t>(count)) {
+        for (int i = 0; i < count; ++i) {
+            if (m_columns[i] > counter.columns[i]) delta = max(delta, m_columns[i] - counter.columns[i]);
+        }
+    }
+    counter.columns.assign(m_columns.begin(), m_columns.begin() + count);
+    counter.events += delta;
+    *value = counter.events;
+    return true;
+}
+
+bool CLinuxHardwareErrorReader::ReadNewEvents(const std::function<void(const CLogEvent&)>& on_event)
+{
+    if (m_counters.empty()) return true;
+
+    FILETIME file_time;
+    GetSystemTimeAsFileTime(&file_time);
+    CLogEvent event = {};
+    event.time = (static_cast<unsigned long long>(file_time.dwHighDateTime) << 32) | file_time.dwLowDateTime;
+    event.provider = m_provider;
+    event.has_whea = true;
+
+    for (Counter& counter : m_counters) {
+        // 设备被移除后 pread 失败，重新出现时从新的基准开始
+        unsigned long long value = 0;
+        if (!ReadCounter(counter, &value)) {
+            counter.total.Reset();
+            counter.columns.clear();
+            continue;
+        }
+        unsigned long long delta = counter.total.Update(value);
+        if (delta == 0) continue;
+        event.count = static_cast<unsigned int>(min(delta, 0xFFFFFFFFull));
+        event.level = counter.record.severity == WHEA_FATAL ? 1 : (counter.record.severity == WHEA_UNCORRECTED ? 2 : 3);
+        event.whea = counter.record;
+        event.whea.time = event.time;
+        on_event(event);
+    }
+    return true;
+}
@@ -0,0 +1,69 @@
+// CPUCoreBars/LinuxHardwareErrors.h - 基于 sysfs/procfs 累计计数的硬件错误读取器（Linux）
+#pragma once
+#include <string>
+#include <vector>
+#include <cstddef>
+#include "LogEventSource.h"
+#include "EventWindow.h"
+
+// 在 data 中找到以 key 开头的行（忽略行首空格），把 key 之后连续的十进制数相加写入 value
+// key 为空时解析整个内容开头的数字（ce_count 等单值文件）
+// /proc/interrupts 的 "MCE:" 行每个处理器一列，aer_dev_* 的 "TOTAL_ERR_*" 行只有一列
+// 找不到 key 或 key 之后没有数字时返回 false；不分配内存，不要求 data 以 0 结尾
+bool ParseErrorCounter(const char* data, size_t length, const char* key, unsigned long long* value);
+
+// 与 ParseErrorCounter 相同地找到 key，但把每一列分别写入 columns[0, max_columns)
+// 返回 key 之后的列数，可能大于 max_columns（只写入前 max_columns 列）；找不到 key 时返回 -1
+int ParseErrorColumns(const char* data, size_t length, const char* key, unsigned long long* columns, int max_columns);
+
+// =================================================================
+// Linux 上与 WHEA 对应的硬件错误来源，全部是开机以来的累计计数：
+//   EDAC   /sys/devices/system/edac/mc/mc*/ce_count、ue_count       内存控制器已纠正 / 未纠正
+//   AER    /sys/bus/pci/devices/*/aer_dev_correctable、_nonfatal、_fatal   PCIe 可纠正 / 不可纠正 / 致命
+//   MCE    /proc/interrupts 的 "MCE:" 行                            内核处理过的机器检查异常
+//          x86 的机器检查广播到所有处理器，一次事件每列都加 1，按各列增量的最大值计数
+// 文件描述符在构造时打开并一直保持，每次读取对每个文件做一次 pread
+// 计数的差值作为一条 WHEA 事件交给 CSystemErrorMonitor，沿用同一套窗口计数和错误等级
+// 首次读取只记录基准：计数没有时间戳，开机以来的旧错误无法放进 24 小时窗口
+// =================================================================
+class CLinuxHardwareErrorReader : public IEventLogReader
+{
+public:
+    // 事件记在 providers 中 WHEA_PROVIDER_NAME 的位置，列表里没有它时不打开任何文件
+    // every_update 为 true 时每次 Update 都读取（pread 的开销很小），否则按轮询间隔读取
+    // root 指向伪造的 sysfs/procfs 目录树，用于测试
+    CLinuxHardwareErrorReader(const std::vector<std::wstring>& providers, bool every_update, const char* root = "");
+    ~CLinuxHardwareErrorReader() override;
+    CLinuxHardwareErrorReader(const CLinuxHardwareErrorReader&) = delete;
+    CLinuxHardwareErrorReader& operator=(const CLinuxHardwareErrorReader&) = delete;
+
+    bool ReadNewEvents(const std::function<void(const CLogEvent&)>& on_event) override;
+    bool IsPushBased() const override { return m_every_update; }
+
+    // 打开的计数文件数，0 表示这台机器没有可用的来源
+    int GetCounterCount() const { return static_cast<int>(m_counters.size()); }
+
+private:
+    struct Counter
+    {
+        int fd;
+        const char* key;            // 指向静态字符串
+        CWheaRecord record;         // 差值事件的模板：严重程度、来源类型和 PCI 地址
+        CCounterDelta total;
+        bool per_cpu = false;                       // 每个处理器一列，取各列增量的最大值
+        std::vector<unsigned long long> columns;    // per_cpu 时上一次各列的值，为空表示还没有基准
+        unsigned long long events = 0;              // per_cpu 时累计的事件数，交给 total 计算差值
+    };
+
+    void AddCounter(const std::string& path, const char* key, const CWheaRecord& record, bool per_cpu = false);
+    bool ReadCounter(Counter& counter, unsigned long long* value);
+    bool ReadPerCpuCounter(Counter& counter, size_t length, unsigned long long* value);
+
+    std::vector<Counter> m_counters;
+    std::vector<char> m_buffer;
+    std::vector<unsigned long long> m_columns;      // 本次读到的各列，处理器数增加时才扩容
+    int m_provider = -1;
+    bool m_every_update;
+
+    static const size_t INITIAL_BUFFER = 16 * 1024;
+};
@@ -0,0 +1,138 @@
+﻿// CPUCoreBars/LinuxProcStatSampler.cpp - 基于 /proc/stat 的 CPU 使用率采样后端（Linux）
+#include "LinuxProcStatSampler.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace
+{
+    // user nice system idle iowait irq softirq steal（之后的 guest 两项已计入 user，不读取）
+    const int USED_STAT_FIELDS = 8;
+    const int MIN_STAT_FIELDS = 4;
+
+    inline bool IsDigit(char c)
+    {
+        return static_cast<unsigned char>(c - '0') < 10;
+    }
+
+    // 读取从 p 开始的十进制数并前移 p；p 必须指向数字
+    inline uint64_t ParseNumber(const char*& p, const char* end)
+    {
+        uint64_t value = 0;
+        while (p < end && IsDigit(*p)) value = value * 10 + (*p++ - '0');
+        return value;
+    }
+}
+
+int ParseProcStat(const char* data, size_t length, CCpuJiffies* times, int max_cpus, bool* complete)
+{
+    const char* p = data;
+    const char* end = data + length;
+    int parsed = 0;
+    if (complete) *complete = false;
+
+    while (p < end) {
+        // 剩余内容短于 "cpu" 加一个字符时只可能是被截断的行
+        if (end - p < 4) return parsed;
+        if (p[0] != 'c' || p[1] != 'p' || p[2] != 'u') {
+            // 第一行非 cpu 行（intr、ctxt 等），后面不会再有 cpu 行
+            if (complete) *complete = true;
+            return parsed;
+        }
+        p += 3;
+
+        bool aggregate = (*p == ' ');
+        unsigned int index = 0;
+        if (!aggregate) {
+            if (!IsDigit(*p)) return -1;
+            index = static_cast<unsigned int>(ParseNumber(p, end));
+        }
+
+        uint64_t fields[USED_STAT_FIELDS] = {};
+        int field_count = 0;
+        while (field_count < USED_STAT_FIELDS) {
+            while (p < end && *p == ' ') ++p;
+            if (p >= end || *p == '\n') break;
+            if (!IsDigit(*p)) return -1;
+            fields[field_count++] = ParseNumber(p, end);
+        }
+
+        // 跳过其余字段；没有换行结尾的最后一行视为被截断，不解析
+        const char* line_end = static_cast<const char*>(memchr(p, '\n', end - p));
+        if (!line_end) return parsed;
+        p = line_end + 1;
+
+        if (field_count < MIN_STAT_FIELDS) return -1;
+        if (aggregate || index >= static_cast<unsigned int>(max_cpus)) continue;
+        uint64_t busy = fields[0] + fields[1] + fields[2] + fields[5] + fields[6] + fields[7];
+        uint64_t idle = fields[3] + fields[4];
+        times[index].busy = busy;
+        times[index].total = busy + idle;
+        ++parsed;
+    }
+    // 恰好在行尾结束时无法确定后面是否还有 cpu 行，由调用方根据读取长度判断
+    return parsed;
+}
+
+// =================================================================
+// CLinuxProcStatSampler implementation
+// =================================================================
+CLinuxProcStatSampler::CLinuxProcStatSampler(const char* path)
+    : m_path(path)
+{
+}
+
+CLinuxProcStatSampler::~CLinuxProcStatSampler()
+{
+    if (m_fd >= 0) close(m_fd);
+}
+
+bool CLinuxProcStatSampler::Init(int num_cores)
+{
+    m_fd = open(m_path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (m_fd < 0) return false;
+    m_buffer.resize(INITIAL_BUFFER);
+    m_last.assign(num_cores, CCpuJiffies());
+    m_current.assign(num_cores, CCpuJiffies());
+    return ReadTimes(m_last);
+}
+
+bool CLinuxProcStatSampler::ReadTimes(std::vector<CCpuJiffies>& times)
+{
+    for (;;) {
+        ssize_t bytes = pread(m_fd, m_buffer.data(), m_buffer.size(), 0);
+        if (bytes < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        bool complete = false;
+        int parsed = ParseProcStat(m_buffer.data(), static_cast<size_t>(bytes), times.data(), static_cast<int>(times.size()), &complete);
+        if (parsed < 0) return false;
+        // 缓冲区被填满且 cpu 行还没结束时扩容重读；之后一直复用
+        if (!complete && static_cast<size_t>(bytes) == m_buffer.size()) {
+            m_buffer.resize(m_buffer.size() * 2);
+            continue;
+        }
+        return parsed > 0;
+    }
+}
+
+bool CLinuxProcStatSampler::Sample(double* usage, int num_cores)
+{
+    // 离线的处理器不会出现在 /proc/stat 中，沿用上一次的值使其差值为 0
+    std::copy(m_last.begin(), m_last.end(), m_current.begin());
+    if (!ReadTimes(m_current)) return false;
+
+    int count = min(num_cores, static_cast<int>(m_current.size()));
+    for (int i = 0; i < count; ++i) {
+        const CCpuJiffies& now = m_current[i];
+        const CCpuJiffies& last = m_last[i];
+        uint64_t total = (now.total > last.total) ? now.total - last.total : 0;
+        uint64_t busy = (now.busy > last.busy) ? now.busy - last.busy : 0;
+        usage[i] = total > 0 ? min(1.0, static_cast<double>(busy) / total) : 0.0;
+    }
+    m_last.swap(m_current);
+    return true;
+}
@@ -0,0 +1,53 @@
+// CPUCoreBars/LinuxProcStatSampler.h - 基于 /proc/stat 的 CPU 使用率采样后端（Linux）
+#pragma once
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cstddef>
+#include "CpuSampler.h"
+
+// =================================================================
+// 一个逻辑处理器的累计节拍数（jiffies）
+// busy = user + nice + system + irq + softirq + steal；guest 已计入 user，不再重复累加
+// =================================================================
+struct CCpuJiffies
+{
+    uint64_t busy;
+    uint64_t total;
+};
+
+// 解析 /proc/stat 内容中的 "cpuN" 行，把第 N 个处理器的节拍写入 times[N]
+// 汇总行 "cpu " 和 N >= max_cpus 的行被跳过，离线处理器对应的元素保持不变
+// 遇到第一行非 cpu 行即停止；不分配内存，不要求 data 以 0 结尾
+// complete 为 true 表示已经读到 cpu 行之后的内容，即 cpu 行没有被截断
+// 返回解析到的 cpu 行数，格式错误时返回 -1
+int ParseProcStat(const char* data, size_t length, CCpuJiffies* times, int max_cpus, bool* complete = nullptr);
+
+// =================================================================
+// /proc/stat 采样：文件描述符一直保持打开，每次采样一次 pread 读入复用的缓冲区
+// 缓冲区装不下所有 cpu 行时才扩容，之后运行期不再分配内存
+// =================================================================
+class CLinuxProcStatSampler : public ICpuSampler
+{
+public:
+    // path 可指向录制或合成的 stat 文件，用于测试
+    explicit CLinuxProcStatSampler(const char* path = "/proc/stat");
+    ~CLinuxProcStatSampler() override;
+    CLinuxProcStatSampler(const CLinuxProcStatSampler&) = delete;
+    CLinuxProcStatSampler& operator=(const CLinuxProcStatSampler&) = delete;
+
+    // 打开文件并读取一次作为基准
+    bool Init(int num_cores);
+    bool Sample(double* usage, int num_cores) override;
+
+private:
+    bool ReadTimes(std::vector<CCpuJiffies>& times);
+
+    std::string m_path;
+    int m_fd = -1;
+    std::vector<char> m_buffer;
+    std::vector<CCpuJiffies> m_last;
+    std::vector<CCpuJiffies> m_current;
+
+    static const size_t INITIAL_BUFFER = 64 * 1024;
+};
@@ -0,0 +1,34 @@
+// CPUCoreBars/LogEventSource.h - 事件日志读取接口（不依赖 Windows API）
+#pragma once
+#include <functional>
+#include "WheaRecords.h"
+
+// =================================================================
+// 一条事件中计数需要的字段
+// =================================================================
+struct CLogEvent
+{
+    unsigned long long time;    // 创建时间（FILETIME，100ns）
+    int provider;               // 在读取器来源列表中的下标
+    unsigned short event_id;
+    unsigned char level;        // 1 严重 / 2 错误 / 3 警告
+    unsigned int count;         // 同一时刻发生的次数，日志事件为 1，累计计数器为差值
+    bool has_whea;              // 来源是 WHEA-Logger 时解析出 whea
+    CWheaRecord whea;
+};
+
+// =================================================================
+// 事件日志读取接口：每次只返回上一次读取之后的新事件
+// 计数和窗口逻辑只依赖这个接口，可以换成录制或合成的事件源
+// =================================================================
+class IEventLogReader
+{
+public:
+    virtual ~IEventLogReader() = default;
+
+    // 按时间顺序回调每个新事件；返回 false 表示读取器已经失效，需要重建
+    virtual bool ReadNewEvents(const std::function<void(const CLogEvent&)>& on_event) = 0;
+
+    // 推送式读取器的 ReadNewEvents 只取走已到达的事件，可以每次采样都调用
+    virtual bool IsPushBased() const { return false; }
+};
@@ -0,0 +1,112 @@
+﻿// CPUCoreBars/PdhSampler.cpp - 基于 PDH 的 CPU 使用率采样后端
+#include "PdhSampler.h"
+#include <PdhMsg.h>
+
+#pragma comment(lib, "pdh.lib")
+
+// =================================================================
+// CPdhArraySampler implementation
+// =================================================================
+CPdhArraySampler::CPdhArraySampler(const CCpuTopology& topology)
+    : m_topology(topology)
+{
+}
+
+CPdhArraySampler::~CPdhArraySampler()
+{
+    if (m_query) PdhCloseQuery(m_query);
+}
+
+bool CPdhArraySampler::Init()
+{
+    if (PdhOpenQuery(nullptr, 0, &m_query) != ERROR_SUCCESS) {
+        m_query = nullptr;
+        return false;
+    }
+    // 使用英文计数器名，避免本地化系统上添加失败
+    if (PdhAddEnglishCounterW(m_query, L"\\Processor Information(*)\\% Processor Time", 0, &m_counter) != ERROR_SUCCESS) {
+        PdhCloseQuery(m_query);
+        m_query = nullptr;
+        return false;
+    }
+    PdhCollectQueryData(m_query);
+    return true;
+}
+
+bool CPdhArraySampler::Sample(double* usage, int num_cores)
+{
+    if (PdhCollectQueryData(m_query) != ERROR_SUCCESS) return false;
+
+    DWORD buffer_size = static_cast<DWORD>(m_buffer.size());
+    DWORD item_count = 0;
+    PDH_STATUS status = PdhGetFormattedCounterArrayW(m_counter, PDH_FMT_DOUBLE, &buffer_size, &item_count,
+        reinterpret_cast<PPDH_FMT_COUNTERVALUE_ITEM_W>(m_buffer.data()));
+    if (status == PDH_MORE_DATA) {
+        // 只在核心数或实例名变化时扩容，之后一直复用
+        m_buffer.resize(buffer_size);
+        status = PdhGetFormattedCounterArrayW(m_counter, PDH_FMT_DOUBLE, &buffer_size, &item_count,
+            reinterpret_cast<PPDH_FMT_COUNTERVALUE_ITEM_W>(m_buffer.data()));
+    }
+    if (status != ERROR_SUCCESS) return false;
+
+    const PDH_FMT_COUNTERVALUE_ITEM_W* items = reinterpret_cast<const PDH_FMT_COUNTERVALUE_ITEM_W*>(m_buffer.data());
+    for (DWORD i = 0; i < item_count; ++i) {
+        // 实例名格式为 "组,编号"，跳过 "_Total" 和 "0,_Total" 等汇总实例
+        const wchar_t* p = items[i].szName;
+        if (!p || *p < L'0' || *p > L'9') continue;
+        int group = 0;
+        while (*p >= L'0' && *p <= L'9') group = group * 10 + (*p++ - L'0');
+        if (*p++ != L',' || *p < L'0' || *p > L'9') continue;
+        int number = 0;
+        while (*p >= L'0' && *p <= L'9') number = number * 10 + (*p++ - L'0');
+        if (*p != L'\0' || group > 0xFFFF || number > 0xFF) continue;
+
+        int core_index = m_topology.GetGlobalIndex(static_cast<WORD>(group), static_cast<BYTE>(number));
+        if (core_index < 0 || core_index >= num_cores) continue;
+        const PDH_FMT_COUNTERVALUE& value = items[i].FmtValue;
+        bool valid = (value.CStatus == PDH_CSTATUS_VALID_DATA || value.CStatus == PDH_CSTATUS_NEW_DATA);
+        usage[core_index] = valid ? max(0.0, min(1.0, value.doubleValue / 100.0)) : 0.0;
+    }
+    return true;
+}
+
+// =================================================================
+// CPdhCounterSampler implementation
+// =================================================================
+CPdhCounterSampler::~CPdhCounterSampler()
+{
+    if (m_query) PdhCloseQuery(m_query);
+}
+
+bool CPdhCounterSampler::Init(int num_cores)
+{
+    if (PdhOpenQuery(nullptr, 0, &m_query) != ERROR_SUCCESS) {
+        m_query = nullptr;
+        return false;
+    }
+    m_counters.resize(num_cores);
+    for (int i = 0; i < num_cores; ++i)
+    {
+        wchar_t counter_path[128];
+        swprintf_s(counter_path, L"\\Processor(%d)\\%% Processor Time", i);
+        PdhAddCounterW(m_query, counter_path, 0, &m_counters[i]);
+    }
+    PdhCollectQueryData(m_query);
+    return true;
+}
+
+bool CPdhCounterSampler::Sample(double* usage, int num_cores)
+{
+    if (PdhCollectQueryData(m_query) != ERROR_SUCCESS) return false;
+
+    int count = min(num_cores, static_cast<int>(m_counters.size()));
+    for (int i = 0; i < count; ++i) {
+        PDH_FMT_COUNTERVALUE value;
+        if (PdhGetFormattedCounterValue(m_counters[i], PDH_FMT_DOUBLE, nullptr, &value) == ERROR_SUCCESS) {
+            usage[i] = max(0.0, min(1.0, value.doubleValue / 100.0));
+        } else {
+            usage[i] = 0.0;
+        }
+    }
+    return true;
+}
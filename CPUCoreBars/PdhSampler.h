@@ -0,0 +1,41 @@
+// CPUCoreBars/PdhSampler.h - 基于 PDH 的 CPU 使用率采样后端
+#pragma once
+#include "Platform.h"
+#include <Pdh.h>
+#include "CpuSampler.h"
+
+// =================================================================
+// PDH 通配符计数器：一次数组读取取回所有核心
+// =================================================================
+class CPdhArraySampler : public ICpuSampler
+{
+public:
+    explicit CPdhArraySampler(const CCpuTopology& topology);
+    ~CPdhArraySampler() override;
+
+    bool Init();
+    bool Sample(double* usage, int num_cores) override;
+
+private:
+    PDH_HQUERY m_query = nullptr;
+    PDH_HCOUNTER m_counter = nullptr;
+    std::vector<BYTE> m_buffer;         // 复用的数组缓冲区
+    const CCpuTopology& m_topology;     // 实例名 "组,编号" -> 全局索引
+};
+
+// =================================================================
+// PDH 每核心计数器：旧系统上的回退方案
+// =================================================================
+class CPdhCounterSampler : public ICpuSampler
+{
+public:
+    CPdhCounterSampler() = default;
+    ~CPdhCounterSampler() override;
+
+    bool Init(int num_cores);
+    bool Sample(double* usage, int num_cores) override;
+
+private:
+    PDH_HQUERY m_query = nullptr;
+    std::vector<PDH_HCOUNTER> m_counters;
+};
@@ -0,0 +1,59 @@
+﻿// CPUCoreBars/PixelCanvas.cpp - 与平台无关的 32 位像素缓冲区
+#include "PixelCanvas.h"
+#include <algorithm>
+
+void CPixelCanvas::Resize(int width, int height)
+{
+    width = (std::max)(0, width);
+    height = (std::max)(0, height);
+    if (width == m_width && height == m_height) return;
+    m_width = width;
+    m_height = height;
+    m_pixels.resize(static_cast<size_t>(width) * height);
+}
+
+void CPixelCanvas::Clear(uint32_t color)
+{
+    std::fill(m_pixels.begin(), m_pixels.end(), color);
+}
+
+void CPixelCanvas::FillRect(int left, int top, int right, int bottom, uint32_t color)
+{
+    left = (std::max)(left, 0);
+    top = (std::max)(top, 0);
+    right = (std::min)(right, m_width);
+    bottom = (std::min)(bottom, m_height);
+    if (left >= right || top >= bottom) return;
+
+    uint32_t* row = m_pixels.data() + static_cast<size_t>(top) * m_width;
+    if (left == 0 && right == m_width) {
+        // 整行宽度时各行连续，一次填完
+        std::fill_n(row, static_cast<size_t>(bottom - top) * m_width, color);
+        return;
+    }
+    for (int y = top; y < bottom; ++y, row += m_width) {
+        std::fill(row + left, row + right, color);
+    }
+}
+
+void CPixelCanvas::FrameRect(int left, int top, int right, int bottom, uint32_t color)
+{
+    if (left >= right || top >= bottom) return;
+    FillRect(left, top, right, top + 1, color);
+    FillRect(left, bottom - 1, right, bottom, color);
+    FillRect(left, top + 1, left + 1, bottom - 1, color);
+    FillRect(right - 1, top + 1, right, bottom - 1, color);
+}
+
+void CPixelCanvas::DrawMask(int left, int top, const uint8_t* rows, int width, int height, uint32_t color)
+{
+    for (int i = 0; i < height; ++i) {
+        int y = top + i;
+        if (y < 0 || y >= m_height) continue;
+        uint32_t* row = m_pixels.data() + static_cast<size_t>(y) * m_width;
+        for (int j = 0; j < width; ++j) {
+            int x = left + j;
+            if (x >= 0 && x < m_width && ((rows[i] >> (width - 1 - j)) & 1)) row[x] = color;
+        }
+    }
+}
@@ -0,0 +1,31 @@
+// CPUCoreBars/PixelCanvas.h - 与平台无关的 32 位像素缓冲区
+#pragma once
+#include <vector>
+#include <cstdint>
+
+// =================================================================
+// 自上而下存放的 0x00RRGGBB 像素（与 32 位 DIB 的内存布局一致）
+// 只做矩形/单色位图填充，所有写入都裁剪到画布内
+// =================================================================
+class CPixelCanvas
+{
+public:
+    // 尺寸不变时不重新分配
+    void Resize(int width, int height);
+
+    void Clear(uint32_t color);
+    void FillRect(int left, int top, int right, int bottom, uint32_t color);
+    void FrameRect(int left, int top, int right, int bottom, uint32_t color);
+
+    // 绘制单色位图：rows[i] 的第 (width-1-j) 位为 1 时在 (left+j, top+i) 画点
+    void DrawMask(int left, int top, const uint8_t* rows, int width, int height, uint32_t color);
+
+    int GetWidth() const { return m_width; }
+    int GetHeight() const { return m_height; }
+    const uint32_t* GetPixels() const { return m_pixels.data(); }
+
+private:
+    std::vector<uint32_t> m_pixels;
+    int m_width = 0;
+    int m_height = 0;
+};
@@ -0,0 +1,134 @@
+﻿// CPUCoreBars/Platform.cpp - 可移植核心用到的 Win32 子集（非 Windows 实现）
+#include "Platform.h"
+
+#ifndef _WIN32
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <climits>
+#include <cstdlib>
+#include <dlfcn.h>
+
+namespace
+{
+    // 所有事件共用一把锁和一个条件变量：句柄数量很少，唤醒后各自重新检查即可
+    struct CEventObject
+    {
+        bool manual_reset;
+        bool signaled;
+    };
+
+    std::mutex s_event_mutex;
+    std::condition_variable s_event_cv;
+
+    // 检查是否有已置位的事件，自动重置的事件被取走后复位
+    bool TryAcquire(DWORD count, const HANDLE* handles, DWORD& index)
+    {
+        for (DWORD i = 0; i < count; ++i) {
+            CEventObject* event = static_cast<CEventObject*>(handles[i]);
+            if (!event->signaled) continue;
+            if (!event->manual_reset) event->signaled = false;
+            index = i;
+            return true;
+        }
+        return false;
+    }
+}
+
+ULONGLONG GetTickCount64()
+{
+    auto now = std::chrono::steady_clock::now().time_since_epoch();
+    return static_cast<ULONGLONG>(std::chrono::duration_cast<std::chrono::milliseconds>(now).count());
+}
+
+DWORD GetTickCount()
+{
+    return static_cast<DWORD>(GetTickCount64());
+}
+
+void GetSystemTimeAsFileTime(FILETIME* file_time)
+{
+    // FILETIME 从 1601-01-01 起计，单位 100ns
+    const ULONGLONG UNIX_EPOCH_OFFSET = 116444736000000000ull;
+    auto now = std::chrono::system_clock::now().time_since_epoch();
+    ULONGLONG ticks = static_cast<ULONGLONG>(std::chrono::duration_cast<std::chrono::nanoseconds>(now).count() / 100) + UNIX_EPOCH_OFFSET;
+    file_time->dwLowDateTime = static_cast<DWORD>(ticks);
+    file_time->dwHighDateTime = static_cast<DWORD>(ticks >> 32);
+}
+
+void Sleep(DWORD ms)
+{
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+HANDLE CreateEventW(void*, BOOL manual_reset, BOOL initial_state, const wchar_t*)
+{
+    return new CEventObject{ manual_reset != FALSE, initial_state != FALSE };
+}
+
+BOOL SetEvent(HANDLE event)
+{
+    if (!event) return FALSE;
+    {
+        std::lock_guard<std::mutex> lock(s_event_mutex);
+        static_cast<CEventObject*>(event)->signaled = true;
+    }
+    s_event_cv.notify_all();
+    return TRUE;
+}
+
+BOOL ResetEvent(HANDLE event)
+{
+    if (!event) return FALSE;
+    std::lock_guard<std::mutex> lock(s_event_mutex);
+    static_cast<CEventObject*>(event)->signaled = false;
+    return TRUE;
+}
+
+BOOL CloseHandle(HANDLE handle)
+{
+    if (!handle) return FALSE;
+    delete static_cast<CEventObject*>(handle);
+    return TRUE;
+}
+
+DWORD WaitForSingleObject(HANDLE handle, DWORD ms)
+{
+    return WaitForMultipleObjects(1, &handle, FALSE, ms);
+}
+
+DWORD WaitForMultipleObjects(DWORD count, const HANDLE* handles, BOOL wait_all, DWORD ms)
+{
+    if (wait_all || count == 0) return WAIT_FAILED;
+    DWORD index = 0;
+    std::unique_lock<std::mutex> lock(s_event_mutex);
+    if (ms == INFINITE) {
+        s_event_cv.wait(lock, [&]() { return TryAcquire(count, handles, index); });
+        return WAIT_OBJECT_0 + index;
+    }
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(ms);
+    if (!s_event_cv.wait_until(lock, deadline, [&]() { return TryAcquire(count, handles, index); })) return WAIT_TIMEOUT;
+    return WAIT_OBJECT_0 + index;
+}
+
+HMODULE LoadLibraryW(const wchar_t* path)
+{
+    std::string narrow(wcslen(path) * MB_LEN_MAX + 1, '\0');
+    size_t length = wcstombs(&narrow[0], path, narrow.size());
+    if (length == static_cast<size_t>(-1)) return nullptr;
+    narrow.resize(length);
+    return dlopen(narrow.c_str(), RTLD_NOW | RTLD_LOCAL);
+}
+
+FARPROC GetProcAddress(HMODULE module, const char* name)
+{
+    return module ? dlsym(module, name) : nullptr;
+}
+
+BOOL FreeLibrary(HMODULE module)
+{
+    return module && dlclose(module) == 0;
+}
+#endif
@@ -0,0 +1,184 @@
+// CPUCoreBars/Platform.h - 可移植核心用到的 Win32 子集
+#pragma once
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+// =================================================================
+// 非 Windows 平台：只提供采样核心实际用到的类型和函数
+// 让拓扑、采样线程、NVML 轮询等代码原样在 Linux 上编译和测试
+// 实现见 Platform.cpp；函数语义与同名 Win32 API 保持一致
+// =================================================================
+#include <cstdint>
+#include <cstddef>
+#include <cstdio>
+#include <cwchar>
+#include <strings.h>
+
+#define WINAPI
+#define TRUE 1
+#define FALSE 0
+#define MAX_PATH 260
+#define INFINITE 0xFFFFFFFFu
+#define WAIT_OBJECT_0 0u
+#define WAIT_TIMEOUT 258u
+#define WAIT_FAILED 0xFFFFFFFFu
+#define ANYSIZE_ARRAY 1
+#define ARRAYSIZE(a) (sizeof(a) / sizeof((a)[0]))
+#define _TRUNCATE (static_cast<size_t>(-1))
+
+typedef int BOOL;
+typedef uint8_t BYTE;
+typedef uint16_t WORD;
+typedef uint32_t DWORD;
+typedef uint64_t ULONGLONG;
+typedef uintptr_t ULONG_PTR;
+typedef uint64_t KAFFINITY;
+typedef uint32_t COLORREF;
+typedef void* HANDLE;
+typedef void* HMODULE;
+typedef void* FARPROC;
+
+#define RGB(r, g, b) (static_cast<COLORREF>(static_cast<BYTE>(r) | (static_cast<WORD>(static_cast<BYTE>(g)) << 8) | (static_cast<DWORD>(static_cast<BYTE>(b)) << 16)))
+#define GetRValue(rgb) (static_cast<BYTE>(rgb))
+#define GetGValue(rgb) (static_cast<BYTE>((rgb) >> 8))
+#define GetBValue(rgb) (static_cast<BYTE>((rgb) >> 16))
+#define CLR_INVALID 0xFFFFFFFFu
+
+// windows.h 的 min/max 是宏；这里用模板，避免破坏随后包含的标准库头文件
+template <typename T> inline T min(T a, T b) { return b < a ? b : a; }
+template <typename T> inline T max(T a, T b) { return a < b ? b : a; }
+
+struct FILETIME
+{
+    DWORD dwLowDateTime;
+    DWORD dwHighDateTime;
+};
+
+// -----------------------------------------------------------------
+// GetLogicalProcessorInformationEx 的数据结构，布局与 x64 Windows 相同
+// 在 Windows 上录制的缓冲区可以直接交给 CCpuTopology::LoadFromBuffer
+// -----------------------------------------------------------------
+enum LOGICAL_PROCESSOR_RELATIONSHIP
+{
+    RelationProcessorCore = 0,
+    RelationNumaNode = 1,
+    RelationCache = 2,
+    RelationProcessorPackage = 3,
+    RelationGroup = 4,
+    RelationAll = 0xffff
+};
+
+struct GROUP_AFFINITY
+{
+    KAFFINITY Mask;
+    WORD Group;
+    WORD Reserved[3];
+};
+
+struct PROCESSOR_RELATIONSHIP
+{
+    BYTE Flags;
+    BYTE EfficiencyClass;
+    BYTE Reserved[20];
+    WORD GroupCount;
+    GROUP_AFFINITY GroupMask[ANYSIZE_ARRAY];
+};
+
+struct PROCESSOR_GROUP_INFO
+{
+    BYTE MaximumProcessorCount;
+    BYTE ActiveProcessorCount;
+    BYTE Reserved[38];
+    KAFFINITY ActiveProcessorMask;
+};
+
+struct GROUP_RELATIONSHIP
+{
+    WORD MaximumGroupCount;
+    WORD ActiveGroupCount;
+    BYTE Reserved[20];
+    PROCESSOR_GROUP_INFO GroupInfo[ANYSIZE_ARRAY];
+};
+
+struct SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX
+{
+    LOGICAL_PROCESSOR_RELATIONSHIP Relationship;
+    DWORD Size;
+    union
+    {
+        PROCESSOR_RELATIONSHIP Processor;
+        GROUP_RELATIONSHIP Group;
+    };
+};
+
+// -----------------------------------------------------------------
+// 时间
+// -----------------------------------------------------------------
+ULONGLONG GetTickCount64();
+DWORD GetTickCount();
+void GetSystemTimeAsFileTime(FILETIME* file_time);
+void Sleep(DWORD ms);
+
+// -----------------------------------------------------------------
+// 事件对象：只支持 CreateEventW 创建的句柄
+// WaitForMultipleObjects 只支持 wait_all 为 FALSE
+// -----------------------------------------------------------------
+HANDLE CreateEventW(void* attributes, BOOL manual_reset, BOOL initial_state, const wchar_t* name);
+BOOL SetEvent(HANDLE event);
+BOOL ResetEvent(HANDLE event);
+BOOL CloseHandle(HANDLE handle);
+DWORD WaitForSingleObject(HANDLE handle, DWORD ms);
+DWORD WaitForMultipleObjects(DWORD count, const HANDLE* handles, BOOL wait_all, DWORD ms);
+
+// -----------------------------------------------------------------
+// 动态库：dlopen/dlsym，路径按 UTF-8 转换
+// -----------------------------------------------------------------
+HMODULE LoadLibraryW(const wchar_t* path);
+FARPROC GetProcAddress(HMODULE module, const char* name);
+BOOL FreeLibrary(HMODULE module);
+
+// -----------------------------------------------------------------
+// 安全 CRT 的数组版本：总是截断并以 0 结尾
+// -----------------------------------------------------------------
+template <size_t N>
+inline int strcpy_s(char (&dest)[N], const char* src)
+{
+    snprintf(dest, N, "%s", src);
+    return 0;
+}
+
+template <size_t N, typename... Args>
+inline int sprintf_s(char (&dest)[N], const char* format, Args... args)
+{
+    return snprintf(dest, N, format, args...);
+}
+
+template <size_t N, typename... Args>
+inline int swprintf_s(wchar_t (&dest)[N], const wchar_t* format, Args... args)
+{
+    return swprintf(dest, N, format, args...);
+}
+
+template <size_t N>
+inline int wcscpy_s(wchar_t (&dest)[N], const wchar_t* src)
+{
+    wcsncpy(dest, src, N - 1);
+    dest[N - 1] = L'\0';
+    return 0;
+}
+
+template <size_t N>
+inline int wcsncpy_s(wchar_t (&dest)[N], const wchar_t* src, size_t count)
+{
+    size_t length = (count == _TRUNCATE || count > N - 1) ? N - 1 : count;
+    wcsncpy(dest, src, length);
+    dest[length] = L'\0';
+    return 0;
+}
+
+inline int _wcsicmp(const wchar_t* a, const wchar_t* b)
+{
+    return wcscasecmp(a, b);
+}
+#endif
@@ -0,0 +1,100 @@
+﻿// CPUCoreBars/PluginSettings.cpp - 插件配置（保存在主程序配置目录下的 ini 文件中）
+#include "PluginSettings.h"
+
+namespace
+{
+    const wchar_t* const DEFAULT_ERROR_PROVIDERS =
+        L"Microsoft-Windows-WHEA-Logger,nvlddmkm,disk,volmgr,storahci,Microsoft-Windows-Kernel-Power";
+
+    void ParseProviderList(const wchar_t* text, std::vector<std::wstring>& providers)
+    {
+        providers.clear();
+        std::wstring item;
+        for (const wchar_t* p = text; ; ++p) {
+            if (*p == L',' || *p == L'\0') {
+                // 去掉首尾空白；单引号会破坏 XPath，直接丢弃该项
+                size_t first = item.find_first_not_of(L" \t");
+                size_t last = item.find_last_not_of(L" \t");
+                if (first != std::wstring::npos && item.find(L'\'') == std::wstring::npos
+                    && providers.size() < CPluginSettings::MAX_ERROR_PROVIDERS) {
+                    providers.push_back(item.substr(first, last - first + 1));
+                }
+                item.clear();
+                if (*p == L'\0') break;
+            } else {
+                item += *p;
+            }
+        }
+    }
+}
+
+CPluginSettings::CPluginSettings()
+{
+    ParseProviderList(DEFAULT_ERROR_PROVIDERS, error_providers);
+}
+
+void CPluginSettings::Load(const wchar_t* config_dir)
+{
+    if (!config_dir || !*config_dir) return;
+    size_t len = wcslen(config_dir);
+    bool has_slash = (config_dir[len - 1] == L'\\' || config_dir[len - 1] == L'/');
+    swprintf_s(m_ini_path, L"%s%sCPUCoreBars.ini", config_dir, has_slash ? L"" : L"\\");
+
+    high_freq_enabled = GetPrivateProfileIntW(L"cpu", L"high_freq_enabled", high_freq_enabled, m_ini_path) != 0;
+    high_freq_hz = GetPrivateProfileIntW(L"cpu", L"high_freq_hz", high_freq_hz, m_ini_path);
+    high_freq_hz = max(MIN_HIGH_FREQ_HZ, min(MAX_HIGH_FREQ_HZ, high_freq_hz));
+    sparkline_mode = GetPrivateProfileIntW(L"cpu", L"sparkline_mode", sparkline_mode, m_ini_path) != 0;
+    gpu_field_mask = GetPrivateProfileIntW(L"gpu", L"field_mask", gpu_field_mask, m_ini_path) & GPU_FIELD_ALL;
+    gpu_color_by_violation = GetPrivateProfileIntW(L"gpu", L"color_by_violation", gpu_color_by_violation, m_ini_path) != 0;
+    gpu_show_bar1 = GetPrivateProfileIntW(L"gpu", L"show_bar1", gpu_show_bar1, m_ini_path) != 0;
+    wchar_t nvml[MAX_PATH];
+    GetPrivateProfileStringW(L"gpu", L"nvml_path", L"", nvml, ARRAYSIZE(nvml), m_ini_path);
+    nvml_path = nvml;
+    error_subscription = GetPrivateProfileIntW(L"errors", L"subscribe", error_subscription, m_ini_path) != 0;
+    wchar_t providers[1024];
+    GetPrivateProfileStringW(L"errors", L"providers", DEFAULT_ERROR_PROVIDERS, providers, ARRAYSIZE(providers), m_ini_path);
+    ParseProviderList(providers, error_providers);
+}
+
+void CPluginSettings::Save() const
+{
+    if (!m_ini_path[0]) return;
+    wchar_t buff[16];
+    WritePrivateProfileStringW(L"cpu", L"high_freq_enabled", high_freq_enabled ? L"1" : L"0", m_ini_path);
+    swprintf_s(buff, L"%d", high_freq_hz);
+    WritePrivateProfileStringW(L"cpu", L"high_freq_hz", buff, m_ini_path);
+    WritePrivateProfileStringW(L"cpu", L"sparkline_mode", sparkline_mode ? L"1" : L"0", m_ini_path);
+    swprintf_s(buff, L"%u", gpu_field_mask);
+    WritePrivateProfileStringW(L"gpu", L"field_mask", buff, m_ini_path);
+    WritePrivateProfileStringW(L"gpu", L"color_by_violation", gpu_color_by_violation ? L"1" : L"0", m_ini_path);
+    WritePrivateProfileStringW(L"gpu", L"show_bar1", gpu_show_bar1 ? L"1" : L"0", m_ini_path);
+    WritePrivateProfileStringW(L"gpu", L"nvml_path", nvml_path.c_str(), m_ini_path);
+    WritePrivateProfileStringW(L"errors", L"subscribe", error_subscription ? L"1" : L"0", m_ini_path);
+    std::wstring providers;
+    for (const std::wstring& provider : error_providers) {
+        if (!providers.empty()) providers += L",";
+        providers += provider;
+    }
+    WritePrivateProfileStringW(L"errors", L"providers", providers.c_str(), m_ini_path);
+}
+
+double CPluginSettings::LoadGpuEnergy(const char* bus_id) const
+{
+    if (!IsLoaded()) return 0.0;
+    wchar_t key[64], value[32];
+    size_t converted = 0;
+    mbstowcs_s(&converted, key, bus_id, _TRUNCATE);
+    GetPrivateProfileStringW(L"energy", key, L"0", value, ARRAYSIZE(value), m_ini_path);
+    double kwh = wcstod(value, nullptr);
+    return kwh > 0.0 ? kwh : 0.0;
+}
+
+void CPluginSettings::SaveGpuEnergy(const char* bus_id, double kwh) const
+{
+    if (!IsLoaded()) return;
+    wchar_t key[64], value[32];
+    size_t converted = 0;
+    mbstowcs_s(&converted, key, bus_id, _TRUNCATE);
+    swprintf_s(value, L"%.6f", kwh);
+    WritePrivateProfileStringW(L"energy", key, value, m_ini_path);
+}
@@ -0,0 +1,55 @@
+// CPUCoreBars/PluginSettings.h - 插件配置（保存在主程序配置目录下的 ini 文件中）
+#pragma once
+#include <windows.h>
+#include <string>
+#include <vector>
+#include "GpuMonitor.h"
+
+class CPluginSettings
+{
+public:
+    // 由 OnExtenedInfo(EI_CONFIG_DIR) 调用
+    void Load(const wchar_t* config_dir);
+    void Save() const;
+
+    // 高频采样：在两次 DataRequired 之间以 high_freq_hz 采样，并统计峰值/均值/P95
+    bool high_freq_enabled = false;
+    int high_freq_hz = 50;
+
+    // 核心项绘制为历史曲线而不是条形图
+    bool sparkline_mode = false;
+
+    // 每次轮询批量读取的 GPU 遥测字段（GpuTelemetryField 位掩码）
+    unsigned int gpu_field_mask = GPU_FIELD_ALL;
+
+    // 加载的 NVML 库路径，空表示系统的 nvml.dll；可指向实现同一组导出函数的替身库
+    std::wstring nvml_path;
+
+    // GPU 状态项按间隔内降频时间占比着色，而不是按当前的原因位
+    bool gpu_color_by_violation = false;
+
+    // 显存项同时显示 BAR1 占用（每次轮询多一次 NVML 调用）
+    bool gpu_show_bar1 = false;
+
+    // 用 EvtSubscribe 实时接收系统错误事件，关闭时每 60 秒增量查询一次
+    bool error_subscription = true;
+
+    // System 日志中计为系统错误的事件来源，合并为一次查询
+    std::vector<std::wstring> error_providers;
+    static const int MAX_ERROR_PROVIDERS = 16;
+
+    CPluginSettings();
+
+    // 配置目录已知后才能读写 ini
+    bool IsLoaded() const { return m_ini_path[0] != L'\0'; }
+
+    // 每个 GPU 的累计能耗 (kWh)，按 PCI 总线号保存在 [energy] 节
+    double LoadGpuEnergy(const char* bus_id) const;
+    void SaveGpuEnergy(const char* bus_id, double kwh) const;
+
+    static const int MIN_HIGH_FREQ_HZ = 5;
+    static const int MAX_HIGH_FREQ_HZ = 100;
+
+private:
+    wchar_t m_ini_path[MAX_PATH] = {};
+};
@@ -0,0 +1,42 @@
+﻿// CPUCoreBars/SamplerThread.cpp - 后台采样线程与快照发布
+#include "SamplerThread.h"
+
+CSamplerThread::~CSamplerThread()
+{
+    Stop();
+}
+
+void CSamplerThread::Start(DWORD interval_ms, std::function<void()> tick)
+{
+    if (m_thread.joinable()) return;
+    m_interval_ms.store(interval_ms, std::memory_order_relaxed);
+    m_tick = std::move(tick);
+    m_stop_event = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+    if (!m_stop_event) return;
+    m_thread = std::thread(&CSamplerThread::Run, this);
+}
+
+void CSamplerThread::Stop()
+{
+    if (m_stop_event) SetEvent(m_stop_event);
+    if (m_thread.joinable()) m_thread.join();
+    if (m_stop_event) {
+        CloseHandle(m_stop_event);
+        m_stop_event = nullptr;
+    }
+}
+
+void CSamplerThread::Run()
+{
+    // 按绝对时间排期，避免采样耗时累积成漂移
+    ULONGLONG next_tick = GetTickCount64();
+    for (;;) {
+        m_tick();
+
+        next_tick += m_interval_ms.load(std::memory_order_relaxed);
+        ULONGLONG now = GetTickCount64();
+        if (next_tick < now) next_tick = now;   // 落后太多时不补采
+        DWORD wait_ms = static_cast<DWORD>(next_tick - now);
+        if (WaitForSingleObject(m_stop_event, wait_ms) == WAIT_OBJECT_0) break;
+    }
+}
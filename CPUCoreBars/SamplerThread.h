@@ -0,0 +1,71 @@
+// CPUCoreBars/SamplerThread.h - 后台采样线程与快照发布
+#pragma once
+#include "Platform.h"
+#include <atomic>
+#include <thread>
+#include <functional>
+
+// =================================================================
+// 三缓冲快照：单写单读，双方都不会阻塞
+// 写线程填好 WriteBuffer() 后调用 Publish()；读线程用 Read() 取最新一份
+// =================================================================
+template <typename T>
+class CTripleBuffer
+{
+public:
+    // 预先初始化所有槽位（如预分配 vector），之后发布过程不再分配内存
+    template <typename F>
+    void InitSlots(F init)
+    {
+        for (T& slot : m_slots) init(slot);
+    }
+
+    T& WriteBuffer() { return m_slots[m_back]; }
+
+    void Publish()
+    {
+        m_back = m_middle.exchange(m_back | FRESH_BIT, std::memory_order_acq_rel) & INDEX_MASK;
+    }
+
+    // 有新快照时换入，否则返回上一次读到的快照
+    const T& Read()
+    {
+        if (m_middle.load(std::memory_order_relaxed) & FRESH_BIT) {
+            m_front = m_middle.exchange(m_front, std::memory_order_acq_rel) & INDEX_MASK;
+        }
+        return m_slots[m_front];
+    }
+
+private:
+    static const int INDEX_MASK = 0x3;
+    static const int FRESH_BIT = 0x4;
+
+    T m_slots[3];
+    std::atomic<int> m_middle{ 1 };
+    int m_back = 0;     // 仅写线程访问
+    int m_front = 2;    // 仅读线程访问
+};
+
+// =================================================================
+// 采样线程：按固定周期调用回调，停止时可立即唤醒
+// =================================================================
+class CSamplerThread
+{
+public:
+    CSamplerThread() = default;
+    ~CSamplerThread();
+    CSamplerThread(const CSamplerThread&) = delete;
+    CSamplerThread& operator=(const CSamplerThread&) = delete;
+
+    void Start(DWORD interval_ms, std::function<void()> tick);
+    void Stop();
+    void SetInterval(DWORD interval_ms) { m_interval_ms.store(interval_ms, std::memory_order_relaxed); }
+
+private:
+    void Run();
+
+    std::thread m_thread;
+    HANDLE m_stop_event = nullptr;
+    std::atomic<DWORD> m_interval_ms{ 1000 };
+    std::function<void()> m_tick;
+};
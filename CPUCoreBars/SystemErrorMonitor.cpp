@@ -0,0 +1,95 @@
+﻿// CPUCoreBars/SystemErrorMonitor.cpp - 事件日志错误的窗口计数与错误等级（不依赖 Windows API）
+#include "SystemErrorMonitor.h"
+#include "Platform.h"
+
+void CSystemErrorMonitor::Configure(const std::vector<std::wstring>& providers, bool subscribe)
+{
+    m_reader.reset();
+    m_providers = providers;
+    m_subscribe = subscribe;
+    m_whea_provider = -1;
+    for (size_t i = 0; i < m_providers.size(); ++i) {
+        if (_wcsicmp(m_providers[i].c_str(), WHEA_PROVIDER_NAME) == 0) m_whea_provider = static_cast<int>(i);
+    }
+    m_windows.assign(m_providers.size(), CEventWindowCounter());
+    m_whea_log.Reset();
+    m_checked = false;
+    m_level = SYSTEM_ERROR_NONE;
+}
+
+void CSystemErrorMonitor::SetSuppressed(const wchar_t* provider, bool suppressed)
+{
+    auto it = m_suppressed.begin();
+    while (it != m_suppressed.end() && _wcsicmp(it->c_str(), provider) != 0) ++it;
+    if (suppressed == (it != m_suppressed.end())) return;
+    if (suppressed) m_suppressed.push_back(provider);
+    else m_suppressed.erase(it);
+    m_reader.reset();
+    m_checked = false;
+}
+
+void CSystemErrorMonitor::Update(unsigned long long tick_ms, unsigned long long now)
+{
+    bool push_mode = m_reader && m_reader->IsPushBased();
+    if (push_mode || !m_checked || tick_ms - m_last_check_tick >= POLL_INTERVAL_MS) {
+        // 订阅出错时立即改用书签轮询重读，不等下一个轮询周期
+        if (!ReadEvents() && push_mode) ReadEvents();
+        m_last_check_tick = tick_ms;
+        m_checked = true;
+    }
+
+    for (CEventWindowCounter& window : m_windows) window.Advance(now);
+    m_whea_log.Advance(now);
+
+    // WHEA 按严重程度分级，其他来源的错误统一视为 SYSTEM_ERROR_ERROR
+    m_level = SYSTEM_ERROR_NONE;
+    for (size_t i = 0; i < m_windows.size(); ++i) {
+        if (static_cast<int>(i) != m_whea_provider && m_windows[i].GetCount() > 0) m_level = SYSTEM_ERROR_ERROR;
+    }
+    if (m_whea_log.GetCount(WHEA_FATAL) > 0) m_level = SYSTEM_ERROR_FATAL;
+    else if (m_whea_log.GetCount(WHEA_UNCORRECTED) > 0) m_level = SYSTEM_ERROR_UNCORRECTED;
+    else if (m_whea_log.GetCount(WHEA_CORRECTED) > 0) m_level = max(m_level, SYSTEM_ERROR_CORRECTED);
+}
+
+bool CSystemErrorMonitor::ReadEvents()
+{
+    if (!m_reader) {
+        std::vector<std::wstring> providers;
+        m_query_providers.clear();
+        for (size_t i = 0; i < m_providers.size(); ++i) {
+            bool suppressed = false;
+            for (const std::wstring& name : m_suppressed) {
+                if (_wcsicmp(name.c_str(), m_providers[i].c_str()) == 0) suppressed = true;
+            }
+            if (suppressed) continue;
+            providers.push_back(m_providers[i]);
+            m_query_providers.push_back(static_cast<int>(i));
+        }
+        if (!providers.empty()) {
+            m_reader = m_factory(providers, m_subscribe);
+            if (!m_reader) return false;
+        }
+        // 新读取器从窗口起点重新读取，旧计数会重复；被暂停的来源也从这里清零
+        ResetCounts();
+        if (!m_reader) return true;
+    }
+
+    // 一条查询覆盖所有来源，按 Provider/@Name 分到各自的窗口
+    bool ok = m_reader->ReadNewEvents([this](const CLogEvent& event) {
+        if (event.provider < 0 || event.provider >= static_cast<int>(m_query_providers.size())) return;
+        m_windows[m_query_providers[event.provider]].Add(event.time, event.count);
+        if (event.has_whea) m_whea_log.Add(event.whea, event.count);
+    });
+    if (ok) return true;
+
+    // 已经投递的事件保留到新读取器第一次读取为止
+    if (m_reader->IsPushBased()) m_subscribe = false;
+    m_reader.reset();
+    return false;
+}
+
+void CSystemErrorMonitor::ResetCounts()
+{
+    for (CEventWindowCounter& window : m_windows) window.Reset();
+    m_whea_log.Reset();
+}
@@ -0,0 +1,73 @@
+// CPUCoreBars/SystemErrorMonitor.h - 事件日志错误的窗口计数与错误等级（不依赖 Windows API）
+#pragma once
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+#include "LogEventSource.h"
+#include "EventWindow.h"
+#include "WheaRecords.h"
+
+// =================================================================
+// 系统错误等级：决定状态圆点的颜色，数值越大越严重
+// =================================================================
+enum SystemErrorLevel
+{
+    SYSTEM_ERROR_NONE,
+    SYSTEM_ERROR_CORRECTED,     // 仅有已纠正的 WHEA 错误
+    SYSTEM_ERROR_ERROR,         // 其他来源的错误事件或 Xid
+    SYSTEM_ERROR_UNCORRECTED,
+    SYSTEM_ERROR_FATAL
+};
+
+// 按来源列表创建读取器；subscribe 为 false 时应返回轮询式读取器
+typedef std::function<std::unique_ptr<IEventLogReader>(const std::vector<std::wstring>& providers, bool subscribe)> EventLogReaderFactory;
+
+// =================================================================
+// 所有来源共用一个读取器，每个来源一个分桶窗口，WHEA 事件另按严重程度计数
+// 推送式读取器每次 Update 都取走新事件，轮询式读取器每 POLL_INTERVAL_MS 读一次
+// 读取器失效时丢弃重建；推送订阅出错后改用轮询。新读取器会重新回溯整个窗口，计数从头开始
+// 被暂停的来源不进入查询，计数保持为 0（例如 Xid 监听运行时 nvlddmkm 的错误由 NVML 直接报告）
+// 只在一个线程（采样线程）中使用
+// =================================================================
+class CSystemErrorMonitor
+{
+public:
+    static const unsigned long long POLL_INTERVAL_MS = 60000;
+
+    explicit CSystemErrorMonitor(EventLogReaderFactory factory) : m_factory(std::move(factory)) {}
+
+    // 来源或订阅模式变化后调用，下一次 Update 重建读取器
+    void Configure(const std::vector<std::wstring>& providers, bool subscribe);
+
+    // 暂停或恢复读取某个来源，状态变化时下一次 Update 重建读取器
+    void SetSuppressed(const wchar_t* provider, bool suppressed);
+
+    // tick_ms 为单调递增的毫秒数，now 为当前时间（FILETIME，100ns）
+    void Update(unsigned long long tick_ms, unsigned long long now);
+
+    SystemErrorLevel GetLevel() const { return m_level; }
+    int GetProviderCount() const { return static_cast<int>(m_windows.size()); }
+    unsigned int GetCount(int provider) const { return m_windows[provider].GetCount(); }
+    const CWheaErrorLog& GetWheaLog() const { return m_whea_log; }
+
+    // 当前是否使用推送订阅（订阅出错退回轮询后为 false）
+    bool IsSubscribed() const { return m_reader && m_reader->IsPushBased(); }
+
+private:
+    bool ReadEvents();
+    void ResetCounts();
+
+    EventLogReaderFactory m_factory;
+    std::unique_ptr<IEventLogReader> m_reader;
+    std::vector<std::wstring> m_providers;
+    std::vector<std::wstring> m_suppressed;
+    std::vector<int> m_query_providers;     // 读取器的来源下标 -> m_providers 中的下标
+    std::vector<CEventWindowCounter> m_windows;
+    CWheaErrorLog m_whea_log;
+    int m_whea_provider = -1;               // WHEA-Logger 在来源列表中的位置
+    bool m_subscribe = true;
+    bool m_checked = false;                 // 配置后是否已经读取过
+    unsigned long long m_last_check_tick = 0;
+    SystemErrorLevel m_level = SYSTEM_ERROR_NONE;
+};
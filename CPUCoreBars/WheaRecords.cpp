@@ -0,0 +1,45 @@
+﻿// CPUCoreBars/WheaRecords.cpp - WHEA 硬件错误记录的分类与保存（不依赖 Windows API）
+#include "WheaRecords.h"
+
+WheaSeverity ClassifyWheaEvent(unsigned short event_id, unsigned char level)
+{
+    // 18：致命的处理器错误（机器检查），20：致命的 PCIe 错误
+    if (event_id == 18 || event_id == 20 || level == 1) return WHEA_FATAL;
+    if (level == 2) return WHEA_UNCORRECTED;
+    return WHEA_CORRECTED;
+}
+
+const wchar_t* GetWheaSourceName(unsigned char source)
+{
+    static const wchar_t* const names[] = {
+        L"MCE", L"CMC", L"CPE", L"NMI", L"PCIe", L"Generic", L"INIT", L"BOOT",
+        L"SCI", L"IPF MCA", L"IPF CMC", L"IPF CPE", L"Generic V2", L"SCI V2", L"BMC", L"PMEM", L"Driver",
+    };
+    if (source < sizeof(names) / sizeof(names[0])) return names[source];
+    return L"未知";
+}
+
+void CWheaErrorLog::Add(const CWheaRecord& record, unsigned int count)
+{
+    m_records[m_next] = record;
+    m_next = (m_next + 1) % CAPACITY;
+    if (m_size < CAPACITY) ++m_size;
+    m_windows[record.severity].Add(record.time, count);
+}
+
+void CWheaErrorLog::Advance(unsigned long long now)
+{
+    for (CEventWindowCounter& window : m_windows) window.Advance(now);
+}
+
+void CWheaErrorLog::Reset()
+{
+    m_next = 0;
+    m_size = 0;
+    for (CEventWindowCounter& window : m_windows) window.Reset();
+}
+
+const CWheaRecord& CWheaErrorLog::GetRecord(int age) const
+{
+    return m_records[(m_next - 1 - age + CAPACITY) % CAPACITY];
+}
@@ -0,0 +1,67 @@
+// CPUCoreBars/WheaRecords.h - WHEA 硬件错误记录的分类与保存（不依赖 Windows API）
+#pragma once
+#include "EventWindow.h"
+
+// =================================================================
+// 一条 WHEA 事件解析后的紧凑记录
+// =================================================================
+enum WheaSeverity
+{
+    WHEA_CORRECTED,
+    WHEA_UNCORRECTED,
+    WHEA_FATAL,
+    WHEA_SEVERITY_COUNT
+};
+
+struct CWheaRecord
+{
+    unsigned long long time = 0;        // FILETIME，100ns
+    unsigned int apic_id = 0xFFFFFFFF;  // 处理器错误时有效
+    unsigned short event_id = 0;
+    unsigned short pci_segment = 0;
+    unsigned short error_type = 0xFFFF; // 事件数据中的 ErrorType（含义随事件 ID 而定），0xFFFF 表示没有
+    unsigned char severity = WHEA_CORRECTED;
+    unsigned char source = 0xFF;        // WHEA_ERROR_SOURCE_TYPE，0xFF 表示未知
+    unsigned char pci_bus = 0xFF;       // PCIe 错误时有效
+    unsigned char pci_device = 0xFF;
+    unsigned char pci_function = 0xFF;
+
+    bool HasErrorType() const { return error_type != 0xFFFF; }
+    bool HasApicId() const { return apic_id != 0xFFFFFFFF; }
+    bool HasPciAddress() const { return pci_bus != 0xFF; }
+};
+
+// System 日志中 WHEA 事件的来源名
+const wchar_t WHEA_PROVIDER_NAME[] = L"Microsoft-Windows-WHEA-Logger";
+
+// 按事件 ID 和级别判定严重程度
+WheaSeverity ClassifyWheaEvent(unsigned short event_id, unsigned char level);
+
+// WHEA_ERROR_SOURCE_TYPE 的简短名称
+const wchar_t* GetWheaSourceName(unsigned char source);
+
+// =================================================================
+// 最近的 WHEA 记录（固定容量环形缓冲）和按严重程度分开的 24 小时计数
+// =================================================================
+class CWheaErrorLog
+{
+public:
+    static const int CAPACITY = 64;
+
+    // count 大于 1 时只保存一条记录，窗口计数按 count 累加
+    void Add(const CWheaRecord& record, unsigned int count = 1);
+    void Advance(unsigned long long now);
+    void Reset();
+
+    unsigned int GetCount(WheaSeverity severity) const { return m_windows[severity].GetCount(); }
+    int GetRecordCount() const { return m_size; }
+
+    // age 为 0 表示最新一条
+    const CWheaRecord& GetRecord(int age) const;
+
+private:
+    CWheaRecord m_records[CAPACITY];
+    int m_next = 0;
+    int m_size = 0;
+    CEventWindowCounter m_windows[WHEA_SEVERITY_COUNT];
+};
@@ -0,0 +1,40 @@
+// bench/BenchUtil.h - 基准测试的计时与结果输出
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+// 每轮调用 body 一次，返回每轮耗时（微秒），已排序
+template <typename F>
+std::vector<double> MeasureMicros(int rounds, F body)
+{
+    std::vector<double> times;
+    times.reserve(rounds);
+    for (int i = 0; i < rounds; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        body();
+        auto stop = std::chrono::steady_clock::now();
+        times.push_back(std::chrono::duration<double, std::micro>(stop - start).count());
+    }
+    std::sort(times.begin(), times.end());
+    return times;
+}
+
+inline double Percentile(const std::vector<double>& sorted, double p)
+{
+    if (sorted.empty()) return 0.0;
+    size_t index = static_cast<size_t>(p * (sorted.size() - 1) + 0.5);
+    return sorted[index];
+}
+
+// 输出中位数和 P99；给出目标时按中位数判定，返回是否达标
+inline bool ReportMicros(const char* name, const std::vector<double>& sorted, double target_us = 0.0)
+{
+    double median = Percentile(sorted, 0.5);
+    bool ok = target_us <= 0.0 || median <= target_us;
+    std::printf("%-40s 中位数 %9.2f us  P99 %9.2f us", name, median, Percentile(sorted, 0.99));
+    if (target_us > 0.0) std::printf("  目标 %.0f us %s", target_us, ok ? "达标" : "未达标");
+    std::printf("\n");
+    return ok;
+}
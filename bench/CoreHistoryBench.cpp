@@ -0,0 +1,34 @@
+﻿// bench/CoreHistoryBench.cpp - 每核心历史的写入与历史曲线光栅化耗时
+#include "BenchUtil.h"
+#include "CoreHistory.h"
+#include <cstdlib>
+#include <vector>
+
+int main()
+{
+    for (int count : { 64, 256, 1024 }) {
+        std::vector<double> usage(count);
+        for (int i = 0; i < count; ++i) usage[i] = (i % 100) / 100.0;
+        CCoreHistory history;
+        history.Init(count);
+
+        char name[64];
+        std::snprintf(name, sizeof(name), "Push %d CPU", count);
+        ReportMicros(name, MeasureMicros(2000, [&]() { history.Push(usage.data()); }));
+
+        // 历史已经写满，每个核心都把 120 个样本压缩进曲线宽度
+        CPixelCanvas canvas;
+        for (int width : { 30, 120 }) {
+            canvas.Resize(width, 20);
+            auto render = MeasureMicros(200, [&]() {
+                for (int core = 0; core < count; ++core) {
+                    canvas.Clear(0);
+                    RenderSparkline(history, core, canvas, 0xFF76CA53);
+                }
+            });
+            std::snprintf(name, sizeof(name), "RenderSparkline %d CPU x %d px", count, width);
+            ReportMicros(name, render);
+        }
+    }
+    return EXIT_SUCCESS;
+}
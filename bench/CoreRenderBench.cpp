@@ -0,0 +1,54 @@
+﻿// bench/CoreRenderBench.cpp - 256 个核心整行重绘的光栅化耗时（条形图 + 热力图）
+#include "BenchUtil.h"
+#include "CoreRender.h"
+#include <cstdlib>
+#include <vector>
+
+int main()
+{
+    const int COUNT = 256;
+    // 与插件的显示项相同：条形图 8 像素宽，任务栏 96 DPI 时高 20 像素，热力图方格 4 像素
+    const int BAR_WIDTH = 8;
+    const int HEIGHT = 20;
+    const int CELL = 4;
+    const double TARGET_US = 100.0;
+    const uint32_t BG = 0x202020;
+    const uint32_t BAR = 0x76CA53;
+    const uint32_t ICON = 0xFFFFFF;
+    const uint32_t LEVELS[HEATMAP_COLOR_LEVELS] = { 0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17 };
+
+    std::vector<double> usage(COUNT);
+    std::vector<uint8_t> e_core(COUNT);
+    for (int i = 0; i < COUNT; ++i) {
+        usage[i] = (i * 37 % 101) / 100.0;
+        e_core[i] = (i % 4 != 0) ? 1 : 0;
+    }
+    int heatmap_width = ((COUNT + HEIGHT / CELL - 1) / (HEIGHT / CELL)) * CELL;
+
+    CPixelCanvas bar_canvas, heatmap_canvas;
+    auto render_bars = [&]() {
+        for (int i = 0; i < COUNT; ++i) {
+            bar_canvas.Resize(BAR_WIDTH, HEIGHT);
+            int bar_height = static_cast<int>(HEIGHT * usage[i]);
+            int peak_height = bar_height + 4 < HEIGHT ? bar_height + 4 : HEIGHT;
+            RenderCoreBar(bar_canvas, bar_height, peak_height, BG, BAR);
+            if (e_core[i]) DrawECoreGlyph(bar_canvas, ICON);
+        }
+    };
+    auto render_heatmap = [&]() {
+        heatmap_canvas.Resize(heatmap_width, HEIGHT);
+        RenderHeatmap(heatmap_canvas, usage.data(), e_core.data(), COUNT, LEVELS, BG, ICON);
+    };
+
+    char name[64];
+    std::snprintf(name, sizeof(name), "RenderCoreBar x %d", COUNT);
+    ReportMicros(name, MeasureMicros(2000, render_bars));
+    std::snprintf(name, sizeof(name), "RenderHeatmap %d CPU (%d x %d px)", COUNT, heatmap_width, HEIGHT);
+    ReportMicros(name, MeasureMicros(2000, render_heatmap));
+    std::snprintf(name, sizeof(name), "Full redraw %d CPU", COUNT);
+    ReportMicros(name, MeasureMicros(2000, [&]() {
+        render_bars();
+        render_heatmap();
+    }), TARGET_US);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,65 @@
+﻿// bench/CoreStatsBench.cpp - 高频采样统计的开销（256 个 CPU，最高 100 Hz）
+#include "BenchUtil.h"
+#include "CpuSampler.h"
+#include <cstdlib>
+#include <new>
+#include <vector>
+
+namespace
+{
+    // 统计期间的堆分配次数，聚合应当一次都不分配
+    size_t s_allocations = 0;
+}
+
+void* operator new(size_t size)
+{
+    ++s_allocations;
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+    std::free(p);
+}
+
+int main()
+{
+    const int COUNT = 256;
+    const int MAX_HZ = 100;
+    // 1% 的单核时间：100 Hz 时每秒 10 ms，即每个窗口 100 次 Add + 一次 GetStats 和 Reset
+    const double WINDOW_TARGET_US = 10000.0;
+
+    std::vector<double> usage(COUNT);
+    for (int i = 0; i < COUNT; ++i) usage[i] = (i * 37 % 101) / 100.0;
+    std::vector<double> mean(COUNT);
+    std::vector<float> peak(COUNT), p95(COUNT);
+    CCoreStatsAggregator stats;
+    stats.Init(COUNT);
+
+    char name[64];
+    std::snprintf(name, sizeof(name), "Add %d CPU", COUNT);
+    ReportMicros(name, MeasureMicros(5000, [&]() { stats.Add(usage.data()); }), WINDOW_TARGET_US / MAX_HZ);
+    stats.Reset();
+
+    size_t allocations = 0;
+    auto window = MeasureMicros(200, [&]() {
+        size_t before = s_allocations;
+        for (int i = 0; i < MAX_HZ; ++i) {
+            usage[i] = 1.0 - usage[i];
+            stats.Add(usage.data());
+        }
+        stats.GetStats(mean.data(), peak.data(), p95.data(), usage.data());
+        stats.Reset();
+        allocations += s_allocations - before;
+    });
+    std::snprintf(name, sizeof(name), "%d Hz window %d CPU", MAX_HZ, COUNT);
+    ReportMicros(name, window, WINDOW_TARGET_US);
+    std::printf("%-40s %zu %s\n", "窗口内堆分配次数", allocations, allocations == 0 ? "达标" : "未达标");
+    return EXIT_SUCCESS;
+}
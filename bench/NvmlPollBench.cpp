@@ -0,0 +1,86 @@
+﻿// bench/NvmlPollBench.cpp - 批量 nvmlDeviceGetFieldValues 与逐字段读取的调用次数和耗时（NVML 替身库）
+#include "BenchUtil.h"
+#include "NvmlStandinControl.h"
+#include "GpuMonitor.h"
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+namespace
+{
+    const int ROUNDS = 200;
+
+    // 遥测字段数：批量请求一次读完，逐字段读取需要这么多次调用
+    int CountFields()
+    {
+        int count = 0;
+        for (unsigned int mask = GPU_FIELD_ALL; mask; mask &= mask - 1) ++count;
+        return count;
+    }
+
+    // 直接调用替身库读取 fields 个字段，每次调用读 batch 个；替身库只按调用计数和计时，字段 ID 不影响结果
+    void PollFields(decltype(nvmlDeviceGetHandleByIndex_v2)* get_handle, decltype(nvmlDeviceGetFieldValues)* get_fields,
+        unsigned int devices, int fields, int batch)
+    {
+        nvmlFieldValue_t values[GPU_FIELD_COUNT] = {};
+        for (unsigned int i = 0; i < devices; ++i) {
+            nvmlDevice_t device = nullptr;
+            if (get_handle(i, &device) != NVML_SUCCESS) continue;
+            for (int first = 0; first < fields; first += batch) {
+                for (int f = 0; f < batch; ++f) values[f].fieldId = NVML_FI_DEV_POWER_INSTANT;
+                get_fields(device, batch, values);
+            }
+        }
+    }
+}
+
+int main()
+{
+    CNvmlStandin standin;
+    if (!standin.IsValid()) {
+        std::printf("无法加载 NVML 替身库\n");
+        return EXIT_FAILURE;
+    }
+    // 再持有一份引用，直接调用替身库的 NVML 导出函数作为对照
+    HMODULE module = LoadLibraryW(standin.GetLibraryPath());
+    auto get_handle = (decltype(nvmlDeviceGetHandleByIndex_v2)*)GetProcAddress(module, "nvmlDeviceGetHandleByIndex_v2");
+    auto get_fields = (decltype(nvmlDeviceGetFieldValues)*)GetProcAddress(module, "nvmlDeviceGetFieldValues");
+    if (!get_handle || !get_fields) return EXIT_FAILURE;
+
+    const int fields = CountFields();
+    for (unsigned int latency_us : { 0u, 100u }) {
+        for (unsigned int devices : { 1u, 4u, 8u }) {
+            // 每个设备都提供全部违规计数器，与支持 NVML_FI_DEV_PERF_POLICY_* 字段的驱动一致
+            std::string script = "devices " + std::to_string(devices) + "\nlatency_us " + std::to_string(latency_us) + "\n";
+            for (unsigned int d = 0; d < devices; ++d) {
+                for (int policy = 0; policy < GPU_VIOLATION_COUNT; ++policy) {
+                    script += "violation " + std::to_string(d) + " " + std::to_string(policy) + " 1000000 0\n";
+                }
+            }
+            CGpuMonitor monitor;
+            monitor.SetLibraryPath(standin.GetLibraryPath());
+            if (!standin.Load(script) || !monitor.Maintain()) return EXIT_FAILURE;
+            std::vector<CGpuSample> samples(devices);
+
+            // 完整轮询：FieldValues 每个设备只调用一次，其余时间是时钟原因、违规计数、利用率等调用
+            standin.ResetCallCounts();
+            auto poll = MeasureMicros(ROUNDS, [&]() { monitor.Poll(samples.data()); });
+            double poll_calls = standin.GetCallCount("nvmlDeviceGetFieldValues") / static_cast<double>(ROUNDS);
+
+            // 只比较字段读取：一次批量请求 vs 每个字段一次调用
+            auto batched = MeasureMicros(ROUNDS, [&]() { PollFields(get_handle, get_fields, devices, fields, fields); });
+            auto single = MeasureMicros(ROUNDS, [&]() { PollFields(get_handle, get_fields, devices, fields, 1); });
+
+            std::printf("%u 个设备，每次调用延迟 %u us：Poll 中 FieldValues 调用 %.0f 次（逐字段读取需 %u 次）\n",
+                devices, latency_us, poll_calls, devices * fields);
+            char name[64];
+            ReportMicros("  Poll", poll);
+            std::snprintf(name, sizeof(name), "  %d 个字段批量读取", fields);
+            ReportMicros(name, batched);
+            std::snprintf(name, sizeof(name), "  %d 个字段逐个读取", fields);
+            ReportMicros(name, single);
+        }
+    }
+    FreeLibrary(module);
+    return EXIT_SUCCESS;
+}
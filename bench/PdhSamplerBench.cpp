@@ -0,0 +1,52 @@
+﻿// bench/PdhSamplerBench.cpp - PDH 每核心计数器与通配符数组计数器的每次采样开销（PDH 替身回放录制数据）
+#include "BenchUtil.h"
+#include "PdhSampler.h"
+#include "SyntheticTopology.h"
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+namespace
+{
+    // 模拟的单次 PDH 调用开销；真实 PDH 的格式化调用还要经过计数器对象的锁和换算
+    const unsigned int SIMULATED_CALL_NS[] = { 0, 1000 };
+
+    void Run(const char* mode, ICpuSampler& sampler, int cores, unsigned int call_ns)
+    {
+        std::vector<double> usage(cores);
+        PdhStandinSetCallCost(call_ns);
+        PdhStandinResetCallCount();
+        const int ROUNDS = 1000;
+        auto times = MeasureMicros(ROUNDS, [&]() { sampler.Sample(usage.data(), cores); });
+        unsigned long long calls = PdhStandinGetCallCount() / ROUNDS;
+        char name[96];
+        std::snprintf(name, sizeof(name), "%s %d CPU, %u ns/call (%llu calls)", mode, cores, call_ns, calls);
+        ReportMicros(name, times);
+        PdhStandinSetCallCost(0);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    // 默认回放仓库中的示例数据，也可以传入在真实机器上用 typeperf 录制的文件：
+    // typeperf "\Processor Information(*)\% Processor Time" -sc 60 -o trace.csv
+    std::string trace = argc > 1 ? argv[1] : std::string(CPUCOREBARS_BENCH_DATA) + "/processor_information.csv";
+    for (int cores : { 8, 64, 256 }) {
+        if (!PdhStandinLoadTrace(trace.c_str(), cores)) {
+            std::fprintf(stderr, "无法读取录制数据 %s\n", trace.c_str());
+            return EXIT_FAILURE;
+        }
+        std::vector<BYTE> buffer = CSyntheticTopology::Uniform(cores).Build();
+        CCpuTopology topology;
+        if (!topology.LoadFromBuffer(buffer.data(), static_cast<DWORD>(buffer.size()))) return EXIT_FAILURE;
+
+        CPdhCounterSampler counters;
+        CPdhArraySampler array(topology);
+        if (!counters.Init(cores) || !array.Init()) return EXIT_FAILURE;
+        for (unsigned int call_ns : SIMULATED_CALL_NS) {
+            Run("每核心计数器", counters, cores, call_ns);
+            Run("通配符数组", array, cores, call_ns);
+        }
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,50 @@
+﻿// bench/ProcStatBench.cpp - /proc/stat 解析与采样的耗时（目标：1000+ 个 CPU 每次采样 20 us 以内）
+// 目前未达标：1024 个 CPU 约 65 us（每行约 65 ns，Release，x86-64 虚拟机）
+// 解析器读完用到的 8 个字段就用 memchr 跳到行尾；只找行尾和读 CPU 编号就要约 10 us，
+// 按 8 字节一组转换数字、以换行为哨兵去掉边界检查、SSE2 找字段边界都试过，均没有明显改善
+#include "BenchUtil.h"
+#include "LinuxProcStatSampler.h"
+#include <string>
+#include <cstdlib>
+#include <unistd.h>
+
+namespace
+{
+    // 与真实内核输出相同的格式，数值位数接近长时间运行的机器
+    std::string BuildStat(int count)
+    {
+        std::string text = "cpu  884713541 2374 164729342 19830027442 3462934 0 6321839 0 0 0\n";
+        for (int i = 0; i < count; ++i) {
+            text += "cpu" + std::to_string(i) + " 6912374 18 1286955 154922089 27054 0 49389 0 0 0\n";
+        }
+        text += "intr 6839293102 0 9 0 0 0 0 0 0 0 0 0 0 156 0 0 0 0 0 0 0 0 0 0 0\n";
+        text += "ctxt 12976543210\nbtime 1700000000\nprocesses 23456789\n";
+        return text;
+    }
+}
+
+int main()
+{
+    bool ok = true;
+    for (int count : { 64, 256, 1024, 2048 }) {
+        std::string text = BuildStat(count);
+        std::vector<CCpuJiffies> times(count);
+        auto parse = MeasureMicros(2000, [&]() { ParseProcStat(text.data(), text.size(), times.data(), count); });
+        char name[64];
+        std::snprintf(name, sizeof(name), "ParseProcStat %d CPU", count);
+        bool pass = ReportMicros(name, parse, count >= 1000 ? 20.0 : 0.0);
+        ok = ok && pass;
+    }
+
+    // 真实 /proc/stat：包含内核生成文件的开销，仅供参考
+    int count = static_cast<int>(sysconf(_SC_NPROCESSORS_CONF));
+    CLinuxProcStatSampler sampler;
+    if (count > 0 && sampler.Init(count)) {
+        std::vector<double> usage(count);
+        auto sample = MeasureMicros(500, [&]() { sampler.Sample(usage.data(), count); });
+        char name[64];
+        std::snprintf(name, sizeof(name), "Sample(/proc/stat) %d CPU", count);
+        ReportMicros(name, sample);
+    }
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
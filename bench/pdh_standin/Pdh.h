@@ -0,0 +1,62 @@
+// bench/pdh_standin/Pdh.h - PDH 替身：按录制的 typeperf CSV 回放处理器计数器（非 Windows 平台）
+#pragma once
+#include "Platform.h"
+
+// =================================================================
+// 只声明 PdhSampler.cpp 用到的类型和函数，布局与 Windows SDK 相同
+// 每次采集前进到录制数据的下一行，到末尾后从头循环
+// =================================================================
+typedef int32_t PDH_STATUS;
+typedef void* PDH_HQUERY;
+typedef void* PDH_HCOUNTER;
+typedef uintptr_t DWORD_PTR;
+
+#define ERROR_SUCCESS 0
+#define PDH_FMT_DOUBLE 0x00000200
+#define PDH_CSTATUS_VALID_DATA 0x00000000u
+#define PDH_CSTATUS_NEW_DATA 0x00000001u
+
+struct PDH_FMT_COUNTERVALUE
+{
+    DWORD CStatus;
+    union
+    {
+        int32_t longValue;
+        double doubleValue;
+        int64_t largeValue;
+        const char* AnsiStringValue;
+        const wchar_t* WideStringValue;
+    };
+};
+typedef PDH_FMT_COUNTERVALUE* PPDH_FMT_COUNTERVALUE;
+
+struct PDH_FMT_COUNTERVALUE_ITEM_W
+{
+    wchar_t* szName;
+    PDH_FMT_COUNTERVALUE FmtValue;
+};
+typedef PDH_FMT_COUNTERVALUE_ITEM_W* PPDH_FMT_COUNTERVALUE_ITEM_W;
+
+PDH_STATUS PdhOpenQueryW(const wchar_t* data_source, DWORD_PTR user_data, PDH_HQUERY* query);
+PDH_STATUS PdhAddCounterW(PDH_HQUERY query, const wchar_t* path, DWORD_PTR user_data, PDH_HCOUNTER* counter);
+PDH_STATUS PdhAddEnglishCounterW(PDH_HQUERY query, const wchar_t* path, DWORD_PTR user_data, PDH_HCOUNTER* counter);
+PDH_STATUS PdhCollectQueryData(PDH_HQUERY query);
+PDH_STATUS PdhGetFormattedCounterValue(PDH_HCOUNTER counter, DWORD format, DWORD* type, PPDH_FMT_COUNTERVALUE value);
+PDH_STATUS PdhGetFormattedCounterArrayW(PDH_HCOUNTER counter, DWORD format, DWORD* buffer_size, DWORD* item_count,
+    PPDH_FMT_COUNTERVALUE_ITEM_W items);
+PDH_STATUS PdhCloseQuery(PDH_HQUERY query);
+#define PdhOpenQuery PdhOpenQueryW
+
+// -----------------------------------------------------------------
+// 替身的控制接口
+// -----------------------------------------------------------------
+// 读取 typeperf "\Processor Information(*)\% Processor Time" 的 CSV 输出，
+// 录制的核心列按顺序循环铺满 core_count 个逻辑处理器（实例名按每组 64 个生成）
+bool PdhStandinLoadTrace(const char* path, int core_count);
+
+// 每次 PDH 调用额外消耗的 CPU 时间（忙等），用来模拟真实 PDH 的单次调用开销
+void PdhStandinSetCallCost(unsigned int nanoseconds);
+
+// 自上次重置以来的 PDH 调用次数
+unsigned long long PdhStandinGetCallCount();
+void PdhStandinResetCallCount();
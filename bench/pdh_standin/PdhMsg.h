@@ -0,0 +1,9 @@
+// bench/pdh_standin/PdhMsg.h - PDH 替身用到的状态码，数值与 Windows SDK 相同
+#pragma once
+#include "Pdh.h"
+
+#define PDH_MORE_DATA (static_cast<PDH_STATUS>(0x800007D2u))
+#define PDH_INVALID_HANDLE (static_cast<PDH_STATUS>(0xC0000BBCu))
+#define PDH_INVALID_ARGUMENT (static_cast<PDH_STATUS>(0xC0000BBDu))
+#define PDH_CSTATUS_NO_INSTANCE (static_cast<PDH_STATUS>(0x800007D1u))
+#define PDH_NO_DATA (static_cast<PDH_STATUS>(0x800007D5u))
@@ -0,0 +1,252 @@
+﻿// bench/pdh_standin/PdhStandin.cpp - PDH 替身：按录制的 typeperf CSV 回放处理器计数器（非 Windows 平台）
+#include "Pdh.h"
+#include "PdhMsg.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cwchar>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+    struct CStandinCounter
+    {
+        bool wildcard;  // \Processor Information(*) 数组计数器
+        int core;       // \Processor(N) 单核计数器的全局索引
+    };
+
+    struct CStandinQuery
+    {
+        std::vector<std::unique_ptr<CStandinCounter>> counters;
+    };
+
+    std::vector<std::vector<double>> s_rows;    // 每行为录制的各核心使用率（百分比）
+    size_t s_row = 0;
+    int s_core_count = 0;
+    std::vector<std::wstring> s_names;          // 数组计数器的实例，顺序与 Windows 相同："0,_Total" "0,0" ... "_Total"
+    std::vector<int> s_name_cores;              // 实例对应的全局索引，汇总实例为 -1
+    DWORD s_names_bytes = 0;
+    unsigned int s_call_cost_ns = 0;
+    unsigned long long s_call_count = 0;
+
+    void EnterCall()
+    {
+        ++s_call_count;
+        if (s_call_cost_ns == 0) return;
+        auto until = std::chrono::steady_clock::now() + std::chrono::nanoseconds(s_call_cost_ns);
+        while (std::chrono::steady_clock::now() < until) {
+        }
+    }
+
+    // 去掉两端的引号
+    std::string Unquote(const std::string& text)
+    {
+        size_t begin = text.find_first_not_of(" \"\r");
+        size_t end = text.find_last_not_of(" \"\r");
+        return begin == std::string::npos ? std::string() : text.substr(begin, end - begin + 1);
+    }
+
+    std::vector<std::string> SplitCsv(const std::string& line)
+    {
+        std::vector<std::string> columns;
+        std::string column;
+        std::istringstream stream(line);
+        while (std::getline(stream, column, ',')) {
+            // 实例名 "组,编号" 本身带逗号，引号没闭合时与下一段拼接
+            if (!columns.empty() && std::count(columns.back().begin(), columns.back().end(), '"') % 2 == 1) {
+                columns.back() += "," + column;
+            } else {
+                columns.push_back(column);
+            }
+        }
+        for (std::string& c : columns) c = Unquote(c);
+        return columns;
+    }
+
+    // "\\HOST\Processor Information(0,3)\% Processor Time" 中的 "组,编号"，不是单个核心时返回 false
+    bool IsCoreInstance(const std::string& path)
+    {
+        size_t open = path.find("Processor Information(");
+        if (open == std::string::npos) return false;
+        std::string instance = path.substr(open + strlen("Processor Information("));
+        instance = instance.substr(0, instance.find(')'));
+        size_t comma = instance.find(',');
+        if (comma == std::string::npos || comma == 0 || comma + 1 >= instance.size()) return false;
+        return instance.find_first_not_of("0123456789,") == std::string::npos;
+    }
+
+    void BuildInstances(int core_count)
+    {
+        s_names.clear();
+        s_name_cores.clear();
+        const int GROUP_SIZE = 64;
+        for (int offset = 0; offset < core_count; offset += GROUP_SIZE) {
+            int group = offset / GROUP_SIZE;
+            s_names.push_back(std::to_wstring(group) + L",_Total");
+            s_name_cores.push_back(-1);
+            for (int number = 0; number < GROUP_SIZE && offset + number < core_count; ++number) {
+                s_names.push_back(std::to_wstring(group) + L"," + std::to_wstring(number));
+                s_name_cores.push_back(offset + number);
+            }
+        }
+        s_names.push_back(L"_Total");
+        s_name_cores.push_back(-1);
+        s_names_bytes = 0;
+        for (const std::wstring& name : s_names) s_names_bytes += static_cast<DWORD>((name.size() + 1) * sizeof(wchar_t));
+    }
+
+    double CoreValue(int core)
+    {
+        const std::vector<double>& row = s_rows[s_row];
+        return row[core % row.size()];
+    }
+
+    double TotalValue()
+    {
+        const std::vector<double>& row = s_rows[s_row];
+        double sum = 0.0;
+        for (double value : row) sum += value;
+        return sum / row.size();
+    }
+}
+
+bool PdhStandinLoadTrace(const char* path, int core_count)
+{
+    std::ifstream file(path);
+    std::string line;
+    if (!file || core_count <= 0 || !std::getline(file, line)) return false;
+
+    // 第一列是时间戳，其余列中只取单个核心的实例
+    std::vector<std::string> header = SplitCsv(line);
+    std::vector<size_t> core_columns;
+    for (size_t i = 1; i < header.size(); ++i) {
+        if (IsCoreInstance(header[i])) core_columns.push_back(i);
+    }
+    if (core_columns.empty()) return false;
+
+    std::vector<std::vector<double>> rows;
+    while (std::getline(file, line)) {
+        std::vector<std::string> columns = SplitCsv(line);
+        if (columns.size() < header.size()) continue;
+        std::vector<double> row;
+        for (size_t column : core_columns) row.push_back(atof(columns[column].c_str()));
+        rows.push_back(row);
+    }
+    if (rows.empty()) return false;
+
+    s_rows.swap(rows);
+    s_row = 0;
+    s_core_count = core_count;
+    BuildInstances(core_count);
+    return true;
+}
+
+void PdhStandinSetCallCost(unsigned int nanoseconds)
+{
+    s_call_cost_ns = nanoseconds;
+}
+
+unsigned long long PdhStandinGetCallCount()
+{
+    return s_call_count;
+}
+
+void PdhStandinResetCallCount()
+{
+    s_call_count = 0;
+}
+
+PDH_STATUS PdhOpenQueryW(const wchar_t*, DWORD_PTR, PDH_HQUERY* query)
+{
+    EnterCall();
+    if (!query) return PDH_INVALID_ARGUMENT;
+    if (s_rows.empty()) return PDH_NO_DATA;
+    *query = new CStandinQuery();
+    return ERROR_SUCCESS;
+}
+
+PDH_STATUS PdhAddCounterW(PDH_HQUERY query, const wchar_t* path, DWORD_PTR, PDH_HCOUNTER* counter)
+{
+    EnterCall();
+    if (!query) return PDH_INVALID_HANDLE;
+    int core = -1;
+    if (swscanf(path, L"\\Processor(%d)", &core) != 1 || core < 0 || core >= s_core_count) return PDH_CSTATUS_NO_INSTANCE;
+    CStandinQuery* standin = static_cast<CStandinQuery*>(query);
+    standin->counters.emplace_back(new CStandinCounter{ false, core });
+    *counter = standin->counters.back().get();
+    return ERROR_SUCCESS;
+}
+
+PDH_STATUS PdhAddEnglishCounterW(PDH_HQUERY query, const wchar_t* path, DWORD_PTR, PDH_HCOUNTER* counter)
+{
+    EnterCall();
+    if (!query) return PDH_INVALID_HANDLE;
+    if (wcscmp(path, L"\\Processor Information(*)\\% Processor Time") != 0) return PDH_CSTATUS_NO_INSTANCE;
+    CStandinQuery* standin = static_cast<CStandinQuery*>(query);
+    standin->counters.emplace_back(new CStandinCounter{ true, -1 });
+    *counter = standin->counters.back().get();
+    return ERROR_SUCCESS;
+}
+
+PDH_STATUS PdhCollectQueryData(PDH_HQUERY query)
+{
+    EnterCall();
+    if (!query) return PDH_INVALID_HANDLE;
+    s_row = (s_row + 1) % s_rows.size();
+    return ERROR_SUCCESS;
+}
+
+PDH_STATUS PdhGetFormattedCounterValue(PDH_HCOUNTER counter, DWORD format, DWORD* type, PPDH_FMT_COUNTERVALUE value)
+{
+    EnterCall();
+    const CStandinCounter* standin = static_cast<const CStandinCounter*>(counter);
+    if (!standin || standin->wildcard) return PDH_INVALID_HANDLE;
+    if (format != PDH_FMT_DOUBLE || !value) return PDH_INVALID_ARGUMENT;
+    if (type) *type = 0;
+    value->CStatus = PDH_CSTATUS_VALID_DATA;
+    value->doubleValue = CoreValue(standin->core);
+    return ERROR_SUCCESS;
+}
+
+PDH_STATUS PdhGetFormattedCounterArrayW(PDH_HCOUNTER counter, DWORD format, DWORD* buffer_size, DWORD* item_count,
+    PPDH_FMT_COUNTERVALUE_ITEM_W items)
+{
+    EnterCall();
+    const CStandinCounter* standin = static_cast<const CStandinCounter*>(counter);
+    if (!standin || !standin->wildcard) return PDH_INVALID_HANDLE;
+    if (format != PDH_FMT_DOUBLE || !buffer_size || !item_count) return PDH_INVALID_ARGUMENT;
+
+    // 与真实 PDH 相同：条目数组在前，实例名字符串紧随其后放在同一块缓冲区中
+    DWORD count = static_cast<DWORD>(s_names.size());
+    DWORD required = count * static_cast<DWORD>(sizeof(PDH_FMT_COUNTERVALUE_ITEM_W)) + s_names_bytes;
+    *item_count = count;
+    if (!items || *buffer_size < required) {
+        *buffer_size = required;
+        return PDH_MORE_DATA;
+    }
+    wchar_t* strings = reinterpret_cast<wchar_t*>(items + count);
+    for (DWORD i = 0; i < count; ++i) {
+        const std::wstring& name = s_names[i];
+        memcpy(strings, name.c_str(), (name.size() + 1) * sizeof(wchar_t));
+        items[i].szName = strings;
+        strings += name.size() + 1;
+        int core = s_name_cores[i];
+        items[i].FmtValue.CStatus = PDH_CSTATUS_VALID_DATA;
+        items[i].FmtValue.doubleValue = core >= 0 ? CoreValue(core) : TotalValue();
+    }
+    *buffer_size = required;
+    return ERROR_SUCCESS;
+}
+
+PDH_STATUS PdhCloseQuery(PDH_HQUERY query)
+{
+    EnterCall();
+    if (!query) return PDH_INVALID_HANDLE;
+    delete static_cast<CStandinQuery*>(query);
+    return ERROR_SUCCESS;
+}
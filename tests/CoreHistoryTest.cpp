@@ -0,0 +1,84 @@
+﻿// tests/CoreHistoryTest.cpp - 历史环形缓冲区与历史曲线的压缩绘制
+#include "TestHarness.h"
+#include "CoreHistory.h"
+#include <vector>
+
+namespace
+{
+    const uint32_t BG = 0xFF000000;
+    const uint32_t LINE = 0xFFFFFFFF;
+
+    // 返回第 x 列被画上的行范围 [top, bottom]，没有画上时返回 false
+    bool ColumnSpan(const CPixelCanvas& canvas, int x, int& top, int& bottom)
+    {
+        top = -1;
+        bottom = -1;
+        for (int y = 0; y < canvas.GetHeight(); ++y) {
+            if (canvas.GetPixels()[static_cast<size_t>(y) * canvas.GetWidth() + x] != LINE) continue;
+            if (top < 0) top = y;
+            bottom = y;
+        }
+        return top >= 0;
+    }
+
+    void PushValue(CCoreHistory& history, double value)
+    {
+        std::vector<double> usage = { value, 1.0 - value };
+        history.Push(usage.data());
+    }
+}
+
+TEST_CASE(RingKeepsTheNewestSamples)
+{
+    CCoreHistory history;
+    history.Init(2);
+    for (int i = 0; i < CCoreHistory::CAPACITY + 10; ++i) PushValue(history, (i % 2) ? 1.0 : 0.0);
+    CHECK_EQ(history.GetSize(), CCoreHistory::CAPACITY);
+    CHECK_EQ(static_cast<int>(history.Get(0, 0)), 255);
+    CHECK_EQ(static_cast<int>(history.Get(1, 0)), 0);
+    CHECK_EQ(static_cast<int>(history.Get(0, 1)), 0);
+}
+
+TEST_CASE(FullHistoryIsCompressedIntoTheWidth)
+{
+    // 最旧的 4 个样本是满载，其余为空闲：压缩到 30 列后仍应出现在最左列
+    CCoreHistory history;
+    history.Init(2);
+    for (int i = 0; i < CCoreHistory::CAPACITY; ++i) PushValue(history, i < 4 ? 1.0 : 0.0);
+
+    CPixelCanvas canvas;
+    canvas.Resize(30, 20);
+    canvas.Clear(BG);
+    RenderSparkline(history, 0, canvas, LINE);
+
+    int top = 0, bottom = 0;
+    REQUIRE(ColumnSpan(canvas, 0, top, bottom));
+    CHECK_EQ(top, 0);
+    CHECK_EQ(bottom, 19);
+    REQUIRE(ColumnSpan(canvas, 29, top, bottom));
+    CHECK_EQ(top, 19);
+    CHECK_EQ(bottom, 19);
+    for (int x = 0; x < 30; ++x) CHECK(ColumnSpan(canvas, x, top, bottom));
+}
+
+TEST_CASE(ShortHistoryUsesOneColumnPerSample)
+{
+    CCoreHistory history;
+    history.Init(2);
+    PushValue(history, 0.0);
+    PushValue(history, 1.0);
+
+    CPixelCanvas canvas;
+    canvas.Resize(30, 20);
+    canvas.Clear(BG);
+    RenderSparkline(history, 0, canvas, LINE);
+
+    int top = 0, bottom = 0;
+    CHECK(!ColumnSpan(canvas, 27, top, bottom));
+    REQUIRE(ColumnSpan(canvas, 28, top, bottom));
+    CHECK_EQ(top, 0);           // 与右侧一列相连
+    CHECK_EQ(bottom, 19);
+    REQUIRE(ColumnSpan(canvas, 29, top, bottom));
+    CHECK_EQ(top, 0);
+    CHECK_EQ(bottom, 0);
+}
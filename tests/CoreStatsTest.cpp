@@ -0,0 +1,124 @@
+﻿// tests/CoreStatsTest.cpp - 高频采样的均值、峰值与直方图 P95
+#include "TestHarness.h"
+#include "CpuSampler.h"
+#include <vector>
+
+namespace
+{
+    struct CStats
+    {
+        std::vector<double> mean;
+        std::vector<float> peak;
+        std::vector<float> p95;
+    };
+
+    CStats GetStats(const CCoreStatsAggregator& stats, const std::vector<double>& fallback)
+    {
+        CStats result;
+        result.mean.assign(fallback.size(), -1.0);
+        result.peak.assign(fallback.size(), -1.0f);
+        result.p95.assign(fallback.size(), -1.0f);
+        stats.GetStats(result.mean.data(), result.peak.data(), result.p95.data(), fallback.data());
+        return result;
+    }
+}
+
+TEST_CASE(EmptyWindowReportsTheFallback)
+{
+    CCoreStatsAggregator stats;
+    stats.Init(2);
+    CStats result = GetStats(stats, { 0.25, 0.75 });
+    CHECK_NEAR(result.mean[0], 0.25, 1e-9);
+    CHECK_NEAR(result.peak[1], 0.75, 1e-6);
+    CHECK_NEAR(result.p95[1], 0.75, 1e-6);
+}
+
+TEST_CASE(MeanAndPeakFollowKnownSequences)
+{
+    // 核心 0 是一次 100% 的短时突发，核心 1 一直平稳
+    const double samples[][2] = { { 0.1, 0.4 }, { 1.0, 0.4 }, { 0.1, 0.4 }, { 0.2, 0.4 } };
+    CCoreStatsAggregator stats;
+    stats.Init(2);
+    for (const auto& sample : samples) stats.Add(sample);
+    CStats result = GetStats(stats, { 0.0, 0.0 });
+    CHECK_NEAR(result.mean[0], 0.35, 1e-9);
+    CHECK_NEAR(result.peak[0], 1.0, 1e-6);
+    CHECK_NEAR(result.mean[1], 0.4, 1e-9);
+    CHECK_NEAR(result.peak[1], 0.4, 1e-6);
+    CHECK_NEAR(result.p95[1], 0.4, 1e-6);
+}
+
+TEST_CASE(P95ComesFromTheHistogram)
+{
+    // 0.00 ~ 0.99 各一次：第 95 个样本落在 0.95 档（5% 一档，四舍五入）
+    CCoreStatsAggregator stats;
+    stats.Init(1);
+    for (int i = 0; i < 100; ++i) {
+        double value = i / 100.0;
+        stats.Add(&value);
+    }
+    CStats result = GetStats(stats, { 0.0 });
+    CHECK_NEAR(result.p95[0], 0.95, 1e-6);
+    CHECK_NEAR(result.peak[0], 0.99, 1e-6);
+
+    // 19 次 20% 加一次 100%：单次突发只影响峰值，不影响 P95
+    stats.Reset();
+    for (int i = 0; i < 20; ++i) {
+        double value = i == 7 ? 1.0 : 0.2;
+        stats.Add(&value);
+    }
+    result = GetStats(stats, { 0.0 });
+    CHECK_NEAR(result.mean[0], 0.24, 1e-9);
+    CHECK_NEAR(result.peak[0], 1.0, 1e-6);
+    CHECK_NEAR(result.p95[0], 0.2, 1e-6);
+}
+
+TEST_CASE(P95NeverExceedsThePeak)
+{
+    // 0.53 按档位四舍五入到 0.55，输出以实际峰值为上限
+    CCoreStatsAggregator stats;
+    stats.Init(1);
+    double value = 0.53;
+    stats.Add(&value);
+    CStats result = GetStats(stats, { 0.0 });
+    CHECK_NEAR(result.p95[0], 0.53, 1e-6);
+}
+
+TEST_CASE(ResetStartsANewWindow)
+{
+    CCoreStatsAggregator stats;
+    stats.Init(2);
+    const double busy[] = { 1.0, 0.9 };
+    for (int i = 0; i < 10; ++i) stats.Add(busy);
+
+    stats.Reset();
+    const double idle[] = { 0.3, 0.0 };
+    stats.Add(idle);
+    CStats result = GetStats(stats, { 0.5, 0.5 });
+    CHECK_NEAR(result.mean[0], 0.3, 1e-9);
+    CHECK_NEAR(result.peak[0], 0.3, 1e-6);
+    CHECK_NEAR(result.p95[0], 0.3, 1e-6);
+    CHECK_NEAR(result.mean[1], 0.0, 1e-9);
+    CHECK_NEAR(result.peak[1], 0.0, 1e-6);
+    CHECK_NEAR(result.p95[1], 0.0, 1e-6);
+
+    // 空窗口重置后回到 fallback
+    stats.Reset();
+    result = GetStats(stats, { 0.5, 0.5 });
+    CHECK_NEAR(result.mean[0], 0.5, 1e-9);
+}
+
+TEST_CASE(HistogramStopsCountingAtItsLimit)
+{
+    // 超过 uint16_t 计数上限后直方图不再累加，均值仍包含全部样本
+    CCoreStatsAggregator stats;
+    stats.Init(1);
+    double value = 0.5;
+    for (int i = 0; i < 0x10000; ++i) stats.Add(&value);
+    value = 1.0;
+    for (int i = 0; i < 0x10000; ++i) stats.Add(&value);
+    CStats result = GetStats(stats, { 0.0 });
+    CHECK_NEAR(result.mean[0], 0.75, 1e-9);
+    CHECK_NEAR(result.peak[0], 1.0, 1e-6);
+    CHECK_NEAR(result.p95[0], 0.5, 1e-6);
+}
@@ -0,0 +1,131 @@
+﻿// tests/CpuTopologyTest.cpp - 合成的大核数拓扑（256/512 个逻辑处理器、多处理器组）
+#include "TestHarness.h"
+#include "CpuTopology.h"
+#include "SyntheticTopology.h"
+#include <vector>
+
+namespace
+{
+    bool Load(CCpuTopology& topology, const std::vector<BYTE>& buffer)
+    {
+        return topology.LoadFromBuffer(buffer.data(), static_cast<DWORD>(buffer.size()));
+    }
+}
+
+TEST_CASE(MapsFourGroupsOf64)
+{
+    CCpuTopology topology;
+    REQUIRE(Load(topology, CSyntheticTopology::Uniform(256).Build()));
+    CHECK_EQ(topology.GetCount(), 256);
+    CHECK_EQ(topology.GetGlobalIndex(0, 0), 0);
+    CHECK_EQ(topology.GetGlobalIndex(1, 0), 64);
+    CHECK_EQ(topology.GetGlobalIndex(2, 17), 145);
+    CHECK_EQ(topology.GetGlobalIndex(3, 63), 255);
+    CHECK_EQ(topology.GetGlobalIndex(4, 0), -1);
+    CHECK_EQ(topology.GetGlobalIndex(0, 64), -1);
+}
+
+TEST_CASE(Maps512ThreadsWithSmtAcrossEightGroups)
+{
+    CCpuTopology topology;
+    REQUIRE(Load(topology, CSyntheticTopology::Uniform(512, 2).Build()));
+    CHECK_EQ(topology.GetCount(), 512);
+    // 每个全局索引恰好对应一个 (组, 编号)
+    std::vector<int> seen(512, 0);
+    for (int group = 0; group < 8; ++group) {
+        for (int number = 0; number < 64; ++number) {
+            int index = topology.GetGlobalIndex(static_cast<WORD>(group), static_cast<BYTE>(number));
+            REQUIRE(index >= 0 && index < 512);
+            ++seen[index];
+        }
+    }
+    int unique = 0;
+    for (int count : seen) unique += (count == 1);
+    CHECK_EQ(unique, 512);
+    CHECK_EQ(topology.GetGlobalIndex(7, 63), 511);
+    CHECK(!topology.IsEfficiencyCore(0));
+    CHECK(!topology.IsEfficiencyCore(511));
+}
+
+TEST_CASE(UnevenGroupsUseRunningOffsets)
+{
+    // Windows 会把 96 个逻辑处理器分成两组 48，或按 NUMA 节点分成大小不同的组
+    CSyntheticTopology synthetic;
+    synthetic.AddGroup(40);
+    synthetic.AddGroup(60);
+    synthetic.AddGroup(28);
+    CCpuTopology topology;
+    REQUIRE(Load(topology, synthetic.Build()));
+    CHECK_EQ(topology.GetCount(), 128);
+    CHECK_EQ(topology.GetGlobalIndex(1, 0), 40);
+    CHECK_EQ(topology.GetGlobalIndex(2, 0), 100);
+    CHECK_EQ(topology.GetGlobalIndex(2, 27), 127);
+    CHECK_EQ(topology.GetGlobalIndex(0, 40), -1);
+    CHECK_EQ(topology.GetGlobalIndex(2, 28), -1);
+}
+
+TEST_CASE(EfficiencyClassesSpanGroups)
+{
+    // 每 4 个物理核心中 1 个性能核、3 个能效核，每个物理核心 2 个线程
+    CSyntheticTopology synthetic = CSyntheticTopology::Uniform(256, 2);
+    synthetic.SetEfficiencyClasses({ 1, 0, 0, 0 });
+    CCpuTopology topology;
+    REQUIRE(Load(topology, synthetic.Build()));
+    CHECK(!topology.IsEfficiencyCore(0));
+    CHECK(!topology.IsEfficiencyCore(1));
+    CHECK(topology.IsEfficiencyCore(2));
+    CHECK(topology.IsEfficiencyCore(7));
+    CHECK(!topology.IsEfficiencyCore(8));
+    // 第二组的第一个物理核心是全局第 32 个，同样是性能核
+    CHECK(!topology.IsEfficiencyCore(64));
+    CHECK(topology.IsEfficiencyCore(66));
+    CHECK(!topology.IsEfficiencyCore(256));
+}
+
+TEST_CASE(RejectsTruncatedOrEmptyBuffers)
+{
+    std::vector<BYTE> buffer = CSyntheticTopology::Uniform(256).Build();
+    CCpuTopology topology;
+    // 第一条记录（RelationGroup）被截断
+    CHECK(!topology.LoadFromBuffer(buffer.data(), 40));
+    CHECK_EQ(topology.GetCount(), 0);
+    CHECK(!topology.LoadFromBuffer(buffer.data(), 0));
+
+    // Size 为 0 的记录不能让解析原地打转
+    std::vector<BYTE> zero(buffer.begin(), buffer.end());
+    reinterpret_cast<SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX*>(zero.data())->Size = 0;
+    CHECK(!Load(topology, zero));
+}
+
+TEST_CASE(IgnoresTrailingFragmentAndRejectsOversizedCounts)
+{
+    std::vector<BYTE> buffer = CSyntheticTopology::Uniform(128).Build();
+    CCpuTopology topology;
+
+    // 末尾不足一个记录头的零头两遍都不读取
+    std::vector<BYTE> fragment(buffer.begin(), buffer.end());
+    fragment.resize(fragment.size() + 6, 0);
+    REQUIRE(Load(topology, fragment));
+    CHECK_EQ(topology.GetCount(), 128);
+
+    // 组数超出记录本身
+    std::vector<BYTE> groups(buffer.begin(), buffer.end());
+    reinterpret_cast<SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX*>(groups.data())->Group.ActiveGroupCount = 100;
+    CHECK(!Load(topology, groups));
+
+    std::vector<BYTE> cores(buffer.begin(), buffer.end());
+    auto group_record = reinterpret_cast<SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX*>(cores.data());
+    reinterpret_cast<SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX*>(cores.data() + group_record->Size)->Processor.GroupCount = 1000;
+    CHECK(!Load(topology, cores));
+}
+
+TEST_CASE(SingleGroupFallbackCapsAt64)
+{
+    CCpuTopology topology;
+    topology.LoadSingleGroup(300);
+    CHECK_EQ(topology.GetCount(), 64);
+    CHECK_EQ(topology.GetGlobalIndex(0, 63), 63);
+    topology.LoadSingleGroup(8);
+    CHECK_EQ(topology.GetCount(), 8);
+    CHECK_EQ(topology.GetGlobalIndex(0, 8), -1);
+}
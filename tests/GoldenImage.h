@@ -0,0 +1,72 @@
+// tests/GoldenImage.h - 把画布按调色板转成字符画，与 tests/golden/ 下的参考图逐像素比较
+#pragma once
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <utility>
+#include <vector>
+#include "PixelCanvas.h"
+#include "TestHarness.h"
+
+// =================================================================
+// 参考图每行一个像素行，每个字符一个像素；调色板之外的颜色输出为 '?'
+// 设置环境变量 CPUCOREBARS_UPDATE_GOLDEN=1 时改为把当前输出写回参考图
+// =================================================================
+typedef std::vector<std::pair<uint32_t, char>> GoldenPalette;
+
+inline std::string CanvasToText(const CPixelCanvas& canvas, const GoldenPalette& palette)
+{
+    std::string text;
+    const uint32_t* pixels = canvas.GetPixels();
+    for (int y = 0; y < canvas.GetHeight(); ++y) {
+        for (int x = 0; x < canvas.GetWidth(); ++x) {
+            uint32_t pixel = pixels[static_cast<size_t>(y) * canvas.GetWidth() + x];
+            char symbol = '?';
+            for (const auto& entry : palette) {
+                if (entry.first == pixel) symbol = entry.second;
+            }
+            text += symbol;
+        }
+        text += '\n';
+    }
+    return text;
+}
+
+inline bool MatchesGolden(const CPixelCanvas& canvas, const GoldenPalette& palette, const char* name, std::string& message)
+{
+    std::string path = std::string(CPUCOREBARS_GOLDEN_DIR) + "/" + name + ".txt";
+    std::string actual = CanvasToText(canvas, palette);
+
+    const char* update = std::getenv("CPUCOREBARS_UPDATE_GOLDEN");
+    if (update && *update == '1') {
+        FILE* file = std::fopen(path.c_str(), "wb");
+        if (!file) {
+            message = "cannot write " + path;
+            return false;
+        }
+        std::fwrite(actual.data(), 1, actual.size(), file);
+        std::fclose(file);
+        return true;
+    }
+
+    std::string expected;
+    FILE* file = std::fopen(path.c_str(), "rb");
+    if (!file) {
+        message = "missing golden image " + path;
+        return false;
+    }
+    char buffer[4096];
+    size_t read = 0;
+    while ((read = std::fread(buffer, 1, sizeof(buffer), file)) > 0) expected.append(buffer, read);
+    std::fclose(file);
+
+    if (actual == expected) return true;
+    message = std::string(name) + " differs from " + path + "\nexpected:\n" + expected + "actual:\n" + actual;
+    return false;
+}
+
+#define CHECK_GOLDEN(canvas, palette, name) \
+    do { \
+        std::string golden_message_; \
+        if (!MatchesGolden((canvas), (palette), (name), golden_message_)) ReportFailure(__FILE__, __LINE__, golden_message_); \
+    } while (0)
@@ -0,0 +1,621 @@
+﻿// tests/GpuMonitorTest.cpp - 用 NVML 替身库按脚本驱动 CGpuMonitor 与 CGpuPollWorker
+#include "TestHarness.h"
+#include "NvmlStandinControl.h"
+#include "GpuMonitor.h"
+#include "GpuPollWorker.h"
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace
+{
+    // 加载脚本并让监控初始化到就绪状态
+    bool StartMonitor(CNvmlStandin& standin, CGpuMonitor& monitor, const std::string& script)
+    {
+        if (!standin.IsValid() || !standin.Load(script)) return false;
+        monitor.SetLibraryPath(standin.GetLibraryPath());
+        return monitor.Maintain() && monitor.GetState() == NVML_READY;
+    }
+
+    double ElapsedMs(std::chrono::steady_clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+}
+
+TEST_CASE(EnumeratesScriptedDevices)
+{
+    CNvmlStandin standin;
+    CGpuMonitor monitor;
+    REQUIRE(StartMonitor(standin, monitor,
+        "devices 2\n"
+        "busid 1 00000000:41:00.0\n"
+        "uuid 1 GPU-second\n"));
+    REQUIRE(monitor.GetDevices().size() == 2);
+    CHECK(std::string(monitor.GetDevices()[0].pci_bus_id) == "00000000:01:00.0");
+    CHECK(std::string(monitor.GetDevices()[1].pci_bus_id) == "00000000:41:00.0");
+    CHECK(std::string(monitor.GetDevices()[1].uuid) == "GPU-second");
+    CHECK_EQ(monitor.GetGeneration(), 1u);
+}
+
+TEST_CASE(NoDevicesLeavesMonitorUninitialized)
+{
+    CNvmlStandin standin;
+    CGpuMonitor monitor;
+    REQUIRE(standin.IsValid() && standin.Load("devices 0\n"));
+    monitor.SetLibraryPath(standin.GetLibraryPath());
+    CHECK(!monitor.Maintain());
+    CHECK(!monitor.IsInitialized());
+    CHECK_EQ(static_cast<int>(monitor.GetState()), static_cast<int>(NVML_UNINITIALIZED));
+}
+
+TEST_CASE(EveryDeviceIsPolledIndependently)
+{
+    CNvmlStandin standin;
+    CGpuMonitor monitor;
+    REQUIRE(StartMonitor(standin, monitor,
+        "devices 4\n"
+        "temp 0 40\n"
+        "temp 1 50\n"
+        "temp 2 60\n"
+        "temp 3 70\n"
+        "reasons 2 0x20\n"
+        "fail nvmlDeviceGetTemperature 3 1\n"));
+    REQUIRE(monitor.GetDevices().size() == 4);
+    for (unsigned int i = 0; i < 4; ++i) CHECK_EQ(monitor.GetDevices()[i].index, i);
+
+    std::vector<CGpuSample> samples(4);
+    standin.ResetCallCounts();
+    monitor.Poll(samples.data());
+    CHECK_EQ(standin.GetCallCount("nvmlDeviceGetTemperature"), 4u);
+    CHECK_EQ(standin.GetCallCount("nvmlDeviceGetCurrentClocksEventReasons"), 4u);
+    // 第一个设备的读数失败不影响其余设备
+    CHECK_EQ(samples[0].temperature, 0u);
+    CHECK_EQ(samples[1].temperature, 50u);
+    CHECK_EQ(samples[2].temperature, 60u);
+    CHECK_EQ(samples[3].temperature, 70u);
+    CHECK_EQ(samples[2].reason, DecodeClockEventReasons(0x20));
+    CHECK_EQ(samples[3].reason, CLOCK_REASON_NONE);
+}
+
+TEST_CASE(ReportsScriptedThrottleReasonsAndTemperature)
+{
+    CNvmlStandin standin;
+    CGpuMonitor monitor;
+    REQUIRE(StartMonitor(standin, monitor,
+        "devices 2\n"
+        "reasons 0 0x48\n"     // HW 降频 + 板卡功耗刹车
+        "temp 0 83\n"
+        "reasons 1 0\n"
+        "temp 1 45\n"));
+    std::vector<CGpuSample> samples(2);
+    monitor.Poll(samples.data());
+    CHECK_EQ(samples[0].reason, DecodeClockEventReasons(0x48));
+    CHECK_EQ(samples[0].temperature, 83u);
+    CHECK_EQ(samples[1].reason, CLOCK_REASON_NONE);
+    CHECK_EQ(samples[1].temperature, 45u);
+    CHECK_EQ(static_cast<int>(samples[0].health), static_cast<int>(GPU_HEALTH_OK));
+}
+
+TEST_CASE(TelemetryIsReadWithOneBatchedCallPerDevice)
+{
+    CNvmlStandin standin;
+    CGpuMonitor monitor;
+    REQUIRE(StartMonitor(standin, monitor,
+        "devices 2\n"
+        "field 0 186 152000\n"      // NVML_FI_DEV_POWER_INSTANT
+        "field 0 190 250000\n"      // NVML_FI_DEV_POWER_CURRENT_LIMIT
+        "field 1 82 64\n"));        // NVML_FI_DEV_MEMORY_TEMP
+    std::vector<CGpuSample> samples(2);
+    standin.ResetCallCounts();
+    monitor.Poll(samples.data());
+    CHECK_EQ(standin.GetCallCount("nvmlDeviceGetFieldValues"), 2u);
+    CHECK(samples[0].telemetry.Has(GPU_FIELD_POWER));
+    CHECK_EQ(samples[0].telemetry.values[GPU_FIELD_POWER], 152000ull);
+    CHECK_EQ(samples[0].telemetry.values[GPU_FIELD_POWER_LIMIT], 250000ull);
+    CHECK(!samples[0].telemetry.Has(GPU_FIELD_MEMORY_TEMP));
+    CHECK(samples[1].telemetry.Has(GPU_FIELD_MEMORY_TEMP));
+    CHECK(!samples[1].telemetry.Has(GPU_FIELD_POWER));
+}
+
+TEST_CASE(ViolationCountersComeFromTheBatchedFieldRequest)
+{
+    CNvmlStandin standin;
+    CGpuMonitor monitor;
+    REQUIRE(StartMonitor(standin, monitor,
+        "devices 1\n"
+        "violation 0 0 1000000 0\n"                // 功耗策略：参考时间 1 秒，累计 0
+        "violation 0 1 1000000 0\n"                // 温控策略
+        "frame\n"
+        "violation 0 0 2000000 250000000\n"        // 1 秒内功耗墙 250 ms
+        "violation 0 1 2000000 100000000\n"));     // 温控 100 ms
+    std::vector<CGpuSample> samples(1);
+    monitor.Poll(samples.data());
+    CHECK(!samples[0].violation.valid);
+
+    REQUIRE(standin.Advance());
+    standin.ResetCallCounts();
+    monitor.Poll(samples.data());
+    CHECK_EQ(standin.GetCallCount("nvmlDeviceGetFieldValues"), 1u);
+    CHECK_EQ(standin.GetCallCount("nvmlDeviceGetViolationStatus"), 0u);
+    CHECK(samples[0].violation.valid);
+    CHECK_EQ(samples[0].violation.interval_ns, 1000000000ull);
+    CHECK_EQ(samples[0].violation.throttled_ns[NVML_PERF_POLICY_POWER], 250000000ull);
+    CHECK_EQ(samples[0].violation.throttled_ns[NVML_PERF_POLICY_THERMAL], 100000000ull);
+    CHECK_NEAR(samples[0].violation.throttled_fraction, 0.25, 1e-6);
+}
+
+TEST_CASE(OldDriverFallsBackToViolationStatusCalls)
+{
+    CNvmlStandin standin;
+    CGpuMonitor monitor;
+    REQUIRE(StartMonitor(standin, monitor,
+        "devices 1\n"
+        "policy_fields 0 0\n"
+        "violation 0 0 1000000 0\n"
+        "frame\n"
+        "violation 0 0 2000000 500000000\n"));
+    std::vector<CGpuSample> samples(1);
+    monitor.Poll(samples.data());
+
+    REQUIRE(standin.Advance());
+    standin.ResetCallCounts();
+    monitor.Poll(samples.data());
+    CHECK_EQ(standin.GetCallCount("nvmlDeviceGetViolationStatus"), static_cast<unsigned int>(GPU_VIOLATION_COUNT));
+    CHECK(samples[0].violation.valid);
+    CHECK_EQ(samples[0].violation.throttled_ns[NVML_PERF_POLICY_POWER], 500000000ull);
+    CHECK_NEAR(samples[0].violation.throttled_fraction, 0.5, 1e-6);
+}
+
+TEST_CASE(FailedCallInvalidatesOnlyThatValue)
+{
+    CNvmlStandin standin;
+    CGpuMonitor monitor;
+    REQUIRE(StartMonitor(standin, monitor,
+        "devices 1\n"
+        "temp 0 70\n"
+        "fail nvmlDeviceGetTemperature 3 1\n"));    // NVML_ERROR_NOT_SUPPORTED，只失败一次
+    std::vector<CGpuSample> samples(1);
+    monitor.Poll(samples.data());
+    CHECK_EQ(samples[0].temperature, 0u);
+    CHECK_EQ(static_cast<int>(samples[0].health), static_cast<int>(GPU_HEALTH_OK));
+    monitor.Poll(samples.data());
+    CHECK_EQ(samples[0].temperature, 70u);
+}
+
+TEST_CASE(UtilizationAggregatesOnlyTheNewSamples)
+{
+    CNvmlStandin standin;
+    CGpuMonitor monitor;
+    REQUIRE(StartMonitor(standin, monitor,
+        "devices 1\n"
+        "util 0 30\n"
+        "util 0 70\n"
+        "util 0 50\n"
+        "frame\n"
+        "util 0 90\n"
+        "frame\n"));
+    std::vector<CGpuSample> samples(1);
+    monitor.Poll(samples.data());
+    for (int kind = 0; kind < GPU_UTIL_COUNT; ++kind) {
+        const CGpuUtilization& utilization = samples[0].utilization[kind];
+        CHECK_EQ(static_cast<int>(utilization.min), 30);
+        CHECK_EQ(static_cast<int>(utilization.mean), 50);
+        CHECK_EQ(static_cast<int>(utilization.max), 70);
+        CHECK_EQ(static_cast<int>(utilization.count), 3);
+    }
+
+    // 下一次只取上次时间戳之后的采样
+    REQUIRE(standin.Advance());
+    monitor.Poll(samples.data());
+    const CGpuUtilization& latest = samples[0].utilization[GPU_UTIL_GPU];
+    CHECK_EQ(static_cast<int>(latest.min), 90);
+    CHECK_EQ(static_cast<int>(latest.max), 90);
+    CHECK_EQ(static_cast<int>(latest.count), 1);
+
+    // 没有新采样（NVML_ERROR_NOT_FOUND）时沿用上一次的统计
+    REQUIRE(standin.Advance());
+    samples[0] = CGpuSample();
+    monitor.Poll(samples.data());
+    CHECK_EQ(static_cast<int>(samples[0].utilization[GPU_UTIL_MEMORY].mean), 90);
+    CHECK_EQ(static_cast<int>(samples[0].utilization[GPU_UTIL_MEMORY].count), 1);
+}
+
+TEST_CASE(MemoryAndBar1AreReadOnlyWhenAvailable)
+{
+    CNvmlStandin standin;
+    CGpuMonitor monitor;
+    REQUIRE(StartMonitor(standin, monitor,
+        "devices 2\n"
+        "memory 0 8589934592 2147483648 536870912\n"
+        "bar1 0 268435456 67108864\n"));
+    std::vector<CGpuSample> samples(2);
+    standin.ResetCallCounts();
+    monitor.Poll(samples.data());
+    CHECK_EQ(samples[0].memory.total, 8589934592ull);
+    CHECK_EQ(samples[0].memory.used, 2147483648ull);
+    CHECK_EQ(samples[0].memory.reserved, 536870912ull);
+    // BAR1 默认不读取
+    CHECK_EQ(samples[0].memory.bar1_total, 0ull);
+    CHECK_EQ(standin.GetCallCount("nvmlDeviceGetBAR1MemoryInfo"), 0u);
+    // 不支持显存查询的设备整体清零
+    CHECK_EQ(samples[1].memory.total, 0ull);
+
+    monitor.SetBar1Enabled(true);
+    monitor.Poll(samples.data());
+    CHECK_EQ(samples[0].memory.bar1_total, 268435456ull);
+    CHECK_EQ(samples[0].memory.bar1_used, 67108864ull);
+    CHECK_EQ(samples[1].memory.bar1_total, 0ull);
+    CHECK_EQ(standin.GetCallCount("nvmlDeviceGetBAR1MemoryInfo"), 2u);
+}
+
+TEST_CASE(ProcessListIsReadOnlyAfterARequest)
+{
+    CNvmlStandin standin;
+    CGpuMonitor monitor;
+    REQUIRE(StartMonitor(standin, monitor,
+        "devices 1\n"
+        "process 0 100 1000\n"));
+    std::vector<CGpuSample> samples(1);
+    standin.ResetCallCounts();
+    monitor.Poll(samples.data());
+    CHECK_EQ(samples[0].process_count, -1);
+    CHECK_EQ(standin.GetCallCount("nvmlDeviceGetComputeRunningProcesses_v3"), 0u);
+    CHECK_EQ(standin.GetCallCount("nvmlDeviceGetGraphicsRunningProcesses_v3"), 0u);
+
+    monitor.RequestProcesses();
+    monitor.Poll(samples.data());
+    CHECK_EQ(samples[0].process_count, 1);
+    CHECK_EQ(samples[0].top_processes[0].pid, 100u);
+    CHECK_EQ(standin.GetCallCount("nvmlDeviceGetComputeRunningProcesses_v3"), 1u);
+}
+
+TEST_CASE(TopProcessesAreSortedAndDeduplicated)
+{
+    CNvmlStandin standin;
+    CGpuMonitor monitor;
+    REQUIRE(StartMonitor(standin, monitor,
+        "devices 1\n"
+        "process 0 10 100\n"
+        "process 0 11 -1\n"              // WDDM 下显存不可用
+        "process 0 12 500\n"
+        "process 0 13 300\n"
+        "graphics_process 0 12 500\n"    // 同一进程的图形上下文
+        "graphics_process 0 14 400\n"
+        "frame\n"
+        "process 0 15 200\n"
+        "process 0 16 50\n"));
+    std::vector<CGpuSample> samples(1);
+    monitor.RequestProcesses();
+    monitor.Poll(samples.data());
+    const unsigned int expected[] = { 12, 14, 13, 10, 11 };
+    REQUIRE(samples[0].process_count == 5);
+    for (int i = 0; i < 5; ++i) CHECK_EQ(samples[0].top_processes[i].pid, expected[i]);
+    CHECK_EQ(samples[0].top_processes[0].used_memory, 500ull);
+    CHECK_EQ(samples[0].top_processes[4].used_memory, GPU_PROCESS_MEMORY_UNAVAILABLE);
+
+    // 更多进程时只保留显存最多的前 5 个，不可用的最先被挤掉
+    REQUIRE(standin.Advance());
+    monitor.RequestProcesses();
+    monitor.Poll(samples.data());
+    const unsigned int top[] = { 12, 14, 13, 15, 10 };
+    REQUIRE(samples[0].process_count == GPU_TOP_PROCESS_COUNT);
+    for (int i = 0; i < GPU_TOP_PROCESS_COUNT; ++i) CHECK_EQ(samples[0].top_processes[i].pid, top[i]);
+}
+
+TEST_CASE(ProcessBufferGrowsOnceForLongLists)
+{
+    std::string script = "devices 1\n";
+    for (int pid = 1; pid <= 100; ++pid) script += "process 0 " + std::to_string(pid) + " " + std::to_string(pid * 1000) + "\n";
+    CNvmlStandin standin;
+    CGpuMonitor monitor;
+    REQUIRE(StartMonitor(standin, monitor, script));
+    std::vector<CGpuSample> samples(1);
+    standin.ResetCallCounts();
+    monitor.RequestProcesses();
+    monitor.Poll(samples.data());
+    // NVML_ERROR_INSUFFICIENT_SIZE 后按报告的数量扩大缓冲区重试一次
+    CHECK_EQ(standin.GetCallCount("nvmlDeviceGetComputeRunningProcesses_v3"), 2u);
+    REQUIRE(samples[0].process_count == GPU_TOP_PROCESS_COUNT);
+    CHECK_EQ(samples[0].top_processes[0].pid, 100u);
+    CHECK_EQ(samples[0].top_processes[4].pid, 96u);
+
+    // 扩大后的缓冲区一直复用
+    monitor.Poll(samples.data());
+    CHECK_EQ(standin.GetCallCount("nvmlDeviceGetComputeRunningProcesses_v3"), 3u);
+    CHECK_EQ(standin.GetCallCount("nvmlDeviceGetGraphicsRunningProcesses_v3"), 2u);
+}
+
+TEST_CASE(EnergyCounterGivesAveragePowerBetweenPolls)
+{
+    CNvmlStandin standin;
+    CGpuMonitor monitor;
+    REQUIRE(StartMonitor(standin, monitor,
+        "devices 1\n"
+        "field 0 83 1000000\n"      // NVML_FI_DEV_TOTAL_ENERGY_CONSUMPTION (mJ)
+        "frame\n"
+        "field 0 83 1006000\n"
+        "frame\n"
+        "field 0 83 500\n"          // 驱动重载，计数器变小
+        "frame\n"
+        "field 0 83 2500\n"
+        "frame\n"
+        "field 0 83 -\n"
+        "frame\n"
+        "field 0 83 9000\n"));
+    std::vector<CGpuSample> samples(1);
+
+    // 首次读取只记录基准
+    monitor.Poll(samples.data());
+    CHECK_EQ(samples[0].energy_mj, 0ull);
+    CHECK(samples[0].average_power_w < 0.0f);
+
+    // mJ / ms 即 W
+    auto start = std::chrono::steady_clock::now();
+    Sleep(200);
+    REQUIRE(standin.Advance());
+    monitor.Poll(samples.data());
+    double expected_w = 6000.0 / ElapsedMs(start);
+    CHECK_EQ(samples[0].energy_mj, 6000ull);
+    CHECK_NEAR(samples[0].average_power_w, expected_w, expected_w * 0.1);
+
+    // 计数器变小时重新取基准，不产生差值
+    Sleep(20);
+    REQUIRE(standin.Advance());
+    monitor.Poll(samples.data());
+    CHECK_EQ(samples[0].energy_mj, 0ull);
+    Sleep(20);
+    REQUIRE(standin.Advance());
+    monitor.Poll(samples.data());
+    CHECK_EQ(samples[0].energy_mj, 2000ull);
+
+    // 字段不可用时清除状态，恢复后的第一次读取又只是基准
+    Sleep(20);
+    REQUIRE(standin.Advance());
+    monitor.Poll(samples.data());
+    CHECK_EQ(samples[0].energy_mj, 0ull);
+    CHECK(samples[0].average_power_w < 0.0f);
+    Sleep(20);
+    REQUIRE(standin.Advance());
+    monitor.Poll(samples.data());
+    CHECK_EQ(samples[0].energy_mj, 0ull);
+    CHECK(samples[0].average_power_w < 0.0f);
+}
+
+TEST_CASE(LostDeviceIsReinitializedAfterRestore)
+{
+    CNvmlStandin standin;
+    CGpuMonitor monitor;
+    REQUIRE(StartMonitor(standin, monitor,
+        "devices 2\n"
+        "frame\n"
+        "lost 1\n"
+        "frame\n"
+        "restore 1\n"));
+    std::vector<CGpuSample> samples(2);
+    monitor.Poll(samples.data());
+    CHECK_EQ(static_cast<int>(samples[1].health), static_cast<int>(GPU_HEALTH_OK));
+
+    REQUIRE(standin.Advance());
+    standin.ResetCallCounts();
+    monitor.Poll(samples.data());
+    CHECK_EQ(static_cast<int>(samples[0].health), static_cast<int>(GPU_HEALTH_OK));
+    CHECK_EQ(static_cast<int>(samples[1].health), static_cast<int>(GPU_HEALTH_LOST));
+    CHECK_EQ(static_cast<int>(monitor.GetState()), static_cast<int>(NVML_LOST));
+    // 掉卡的设备在第一个调用失败后就跳过，其余调用只发给正常的设备
+    CHECK_EQ(standin.GetCallCount("nvmlDeviceGetTemperature"), 1u);
+
+    // 每次初始化尝试都先计入退避，第一次重试在 5 秒后
+    REQUIRE(standin.Advance());
+    CHECK(!monitor.Maintain());
+    Sleep(5100);
+    CHECK(monitor.Maintain());
+    CHECK_EQ(monitor.GetGeneration(), 2u);
+    CHECK_EQ(static_cast<int>(monitor.GetState()), static_cast<int>(NVML_READY));
+    monitor.Poll(samples.data());
+    CHECK_EQ(static_cast<int>(samples[1].health), static_cast<int>(GPU_HEALTH_OK));
+}
+
+TEST_CASE(PerDeviceStateFollowsTheBusIdAcrossReinit)
+{
+    CNvmlStandin standin;
+    CGpuMonitor monitor;
+    REQUIRE(StartMonitor(standin, monitor,
+        "devices 2\n"
+        "busid 0 00000000:01:00.0\n"
+        "busid 1 00000000:41:00.0\n"
+        "reasons 1 0x20\n"
+        "frame\n"
+        "xid 1 79\n"
+        "frame\n"
+        "lost 0\n"
+        "frame\n"
+        // 重置后两块卡的枚举顺序互换
+        "restore 0\n"
+        "busid 0 00000000:41:00.0\n"
+        "busid 1 00000000:01:00.0\n"
+        "reasons 0 0x20\n"
+        "reasons 1 0\n"));
+    REQUIRE(monitor.StartXidListener());
+    std::vector<CGpuSample> samples(2);
+    monitor.Poll(samples.data());
+    Sleep(50);
+    monitor.Poll(samples.data());
+    int reason = DecodeClockEventReasons(0x20);
+    CHECK(samples[1].reason_fraction[reason] > 0.99f);
+    DWORD window_ms = samples[1].reason_window_ms;
+    CHECK(window_ms >= 40);
+
+    REQUIRE(standin.Advance());
+    auto start = std::chrono::steady_clock::now();
+    while (monitor.GetXidErrorCount(1) < 1 && ElapsedMs(start) < 2000) Sleep(5);
+    REQUIRE(monitor.GetXidErrorCount(1) == 1);
+
+    REQUIRE(standin.Advance());
+    monitor.Poll(samples.data());
+    CHECK_EQ(static_cast<int>(monitor.GetState()), static_cast<int>(NVML_LOST));
+    REQUIRE(standin.Advance());
+    CHECK(!monitor.Maintain());
+    Sleep(5100);
+    REQUIRE(monitor.Maintain());
+    REQUIRE(monitor.GetDevices().size() == 2);
+    CHECK(strcmp(monitor.GetDevices()[0].pci_bus_id, "00000000:41:00.0") == 0);
+
+    // 41:00.0 现在是设备 0：Xid 计数和原因窗口都跟着它走
+    CHECK_EQ(monitor.GetXidErrorCount(0), 1u);
+    CHECK_EQ(monitor.GetLastXid(0), 79u);
+    CHECK_EQ(monitor.GetXidErrorCount(1), 0u);
+    CHECK(monitor.IsXidListenerRunning());
+    monitor.Poll(samples.data());
+    CHECK_EQ(static_cast<int>(samples[0].health), static_cast<int>(GPU_HEALTH_OK));
+    CHECK_EQ(samples[0].xid_count, 1u);
+    CHECK(samples[0].reason_window_ms >= window_ms);
+    CHECK(samples[0].reason_fraction[reason] > 0.99f);
+    CHECK(samples[1].reason_fraction[reason] < 0.01f);
+    monitor.StopXidListener();
+}
+
+TEST_CASE(DriverNotLoadedAtStartupIsRetriedWithBackoff)
+{
+    CNvmlStandin standin;
+    CGpuMonitor monitor;
+    REQUIRE(standin.IsValid() && standin.Load(
+        "devices 1\n"
+        "fail nvmlInit_v2 9\n"));   // NVML_ERROR_DRIVER_NOT_LOADED
+    monitor.SetLibraryPath(standin.GetLibraryPath());
+    CHECK(!monitor.Maintain());
+    CHECK_EQ(static_cast<int>(monitor.GetState()), static_cast<int>(NVML_UNINITIALIZED));
+    // 退避期间不再尝试加载
+    CHECK(!monitor.Maintain());
+    CHECK_EQ(standin.GetCallCount("nvmlInit_v2"), 1u);
+}
+
+TEST_CASE(XidEventsAreCountedPerDevice)
+{
+    CNvmlStandin standin;
+    CGpuMonitor monitor;
+    REQUIRE(StartMonitor(standin, monitor,
+        "devices 2\n"
+        "frame\n"
+        "xid 1 79\n"
+        "xid 1 48\n"));
+    REQUIRE(monitor.StartXidListener());
+    REQUIRE(standin.Advance());
+
+    auto start = std::chrono::steady_clock::now();
+    while (monitor.GetXidErrorCount(1) < 2 && ElapsedMs(start) < 2000) Sleep(5);
+    CHECK_EQ(monitor.GetXidErrorCount(0), 0u);
+    CHECK_EQ(monitor.GetXidErrorCount(1), 2u);
+    CHECK_EQ(monitor.GetLastXid(1), 48u);
+    monitor.StopXidListener();
+}
+
+TEST_CASE(PerCallLatencyAppliesToEveryCall)
+{
+    CNvmlStandin standin;
+    CGpuMonitor monitor;
+    REQUIRE(StartMonitor(standin, monitor,
+        "devices 1\n"
+        "latency_us 2000\n"));
+    std::vector<CGpuSample> samples(1);
+    standin.ResetCallCounts();
+    auto start = std::chrono::steady_clock::now();
+    monitor.Poll(samples.data());
+    double elapsed = ElapsedMs(start);
+    unsigned int calls = standin.GetCallCount("nvmlDeviceGetCurrentClocksEventReasons")
+        + standin.GetCallCount("nvmlDeviceGetTemperature")
+        + standin.GetCallCount("nvmlDeviceGetFieldValues");
+    CHECK_EQ(calls, 3u);
+    CHECK(elapsed >= 2.0 * calls);
+}
+
+TEST_CASE(HungCallTimesOutWithoutBlockingTheCaller)
+{
+    CNvmlStandin standin;
+    CGpuMonitor monitor;
+    REQUIRE(StartMonitor(standin, monitor,
+        "devices 1\n"
+        "temp 0 60\n"
+        "hang nvmlDeviceGetCurrentClocksEventReasons 300 1\n"));
+    CGpuPollWorker worker;
+    REQUIRE(worker.Start(&monitor));
+    std::vector<CGpuSample> samples;
+
+    auto start = std::chrono::steady_clock::now();
+    CHECK_EQ(static_cast<int>(worker.Poll(samples, 50)), static_cast<int>(CGpuPollWorker::POLL_TIMEOUT));
+    CHECK(ElapsedMs(start) < 250);
+    // 驱动还没返回时不排队新的请求
+    CHECK_EQ(static_cast<int>(worker.Poll(samples, 0)), static_cast<int>(CGpuPollWorker::POLL_TIMEOUT));
+    CHECK_EQ(standin.GetCallCount("nvmlDeviceGetCurrentClocksEventReasons"), 1u);
+
+    Sleep(400);
+    CHECK_EQ(static_cast<int>(worker.Poll(samples, 1000)), static_cast<int>(CGpuPollWorker::POLL_OK));
+    REQUIRE(samples.size() == 1);
+    CHECK_EQ(samples[0].temperature, 60u);
+    CHECK(worker.Stop(1000));
+}
+
+TEST_CASE(LatePollEnergyIsCarriedIntoTheNextResult)
+{
+    CNvmlStandin standin;
+    CGpuMonitor monitor;
+    REQUIRE(StartMonitor(standin, monitor,
+        "devices 1\n"
+        "field 0 83 1000\n"         // NVML_FI_DEV_TOTAL_ENERGY_CONSUMPTION
+        "frame\n"
+        "field 0 83 5000\n"
+        "hang nvmlDeviceGetCurrentClocksEventReasons 300 1\n"
+        "frame\n"
+        "field 0 83 9000\n"));
+    CGpuPollWorker worker;
+    REQUIRE(worker.Start(&monitor));
+    std::vector<CGpuSample> samples;
+    REQUIRE(worker.Poll(samples, 1000) == CGpuPollWorker::POLL_OK);
+    CHECK_EQ(samples[0].energy_mj, 0ull);     // 首次只记录基准
+
+    Sleep(20);
+    REQUIRE(standin.Advance());
+    CHECK_EQ(static_cast<int>(worker.Poll(samples, 50)), static_cast<int>(CGpuPollWorker::POLL_TIMEOUT));
+    Sleep(400);     // 超时的轮询在后台完成，差值 4000 mJ 没有被取走
+
+    REQUIRE(standin.Advance());
+    REQUIRE(worker.Poll(samples, 1000) == CGpuPollWorker::POLL_OK);
+    CHECK_EQ(samples[0].energy_mj, 8000ull);
+    CHECK(worker.Stop(1000));
+}
+
+TEST_CASE(AbandonedThreadsOutliveTheirOwners)
+{
+    CNvmlStandin standin;
+    // 监控对象按插件的做法放弃后泄漏；工作线程对象正常析构
+    CGpuMonitor* monitor = new CGpuMonitor();
+    REQUIRE(StartMonitor(standin, *monitor,
+        "devices 1\n"
+        "frame\n"
+        "hang nvmlDeviceGetCurrentClocksEventReasons 600 1\n"
+        "hang nvmlEventSetWait_v2 600 1\n"));
+    REQUIRE(monitor->StartXidListener());
+    std::unique_ptr<CGpuPollWorker> worker(new CGpuPollWorker());
+    REQUIRE(worker->Start(monitor));
+    REQUIRE(standin.Advance());
+    standin.ResetCallCounts();
+
+    std::vector<CGpuSample> samples;
+    CHECK_EQ(static_cast<int>(worker->Poll(samples, 50)), static_cast<int>(CGpuPollWorker::POLL_TIMEOUT));
+    Sleep(300);     // Xid 监听线程也进入了卡住的等待
+
+    // 两个线程都卡在驱动里，停止和放弃都不等待它们
+    auto start = std::chrono::steady_clock::now();
+    CHECK(!worker->Stop(50));
+    monitor->Abandon();
+    monitor->Shutdown();
+    worker.reset();
+    CHECK(ElapsedMs(start) < 250);
+
+    // 驱动返回后工作线程在泄漏的共享块上完成本次轮询并退出，NVML 没有被卸载
+    Sleep(700);
+    CHECK_EQ(standin.GetCallCount("nvmlDeviceGetTemperature"), 1u);
+    CHECK_EQ(standin.GetCallCount("nvmlShutdown"), 0u);
+}
@@ -0,0 +1,235 @@
+﻿// tests/LinuxHardwareErrorsTest.cpp - 用临时目录中伪造的 sysfs/procfs 驱动 EDAC/AER/MCE 读取器
+#include "TestHarness.h"
+#include "TempDir.h"
+#include "Platform.h"
+#include "LinuxHardwareErrors.h"
+#include "SystemErrorMonitor.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace
+{
+    const std::vector<std::wstring> PROVIDERS = { L"disk", WHEA_PROVIDER_NAME };
+    const int WHEA_INDEX = 1;
+
+    const char EDAC_MC0[] = "sys/devices/system/edac/mc/mc0/";
+    const char AER_DEVICE[] = "sys/bus/pci/devices/0000:41:00.0/";
+
+    std::string AerCorrectable(unsigned int total)
+    {
+        return "RxErr 0\nBadTLP " + std::to_string(total) + "\nBadDLLP 0\nRollover 0\nTimeout 0\n"
+            "NonFatalErr 0\nCorrIntErr 0\nHeaderOF 0\nTOTAL_ERR_COR " + std::to_string(total) + "\n";
+    }
+
+    // 每个处理器一列，后面是说明文字
+    std::string Interrupts(int cpus, unsigned int mce_per_cpu)
+    {
+        std::string header = "     ";
+        std::string timer = "  0:";
+        std::string mce = "MCE:";
+        for (int i = 0; i < cpus; ++i) {
+            header += "      CPU" + std::to_string(i);
+            timer += "         42";
+            mce += "          " + std::to_string(mce_per_cpu);
+        }
+        return header + "\n" + timer + "   IO-APIC    2-edge      timer\n" + " " + mce + "   Machine check exceptions\n"
+            + " MCP:" + timer.substr(4) + "   Machine check polls\n";
+    }
+
+    // 一台有一个内存控制器、一个带 AER 的 PCIe 设备的机器，计数全为 0
+    void WriteMachine(const CTempDir& dir, int cpus = 4)
+    {
+        dir.WriteFile(std::string(EDAC_MC0) + "ce_count", "0\n");
+        dir.WriteFile(std::string(EDAC_MC0) + "ue_count", "0\n");
+        dir.WriteFile("sys/devices/system/edac/mc/power/control", "auto\n");
+        dir.WriteFile(std::string(AER_DEVICE) + "aer_dev_correctable", AerCorrectable(0));
+        dir.WriteFile(std::string(AER_DEVICE) + "aer_dev_nonfatal", "Undefined 0\nTOTAL_ERR_NONFATAL 0\n");
+        dir.WriteFile(std::string(AER_DEVICE) + "aer_dev_fatal", "Undefined 0\nTOTAL_ERR_FATAL 0\n");
+        dir.WriteFile("sys/bus/pci/devices/0000:00:00.0/vendor", "0x8086\n");   // 没有 AER 的设备
+        dir.WriteFile("proc/interrupts", Interrupts(cpus, 0));
+    }
+
+    std::vector<CLogEvent> Read(CLinuxHardwareErrorReader& reader)
+    {
+        std::vector<CLogEvent> events;
+        CHECK(reader.ReadNewEvents([&](const CLogEvent& event) { events.push_back(event); }));
+        return events;
+    }
+}
+
+TEST_CASE(ParsesSingleValuesKeyedTotalsAndPerCpuColumns)
+{
+    unsigned long long value = 0;
+    const std::string single = "17\n";
+    CHECK(ParseErrorCounter(single.data(), single.size(), nullptr, &value));
+    CHECK_EQ(value, 17ull);
+
+    const std::string aer = AerCorrectable(5);
+    CHECK(ParseErrorCounter(aer.data(), aer.size(), "TOTAL_ERR_COR", &value));
+    CHECK_EQ(value, 5ull);
+
+    const std::string interrupts = Interrupts(3, 2);
+    CHECK(ParseErrorCounter(interrupts.data(), interrupts.size(), "MCE:", &value));
+    CHECK_EQ(value, 6ull);
+
+    unsigned long long columns[2] = {};
+    CHECK_EQ(ParseErrorColumns(interrupts.data(), interrupts.size(), "MCE:", columns, 2), 3);
+    CHECK_EQ(columns[0], 2ull);
+    CHECK_EQ(columns[1], 2ull);
+    CHECK_EQ(ParseErrorColumns(interrupts.data(), interrupts.size(), "NMI:", columns, 2), -1);
+
+    value = 99;
+    CHECK(!ParseErrorCounter(interrupts.data(), interrupts.size(), "NMI:", &value));
+    CHECK(!ParseErrorCounter("auto\n", 5, nullptr, &value));
+    CHECK_EQ(value, 99ull);
+}
+
+TEST_CASE(OpensEveryCounterOnceAndTakesABaseline)
+{
+    CTempDir dir;
+    REQUIRE(dir.IsValid());
+    WriteMachine(dir);
+    dir.WriteFile(std::string(EDAC_MC0) + "ce_count", "40\n");     // 开机以来的旧错误
+
+    CLinuxHardwareErrorReader reader(PROVIDERS, true, dir.GetPath().c_str());
+    CHECK_EQ(reader.GetCounterCount(), 6);
+    CHECK(reader.IsPushBased());
+    CHECK(Read(reader).empty());
+    CHECK(Read(reader).empty());
+}
+
+TEST_CASE(ReportsDeltasWithSeverityAndPciAddress)
+{
+    CTempDir dir;
+    REQUIRE(dir.IsValid());
+    WriteMachine(dir);
+    CLinuxHardwareErrorReader reader(PROVIDERS, false, dir.GetPath().c_str());
+    Read(reader);
+
+    dir.WriteFile(std::string(EDAC_MC0) + "ce_count", "3\n");
+    dir.WriteFile(std::string(AER_DEVICE) + "aer_dev_fatal", "Undefined 1\nTOTAL_ERR_FATAL 1\n");
+    dir.WriteFile("proc/interrupts", Interrupts(4, 1));
+    std::vector<CLogEvent> events = Read(reader);
+    REQUIRE(events.size() == 3);
+
+    CHECK_EQ(events[0].provider, WHEA_INDEX);
+    CHECK_EQ(events[0].count, 3u);
+    CHECK(events[0].has_whea);
+    CHECK_EQ(static_cast<int>(events[0].whea.severity), static_cast<int>(WHEA_CORRECTED));
+
+    CHECK_EQ(events[1].count, 1u);
+    CHECK_EQ(static_cast<int>(events[1].whea.severity), static_cast<int>(WHEA_FATAL));
+    CHECK_EQ(static_cast<int>(events[1].whea.source), 4);
+    CHECK(events[1].whea.HasPciAddress());
+    CHECK_EQ(static_cast<int>(events[1].whea.pci_bus), 0x41);
+    CHECK_EQ(static_cast<int>(events[1].whea.pci_device), 0);
+
+    CHECK_EQ(events[2].count, 1u);     // 广播到 4 个处理器的一次机器检查
+    CHECK_EQ(static_cast<int>(events[2].whea.severity), static_cast<int>(WHEA_UNCORRECTED));
+    CHECK_EQ(static_cast<int>(events[2].whea.source), 0);
+    CHECK(!events[2].whea.HasPciAddress());
+
+    CHECK(Read(reader).empty());
+}
+
+TEST_CASE(CounterResetTakesANewBaseline)
+{
+    CTempDir dir;
+    REQUIRE(dir.IsValid());
+    WriteMachine(dir);
+    dir.WriteFile(std::string(EDAC_MC0) + "ue_count", "5\n");
+    CLinuxHardwareErrorReader reader(PROVIDERS, true, dir.GetPath().c_str());
+    Read(reader);
+
+    // EDAC 驱动重新加载后计数从 0 开始
+    dir.WriteFile(std::string(EDAC_MC0) + "ue_count", "1\n");
+    CHECK(Read(reader).empty());
+    dir.WriteFile(std::string(EDAC_MC0) + "ue_count", "2\n");
+    std::vector<CLogEvent> events = Read(reader);
+    REQUIRE(events.size() == 1);
+    CHECK_EQ(events[0].count, 1u);
+}
+
+TEST_CASE(LargeInterruptTableGrowsTheBuffer)
+{
+    CTempDir dir;
+    REQUIRE(dir.IsValid());
+    WriteMachine(dir, 1024);
+    CLinuxHardwareErrorReader reader(PROVIDERS, true, dir.GetPath().c_str());
+    Read(reader);
+    dir.WriteFile("proc/interrupts", Interrupts(1024, 1));
+    std::vector<CLogEvent> events = Read(reader);
+    REQUIRE(events.size() == 1);
+    CHECK_EQ(events[0].count, 1u);
+}
+
+TEST_CASE(MachineCheckCountsTheLargestPerCpuDelta)
+{
+    CTempDir dir;
+    REQUIRE(dir.IsValid());
+    WriteMachine(dir);
+    CLinuxHardwareErrorReader reader(PROVIDERS, true, dir.GetPath().c_str());
+    Read(reader);
+
+    // 一次广播加上 CPU2 上两次本地机器检查
+    dir.WriteFile("proc/interrupts", " MCE:          1          1          3          1   Machine check exceptions\n");
+    std::vector<CLogEvent> events = Read(reader);
+    REQUIRE(events.size() == 1);
+    CHECK_EQ(events[0].count, 3u);
+
+    // 处理器数变化时重新取基准，之后照常按最大增量计数
+    dir.WriteFile("proc/interrupts", Interrupts(8, 5));
+    CHECK(Read(reader).empty());
+    dir.WriteFile("proc/interrupts", Interrupts(8, 7));
+    events = Read(reader);
+    REQUIRE(events.size() == 1);
+    CHECK_EQ(events[0].count, 2u);
+}
+
+TEST_CASE(NothingIsOpenedWithoutTheWheaProvider)
+{
+    CTempDir dir;
+    REQUIRE(dir.IsValid());
+    WriteMachine(dir);
+    CLinuxHardwareErrorReader reader({ L"disk" }, true, dir.GetPath().c_str());
+    CHECK_EQ(reader.GetCounterCount(), 0);
+    CHECK(Read(reader).empty());
+
+    // 没有任何来源的机器同样可以正常读取
+    CTempDir empty;
+    CLinuxHardwareErrorReader bare(PROVIDERS, true, empty.GetPath().c_str());
+    CHECK_EQ(bare.GetCounterCount(), 0);
+    CHECK(Read(bare).empty());
+}
+
+TEST_CASE(DeltasDriveTheSystemErrorLevel)
+{
+    CTempDir dir;
+    REQUIRE(dir.IsValid());
+    WriteMachine(dir);
+    std::string root = dir.GetPath();
+    CSystemErrorMonitor monitor([&root](const std::vector<std::wstring>& providers, bool subscribe) {
+        return std::unique_ptr<IEventLogReader>(new CLinuxHardwareErrorReader(providers, subscribe, root.c_str()));
+    });
+    monitor.Configure(PROVIDERS, true);
+
+    FILETIME file_time;
+    GetSystemTimeAsFileTime(&file_time);
+    unsigned long long now = (static_cast<unsigned long long>(file_time.dwHighDateTime) << 32) | file_time.dwLowDateTime;
+    monitor.Update(1000, now);
+    CHECK_EQ(static_cast<int>(monitor.GetLevel()), static_cast<int>(SYSTEM_ERROR_NONE));
+
+    dir.WriteFile(std::string(AER_DEVICE) + "aer_dev_correctable", AerCorrectable(2));
+    monitor.Update(2000, now + 10000000);
+    CHECK_EQ(monitor.GetCount(WHEA_INDEX), 2u);
+    CHECK_EQ(monitor.GetWheaLog().GetCount(WHEA_CORRECTED), 2u);
+    CHECK_EQ(monitor.GetWheaLog().GetRecordCount(), 1);
+    CHECK_EQ(static_cast<int>(monitor.GetLevel()), static_cast<int>(SYSTEM_ERROR_CORRECTED));
+
+    dir.WriteFile(std::string(EDAC_MC0) + "ue_count", "1\n");
+    monitor.Update(3000, now + 20000000);
+    CHECK_EQ(monitor.GetWheaLog().GetCount(WHEA_UNCORRECTED), 1u);
+    CHECK_EQ(static_cast<int>(monitor.GetLevel()), static_cast<int>(SYSTEM_ERROR_UNCORRECTED));
+    CHECK_EQ(monitor.GetCount(0), 0u);
+}
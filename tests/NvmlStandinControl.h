@@ -0,0 +1,58 @@
+// tests/NvmlStandinControl.h - 加载 NVML 替身库并通过它的控制接口驱动测试脚本
+#pragma once
+#include <string>
+#include "Platform.h"
+#include "NvmlStandin.h"
+#include "TempDir.h"
+
+// =================================================================
+// 测试自己也持有一份替身库的引用：CGpuMonitor 重新初始化时卸载库，
+// 脚本状态（设备、故障、调用计数）仍然保留，与驱动在重置前后一直存在的情况一致
+// =================================================================
+class CNvmlStandin
+{
+public:
+    CNvmlStandin()
+    {
+        std::string narrow = NVML_STANDIN_PATH;
+        m_library_path.assign(narrow.begin(), narrow.end());
+        m_module = LoadLibraryW(m_library_path.c_str());
+        if (!m_module) return;
+        p_load = (decltype(p_load))GetProcAddress(m_module, "nvmlStandinLoad");
+        p_advance = (decltype(p_advance))GetProcAddress(m_module, "nvmlStandinAdvance");
+        p_get_call_count = (decltype(p_get_call_count))GetProcAddress(m_module, "nvmlStandinGetCallCount");
+        p_reset_call_counts = (decltype(p_reset_call_counts))GetProcAddress(m_module, "nvmlStandinResetCallCounts");
+    }
+
+    ~CNvmlStandin()
+    {
+        if (m_module) FreeLibrary(m_module);
+    }
+
+    CNvmlStandin(const CNvmlStandin&) = delete;
+    CNvmlStandin& operator=(const CNvmlStandin&) = delete;
+
+    bool IsValid() const { return p_load && p_advance && p_get_call_count && p_reset_call_counts && m_dir.IsValid(); }
+    const wchar_t* GetLibraryPath() const { return m_library_path.c_str(); }
+
+    // 把脚本写入临时文件后加载
+    bool Load(const std::string& script)
+    {
+        std::string path = m_dir.WriteFile("script" + std::to_string(++m_script_count) + ".nvml", script);
+        return !path.empty() && p_load(path.c_str()) == 1;
+    }
+
+    bool Advance() { return p_advance() == 1; }
+    unsigned int GetCallCount(const char* function) const { return p_get_call_count(function); }
+    void ResetCallCounts() { p_reset_call_counts(); }
+
+private:
+    std::wstring m_library_path;
+    HMODULE m_module = nullptr;
+    CTempDir m_dir;
+    int m_script_count = 0;
+    decltype(nvmlStandinLoad)* p_load = nullptr;
+    decltype(nvmlStandinAdvance)* p_advance = nullptr;
+    decltype(nvmlStandinGetCallCount)* p_get_call_count = nullptr;
+    decltype(nvmlStandinResetCallCounts)* p_reset_call_counts = nullptr;
+};
@@ -0,0 +1,148 @@
+﻿// tests/ProcStatSamplerTest.cpp - /proc/stat 解析器与采样后端
+#include "TestHarness.h"
+#include "TempDir.h"
+#include "LinuxProcStatSampler.h"
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+namespace
+{
+    // 生成 count 个 cpu 行；第 i 个处理器 busy = base + i，idle = base * 3
+    std::string BuildStat(int count, uint64_t base, bool with_tail = true)
+    {
+        std::string text = "cpu  1 2 3 4 5 6 7 8 0 0\n";
+        for (int i = 0; i < count; ++i) {
+            // user nice system idle iowait irq softirq steal guest guest_nice
+            text += "cpu" + std::to_string(i) + " " + std::to_string(base + i) + " 0 0 " + std::to_string(base * 3)
+                + " 0 0 0 0 " + std::to_string(base) + " 0\n";
+        }
+        if (with_tail) text += "intr 123456 0 0 0 0\nctxt 98765\nbtime 1700000000\n";
+        return text;
+    }
+}
+
+TEST_CASE(ParsesPerCpuLinesAndSkipsAggregate)
+{
+    const std::string text =
+        "cpu  200 10 100 1000 50 5 5 0 30 0\n"
+        "cpu0 100 5 50 500 20 2 3 0 15 0\n"
+        "cpu1 100 5 50 500 30 3 2 0 15 0\n"
+        "intr 1 2 3\n";
+    CCpuJiffies times[4] = {};
+    bool complete = false;
+    CHECK_EQ(ParseProcStat(text.data(), text.size(), times, 4, &complete), 2);
+    CHECK(complete);
+    // guest 已经包含在 user 中，不重复计入
+    CHECK_EQ(times[0].busy, 100u + 5 + 50 + 2 + 3 + 0);
+    CHECK_EQ(times[0].total, times[0].busy + 500 + 20);
+    CHECK_EQ(times[1].busy, 100u + 5 + 50 + 3 + 2 + 0);
+    CHECK_EQ(times[1].total, times[1].busy + 500 + 30);
+}
+
+TEST_CASE(LeavesOfflineCpusUntouched)
+{
+    const std::string text = "cpu  0 0 0 0\ncpu0 1 0 0 9\ncpu2 3 0 0 7\nctxt 1\n";
+    CCpuJiffies times[3] = { { 0, 0 }, { 42, 84 }, { 0, 0 } };
+    CHECK_EQ(ParseProcStat(text.data(), text.size(), times, 3), 2);
+    CHECK_EQ(times[1].busy, 42u);
+    CHECK_EQ(times[1].total, 84u);
+    CHECK_EQ(times[2].busy, 3u);
+}
+
+TEST_CASE(AcceptsOldKernelFieldCounts)
+{
+    // 2.4 内核只有 4 个字段
+    const std::string text = "cpu  1 2 3 4\ncpu0 1 2 3 4\n";
+    CCpuJiffies times[1] = {};
+    CHECK_EQ(ParseProcStat(text.data(), text.size(), times, 1), 1);
+    CHECK_EQ(times[0].busy, 6u);
+    CHECK_EQ(times[0].total, 10u);
+
+    const std::string too_short = "cpu0 1 2 3\n";
+    CHECK_EQ(ParseProcStat(too_short.data(), too_short.size(), times, 1), -1);
+
+    const std::string garbage = "cpu0 1 x 3 4\n";
+    CHECK_EQ(ParseProcStat(garbage.data(), garbage.size(), times, 1), -1);
+}
+
+TEST_CASE(StopsAtTruncatedLine)
+{
+    const std::string text = "cpu0 1 0 0 9\ncpu1 5 0 0 5";
+    CCpuJiffies times[2] = {};
+    bool complete = true;
+    CHECK_EQ(ParseProcStat(text.data(), text.size(), times, 2, &complete), 1);
+    CHECK(!complete);
+    CHECK_EQ(times[1].total, 0u);
+}
+
+TEST_CASE(IgnoresCpusBeyondCapacity)
+{
+    const std::string text = BuildStat(8, 100);
+    CCpuJiffies times[4] = {};
+    bool complete = false;
+    CHECK_EQ(ParseProcStat(text.data(), text.size(), times, 4, &complete), 4);
+    CHECK(complete);
+    CHECK_EQ(times[3].busy, 103u);
+}
+
+TEST_CASE(Parses1024Cpus)
+{
+    const int COUNT = 1024;
+    const std::string text = BuildStat(COUNT, 1000);
+    std::vector<CCpuJiffies> times(COUNT);
+    CHECK_EQ(ParseProcStat(text.data(), text.size(), times.data(), COUNT), COUNT);
+    CHECK_EQ(times[COUNT - 1].busy, 1000u + COUNT - 1);
+    CHECK_EQ(times[COUNT - 1].total, 1000u + COUNT - 1 + 3000);
+}
+
+TEST_CASE(SamplerComputesUsageFromDeltas)
+{
+    CTempDir dir;
+    REQUIRE(dir.IsValid());
+    std::string path = dir.WriteFile("stat", "cpu0 100 0 0 100\ncpu1 0 0 0 0\nintr 0\n");
+    CLinuxProcStatSampler sampler(path.c_str());
+    REQUIRE(sampler.Init(2));
+
+    // 文件原地改写，已打开的描述符下一次 pread 读到新内容
+    dir.WriteFile("stat", "cpu0 175 0 0 125\ncpu1 10 0 0 30\nintr 0\n");
+    double usage[2] = { -1.0, -1.0 };
+    REQUIRE(sampler.Sample(usage, 2));
+    CHECK_NEAR(usage[0], 0.75, 1e-9);
+    CHECK_NEAR(usage[1], 0.25, 1e-9);
+
+    // 没有新的节拍时为 0，而不是除以 0
+    REQUIRE(sampler.Sample(usage, 2));
+    CHECK_NEAR(usage[0], 0.0, 1e-9);
+    CHECK_NEAR(usage[1], 0.0, 1e-9);
+}
+
+TEST_CASE(SamplerGrowsBufferForLargeMachines)
+{
+    // 2048 个 cpu 行超过初始的 64 KB 缓冲区
+    const int COUNT = 2048;
+    CTempDir dir;
+    REQUIRE(dir.IsValid());
+    std::string path = dir.WriteFile("stat", BuildStat(COUNT, 1000));
+    CLinuxProcStatSampler sampler(path.c_str());
+    REQUIRE(sampler.Init(COUNT));
+
+    dir.WriteFile("stat", BuildStat(COUNT, 2000));
+    std::vector<double> usage(COUNT, -1.0);
+    REQUIRE(sampler.Sample(usage.data(), COUNT));
+    // busy 与 idle 各增加 1000 和 3000
+    CHECK_NEAR(usage[0], 0.25, 1e-9);
+    CHECK_NEAR(usage[COUNT - 1], 0.25, 1e-9);
+}
+
+TEST_CASE(SamplerReadsRealProcStat)
+{
+    if (access("/proc/stat", R_OK) != 0) return;
+    int count = static_cast<int>(sysconf(_SC_NPROCESSORS_CONF));
+    REQUIRE(count > 0);
+    CLinuxProcStatSampler sampler;
+    REQUIRE(sampler.Init(count));
+    std::vector<double> usage(count, -1.0);
+    REQUIRE(sampler.Sample(usage.data(), count));
+    for (double value : usage) CHECK(value >= 0.0 && value <= 1.0);
+}
@@ -0,0 +1,106 @@
+﻿// tests/RenderTest.cpp - 条形图、热力图、历史曲线与画布基本操作的参考图测试
+#include "TestHarness.h"
+#include "GoldenImage.h"
+#include "CoreRender.h"
+#include "CoreHistory.h"
+#include <vector>
+
+namespace
+{
+    const uint32_t BG = 0x202020;
+    const uint32_t BAR = 0x76CA53;
+    const uint32_t ICON = 0xFFFFFF;
+
+    const GoldenPalette BAR_PALETTE = { { BG, '.' }, { BAR, '#' }, { ICON, 'o' } };
+
+    // 热力图各档位依次用 0~7 表示，边框用 B
+    const uint32_t LEVELS[HEATMAP_COLOR_LEVELS] = { 0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17 };
+    const uint32_t BORDER = 0xFFFFFF;
+
+    GoldenPalette HeatmapPalette()
+    {
+        GoldenPalette palette = { { BG, '.' }, { BORDER, 'B' } };
+        for (int i = 0; i < HEATMAP_COLOR_LEVELS; ++i) palette.push_back({ LEVELS[i], static_cast<char>('0' + i) });
+        return palette;
+    }
+}
+
+TEST_CASE(CanvasClipsRectsAndMasks)
+{
+    CPixelCanvas canvas;
+    canvas.Resize(8, 6);
+    canvas.Clear(BG);
+    canvas.FillRect(-2, -2, 3, 2, BAR);         // 左上角裁剪
+    canvas.FrameRect(4, 1, 10, 5, ICON);        // 右侧超出画布
+    static const uint8_t cross[3] = { 0b010, 0b111, 0b010 };
+    canvas.DrawMask(-1, 3, cross, 3, 3, BAR);   // 左下角部分可见
+    CHECK_GOLDEN(canvas, BAR_PALETTE, "canvas_clipping");
+}
+
+TEST_CASE(BarWithPeakTick)
+{
+    CPixelCanvas canvas;
+    canvas.Resize(8, 20);
+    RenderCoreBar(canvas, 12, 17, BG, BAR);
+    CHECK_GOLDEN(canvas, BAR_PALETTE, "bar_60_peak_85");
+}
+
+TEST_CASE(FullBarWithoutPeak)
+{
+    CPixelCanvas canvas;
+    canvas.Resize(8, 20);
+    RenderCoreBar(canvas, 20, 0, BG, BAR);
+    CHECK_GOLDEN(canvas, BAR_PALETTE, "bar_full");
+}
+
+TEST_CASE(EfficiencyCoreBarHasCenteredGlyph)
+{
+    CPixelCanvas canvas;
+    canvas.Resize(8, 20);
+    RenderCoreBar(canvas, 5, 0, BG, BAR);
+    DrawECoreGlyph(canvas, ICON);
+    CHECK_GOLDEN(canvas, BAR_PALETTE, "bar_e_core");
+}
+
+TEST_CASE(HeatmapFillsColumnsAndFramesEfficiencyCores)
+{
+    // 16 个核心，高 20 像素时每列 5 个 4 像素的方格；后 8 个为 E-Core
+    std::vector<double> usage(16);
+    std::vector<uint8_t> e_core(16, 0);
+    for (int i = 0; i < 16; ++i) {
+        usage[i] = i / 15.0;
+        e_core[i] = i >= 8 ? 1 : 0;
+    }
+    CPixelCanvas canvas;
+    canvas.Resize(16, 20);
+    RenderHeatmap(canvas, usage.data(), e_core.data(), 16, LEVELS, BG, BORDER);
+    CHECK_GOLDEN(canvas, HeatmapPalette(), "heatmap_16_cores");
+}
+
+TEST_CASE(HeatmapShrinksCellsWhenCoresDoNotFit)
+{
+    // 64 个核心放进 12 x 12：方格缩小到 1 像素，没有间隙也不画边框
+    std::vector<double> usage(64);
+    std::vector<uint8_t> e_core(64, 1);
+    for (int i = 0; i < 64; ++i) usage[i] = (i % 8) / 7.0;
+    CPixelCanvas canvas;
+    canvas.Resize(12, 12);
+    RenderHeatmap(canvas, usage.data(), e_core.data(), 64, LEVELS, BG, BORDER);
+    CHECK_GOLDEN(canvas, HeatmapPalette(), "heatmap_64_cores_small");
+}
+
+TEST_CASE(SparklineCompressesFullHistory)
+{
+    // 0 -> 100% 的锯齿波，周期 40 个样本；120 个样本压缩进 30 列
+    CCoreHistory history;
+    history.Init(1);
+    for (int i = 0; i < CCoreHistory::CAPACITY; ++i) {
+        double value = (i % 40) / 39.0;
+        history.Push(&value);
+    }
+    CPixelCanvas canvas;
+    canvas.Resize(30, 10);
+    canvas.Clear(BG);
+    RenderSparkline(history, 0, canvas, BAR);
+    CHECK_GOLDEN(canvas, BAR_PALETTE, "sparkline_sawtooth");
+}
@@ -0,0 +1,105 @@
+﻿// tests/SamplerThreadTest.cpp - 三缓冲快照与采样线程：慢速后端不能拖慢读取端
+#include "TestHarness.h"
+#include "SamplerThread.h"
+#include "CpuSampler.h"
+#include "CoreHistory.h"
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+namespace
+{
+    const int CORES = 256;
+
+    struct CTestSnapshot
+    {
+        std::vector<double> core_usage;
+        unsigned int sequence = 0;
+    };
+
+    // 每次采样阻塞 delay_ms，模拟卡住的 PDH/NVML/事件日志调用
+    class CSlowSampler : public ICpuSampler
+    {
+    public:
+        explicit CSlowSampler(DWORD delay_ms) : m_delay_ms(delay_ms) {}
+
+        bool Sample(double* usage, int num_cores) override
+        {
+            Sleep(m_delay_ms);
+            ++m_calls;
+            for (int i = 0; i < num_cores; ++i) usage[i] = ((m_calls + i) % 100) / 100.0;
+            return true;
+        }
+
+        std::atomic<int> m_calls{ 0 };
+
+    private:
+        DWORD m_delay_ms;
+    };
+}
+
+TEST_CASE(ReaderSeesLatestPublishedSnapshot)
+{
+    CTripleBuffer<int> buffer;
+    buffer.InitSlots([](int& slot) { slot = 0; });
+    CHECK_EQ(buffer.Read(), 0);
+    buffer.WriteBuffer() = 1;
+    buffer.Publish();
+    buffer.WriteBuffer() = 2;
+    buffer.Publish();
+    CHECK_EQ(buffer.Read(), 2);
+    // 没有新发布时返回同一份
+    CHECK_EQ(buffer.Read(), 2);
+    buffer.WriteBuffer() = 3;
+    buffer.Publish();
+    CHECK_EQ(buffer.Read(), 3);
+}
+
+TEST_CASE(SlowBackendDoesNotBlockDataRequired)
+{
+    CTripleBuffer<CTestSnapshot> snapshots;
+    snapshots.InitSlots([](CTestSnapshot& slot) { slot.core_usage.assign(CORES, 0.0); });
+    CSlowSampler sampler(500);
+    unsigned int sequence = 0;
+
+    CSamplerThread thread;
+    thread.Start(100, [&]() {
+        CTestSnapshot& snapshot = snapshots.WriteBuffer();
+        sampler.Sample(snapshot.core_usage.data(), CORES);
+        snapshot.sequence = ++sequence;
+        snapshots.Publish();
+    });
+
+    // 与 DataRequired 相同的工作：读快照、复制到显示缓冲区、写入历史
+    std::vector<double> display(CORES);
+    CCoreHistory history;
+    history.Init(CORES);
+    unsigned int last_sequence = 0;
+    std::vector<double> times;
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(1300);
+    while (std::chrono::steady_clock::now() < deadline) {
+        auto start = std::chrono::steady_clock::now();
+        const CTestSnapshot& snapshot = snapshots.Read();
+        std::copy(snapshot.core_usage.begin(), snapshot.core_usage.end(), display.begin());
+        if (snapshot.sequence != last_sequence) {
+            history.Push(snapshot.core_usage.data());
+            last_sequence = snapshot.sequence;
+        }
+        times.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count());
+        Sleep(2);
+    }
+    thread.Stop();
+
+    // 采样线程在此期间至少完成两次慢速采样，读取端一直拿得到最新快照
+    CHECK(sampler.m_calls.load() >= 2);
+    CHECK(last_sequence >= 2);
+    CHECK_EQ(history.GetSize(), static_cast<int>(last_sequence));
+    std::sort(times.begin(), times.end());
+    REQUIRE(!times.empty());
+    double p99 = times[static_cast<size_t>(0.99 * (times.size() - 1))];
+    CHECK(p99 < 50.0);
+    // 单次读取可能被调度器抢占（ctest 并行运行时尤其明显），最大值只要求远小于一次慢速采样
+    CHECK(times.back() < 5000.0);
+    std::printf("    DataRequired 等价读取：%zu 次，中位数 %.2f us，P99 %.2f us，最大 %.2f us\n",
+        times.size(), times[times.size() / 2], p99, times.back());
+}
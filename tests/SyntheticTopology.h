@@ -0,0 +1,84 @@
+// tests/SyntheticTopology.h - 合成 GetLogicalProcessorInformationEx 缓冲区，用于大核数拓扑的测试和基准
+#pragma once
+#include <cstddef>
+#include <cstring>
+#include <vector>
+#include "Platform.h"
+
+// =================================================================
+// 按 Windows 的布局生成 RelationGroup + RelationProcessorCore 记录
+// 每组的逻辑处理器从编号 0 起连续排列，每 threads_per_core 个组成一个物理核心
+// efficiency 为空时所有核心的能效等级都是 0，否则按物理核心的全局序号循环取值
+// =================================================================
+class CSyntheticTopology
+{
+public:
+    void AddGroup(int active_count) { m_groups.push_back(active_count); }
+    void SetThreadsPerCore(int threads) { m_threads_per_core = threads > 0 ? threads : 1; }
+    void SetEfficiencyClasses(const std::vector<BYTE>& classes) { m_efficiency = classes; }
+
+    // count 个逻辑处理器，按每组 64 个分组（与 Windows 对 64 核以上机器的默认分组相同）
+    static CSyntheticTopology Uniform(int count, int threads_per_core = 1)
+    {
+        CSyntheticTopology topology;
+        for (int offset = 0; offset < count; offset += 64) topology.AddGroup(min(64, count - offset));
+        topology.SetThreadsPerCore(threads_per_core);
+        return topology;
+    }
+
+    std::vector<BYTE> Build() const
+    {
+        std::vector<BYTE> buffer;
+        const size_t group_header = offsetof(SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX, Group) + offsetof(GROUP_RELATIONSHIP, GroupInfo);
+        size_t group_size = Align(group_header + m_groups.size() * sizeof(PROCESSOR_GROUP_INFO));
+        SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX* group = Append(buffer, group_size);
+        group->Relationship = RelationGroup;
+        group->Group.MaximumGroupCount = static_cast<WORD>(m_groups.size());
+        group->Group.ActiveGroupCount = static_cast<WORD>(m_groups.size());
+        for (size_t g = 0; g < m_groups.size(); ++g) {
+            PROCESSOR_GROUP_INFO& info = group->Group.GroupInfo[g];
+            info.MaximumProcessorCount = static_cast<BYTE>(m_groups[g]);
+            info.ActiveProcessorCount = static_cast<BYTE>(m_groups[g]);
+            info.ActiveProcessorMask = Mask(0, m_groups[g]);
+        }
+
+        const size_t core_size = Align(offsetof(SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX, Processor)
+            + offsetof(PROCESSOR_RELATIONSHIP, GroupMask) + sizeof(GROUP_AFFINITY));
+        int core_index = 0;
+        for (size_t g = 0; g < m_groups.size(); ++g) {
+            for (int first = 0; first < m_groups[g]; first += m_threads_per_core, ++core_index) {
+                SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX* core = Append(buffer, core_size);
+                core->Relationship = RelationProcessorCore;
+                core->Processor.Flags = m_threads_per_core > 1 ? 1 : 0;     // LTP_PC_SMT
+                core->Processor.EfficiencyClass = m_efficiency.empty() ? 0 : m_efficiency[core_index % m_efficiency.size()];
+                core->Processor.GroupCount = 1;
+                core->Processor.GroupMask[0].Group = static_cast<WORD>(g);
+                core->Processor.GroupMask[0].Mask = Mask(first, min(m_threads_per_core, m_groups[g] - first));
+            }
+        }
+        return buffer;
+    }
+
+private:
+    static size_t Align(size_t size) { return (size + 7) & ~static_cast<size_t>(7); }
+
+    static KAFFINITY Mask(int first, int count)
+    {
+        KAFFINITY bits = (count >= 64) ? ~static_cast<KAFFINITY>(0) : ((static_cast<KAFFINITY>(1) << count) - 1);
+        return bits << first;
+    }
+
+    // 追加一条清零的记录；返回的指针在下一次追加前有效
+    static SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX* Append(std::vector<BYTE>& buffer, size_t size)
+    {
+        size_t offset = buffer.size();
+        buffer.resize(offset + size, 0);
+        auto info = reinterpret_cast<SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX*>(buffer.data() + offset);
+        info->Size = static_cast<DWORD>(size);
+        return info;
+    }
+
+    std::vector<int> m_groups;
+    int m_threads_per_core = 1;
+    std::vector<BYTE> m_efficiency;
+};
@@ -0,0 +1,263 @@
+﻿// tests/SystemErrorMonitorTest.cpp - 用合成的事件源驱动 CSystemErrorMonitor 的窗口计数、读取节奏和读取器重建
+#include "TestHarness.h"
+#include "SystemErrorMonitor.h"
+#include <memory>
+#include <vector>
+
+namespace
+{
+    const unsigned long long MINUTE = 60ull * 10000000;
+    const unsigned long long HOUR = 60 * MINUTE;
+    const unsigned long long WINDOW = 24 * HOUR;
+    const unsigned long long START = 133000000000000000ull;    // 2022 年前后的 FILETIME
+
+    const int PROVIDER_WHEA = 0;
+    const int PROVIDER_NVLDDMKM = 1;
+    const int PROVIDER_DISK = 2;
+
+    // 合成的事件日志：测试往里写事件，读取器按各自的进度读出
+    struct CFakeLog
+    {
+        std::vector<CLogEvent> events;
+        unsigned long long now = START;
+        bool subscription_failed = false;   // 已有的推送读取器报告错误
+        bool query_failed = false;          // 轮询读取器查询失败
+
+        void Add(int provider, unsigned long long time, unsigned char level = 2, unsigned short event_id = 7)
+        {
+            CLogEvent event = {};
+            event.time = time;
+            event.provider = provider;
+            event.event_id = event_id;
+            event.level = level;
+            event.count = 1;
+            if (provider == PROVIDER_WHEA) {
+                event.has_whea = true;
+                event.whea.time = time;
+                event.whea.event_id = event_id;
+                event.whea.severity = static_cast<unsigned char>(ClassifyWheaEvent(event_id, level));
+            }
+            events.push_back(event);
+        }
+    };
+
+    // 首次读取回溯一个窗口，之后只返回新写入的事件，与书签读取器和订阅读取器的行为相同
+    class CFakeEventLogReader : public IEventLogReader
+    {
+    public:
+        CFakeEventLogReader(const std::shared_ptr<CFakeLog>& log, bool push) : m_log(log), m_push(push) {}
+
+        bool ReadNewEvents(const std::function<void(const CLogEvent&)>& on_event) override
+        {
+            if (!m_push && m_log->query_failed) return false;
+            for (; m_next < m_log->events.size(); ++m_next) {
+                const CLogEvent& event = m_log->events[m_next];
+                if (event.time + WINDOW > m_log->now) on_event(event);
+            }
+            return !(m_push && m_log->subscription_failed);
+        }
+
+        bool IsPushBased() const override { return m_push; }
+
+    private:
+        std::shared_ptr<CFakeLog> m_log;
+        bool m_push;
+        size_t m_next = 0;
+    };
+
+    struct CFixture
+    {
+        std::shared_ptr<CFakeLog> log = std::make_shared<CFakeLog>();
+        std::vector<bool> created;          // 每次创建读取器时的 subscribe 参数
+        std::vector<std::wstring> queried;  // 最近一次创建读取器时的来源列表
+        CSystemErrorMonitor monitor;
+        unsigned long long tick_ms = 1000;
+
+        explicit CFixture(bool subscribe)
+            : monitor([this](const std::vector<std::wstring>& providers, bool push) {
+                  created.push_back(push);
+                  queried = providers;
+                  // 订阅失败后新建的订阅同样失败
+                  return std::unique_ptr<IEventLogReader>(new CFakeEventLogReader(log, push && !log->subscription_failed));
+              })
+        {
+            monitor.Configure({ WHEA_PROVIDER_NAME, L"nvlddmkm", L"disk" }, subscribe);
+        }
+
+        // 推进模拟时钟后更新一次
+        void Update(unsigned long long elapsed_ms)
+        {
+            tick_ms += elapsed_ms;
+            log->now += elapsed_ms * 10000;
+            monitor.Update(tick_ms, log->now);
+        }
+    };
+}
+
+TEST_CASE(CountsEventsPerProviderAndRanksWhea)
+{
+    CFixture fixture(true);
+    fixture.log->Add(PROVIDER_DISK, START - HOUR);
+    fixture.log->Add(PROVIDER_WHEA, START - 2 * HOUR, 3, 19);
+    fixture.log->Add(PROVIDER_WHEA, START - MINUTE, 3, 19);
+    fixture.Update(0);
+    CHECK_EQ(fixture.monitor.GetProviderCount(), 3);
+    CHECK_EQ(fixture.monitor.GetCount(PROVIDER_WHEA), 2u);
+    CHECK_EQ(fixture.monitor.GetCount(PROVIDER_NVLDDMKM), 0u);
+    CHECK_EQ(fixture.monitor.GetCount(PROVIDER_DISK), 1u);
+    CHECK_EQ(fixture.monitor.GetWheaLog().GetCount(WHEA_CORRECTED), 2u);
+    // 其他来源的错误比已纠正的 WHEA 错误更严重
+    CHECK_EQ(static_cast<int>(fixture.monitor.GetLevel()), static_cast<int>(SYSTEM_ERROR_ERROR));
+
+    fixture.log->Add(PROVIDER_WHEA, fixture.log->now, 2, 17);
+    fixture.Update(1000);
+    CHECK_EQ(fixture.monitor.GetWheaLog().GetCount(WHEA_UNCORRECTED), 1u);
+    CHECK_EQ(static_cast<int>(fixture.monitor.GetLevel()), static_cast<int>(SYSTEM_ERROR_UNCORRECTED));
+
+    fixture.log->Add(PROVIDER_WHEA, fixture.log->now, 1, 18);
+    fixture.Update(1000);
+    CHECK_EQ(static_cast<int>(fixture.monitor.GetLevel()), static_cast<int>(SYSTEM_ERROR_FATAL));
+    CHECK_EQ(fixture.monitor.GetWheaLog().GetRecord(0).event_id, 18);
+}
+
+TEST_CASE(EventsOlderThanTheWindowAreIgnoredAndExpire)
+{
+    CFixture fixture(true);
+    fixture.log->Add(PROVIDER_DISK, START - WINDOW - HOUR);     // 已经在窗口之外
+    fixture.log->Add(PROVIDER_DISK, START - 23 * HOUR);
+    fixture.log->Add(PROVIDER_WHEA, START - 22 * HOUR, 3, 19);
+    fixture.Update(0);
+    CHECK_EQ(fixture.monitor.GetCount(PROVIDER_DISK), 1u);
+    CHECK_EQ(fixture.monitor.GetCount(PROVIDER_WHEA), 1u);
+
+    // 1 小时 15 分钟后磁盘错误所在的桶过期，WHEA 错误仍在窗口内
+    fixture.Update(75 * 60 * 1000);
+    CHECK_EQ(fixture.monitor.GetCount(PROVIDER_DISK), 0u);
+    CHECK_EQ(fixture.monitor.GetCount(PROVIDER_WHEA), 1u);
+    CHECK_EQ(static_cast<int>(fixture.monitor.GetLevel()), static_cast<int>(SYSTEM_ERROR_CORRECTED));
+
+    fixture.Update(HOUR / 10000);
+    CHECK_EQ(fixture.monitor.GetWheaLog().GetCount(WHEA_CORRECTED), 0u);
+    CHECK_EQ(static_cast<int>(fixture.monitor.GetLevel()), static_cast<int>(SYSTEM_ERROR_NONE));
+}
+
+TEST_CASE(PollingReaderIsReadOncePerInterval)
+{
+    CFixture fixture(false);
+    fixture.Update(0);
+    fixture.log->Add(PROVIDER_DISK, fixture.log->now);
+    fixture.Update(30000);
+    CHECK_EQ(fixture.monitor.GetCount(PROVIDER_DISK), 0u);
+    fixture.Update(CSystemErrorMonitor::POLL_INTERVAL_MS - 30000);
+    CHECK_EQ(fixture.monitor.GetCount(PROVIDER_DISK), 1u);
+    CHECK(!fixture.monitor.IsSubscribed());
+}
+
+TEST_CASE(PushReaderIsDrainedOnEveryUpdate)
+{
+    CFixture fixture(true);
+    fixture.Update(0);
+    fixture.log->Add(PROVIDER_NVLDDMKM, fixture.log->now);
+    fixture.Update(1000);
+    CHECK_EQ(fixture.monitor.GetCount(PROVIDER_NVLDDMKM), 1u);
+    CHECK(fixture.monitor.IsSubscribed());
+    CHECK_EQ(fixture.created.size(), static_cast<size_t>(1));
+}
+
+TEST_CASE(FailedSubscriptionFallsBackToPollingWithoutDoubleCounting)
+{
+    CFixture fixture(true);
+    fixture.log->Add(PROVIDER_DISK, START - HOUR);
+    fixture.Update(0);
+    CHECK_EQ(fixture.monitor.GetCount(PROVIDER_DISK), 1u);
+
+    // 订阅出错：出错前到达的事件照常计入，随后立即改用轮询并从窗口起点重读
+    fixture.log->Add(PROVIDER_DISK, fixture.log->now);
+    fixture.log->subscription_failed = true;
+    fixture.Update(1000);
+    REQUIRE(fixture.created.size() == 2);
+    CHECK(fixture.created[0]);
+    CHECK(!fixture.created[1]);
+    CHECK(!fixture.monitor.IsSubscribed());
+    CHECK_EQ(fixture.monitor.GetCount(PROVIDER_DISK), 2u);
+
+    // 之后按轮询节奏读取
+    fixture.log->Add(PROVIDER_DISK, fixture.log->now);
+    fixture.Update(1000);
+    CHECK_EQ(fixture.monitor.GetCount(PROVIDER_DISK), 2u);
+    fixture.Update(CSystemErrorMonitor::POLL_INTERVAL_MS);
+    CHECK_EQ(fixture.monitor.GetCount(PROVIDER_DISK), 3u);
+    CHECK_EQ(fixture.created.size(), static_cast<size_t>(2));
+}
+
+TEST_CASE(FailedQueryKeepsCountsUntilTheRebuiltReaderReads)
+{
+    CFixture fixture(false);
+    fixture.log->Add(PROVIDER_WHEA, START - HOUR, 3, 19);
+    fixture.Update(0);
+    CHECK_EQ(fixture.monitor.GetCount(PROVIDER_WHEA), 1u);
+
+    fixture.log->query_failed = true;
+    fixture.Update(CSystemErrorMonitor::POLL_INTERVAL_MS);
+    CHECK_EQ(fixture.monitor.GetCount(PROVIDER_WHEA), 1u);
+
+    fixture.log->query_failed = false;
+    fixture.log->Add(PROVIDER_WHEA, fixture.log->now, 3, 19);
+    fixture.Update(CSystemErrorMonitor::POLL_INTERVAL_MS);
+    CHECK_EQ(fixture.created.size(), static_cast<size_t>(2));
+    CHECK_EQ(fixture.monitor.GetCount(PROVIDER_WHEA), 2u);
+    CHECK_EQ(fixture.monitor.GetWheaLog().GetRecordCount(), 2);
+}
+
+TEST_CASE(ConfigureStartsOverWithTheNewProviders)
+{
+    CFixture fixture(true);
+    fixture.log->Add(PROVIDER_DISK, START - HOUR);
+    fixture.Update(0);
+    CHECK_EQ(fixture.monitor.GetCount(PROVIDER_DISK), 1u);
+
+    fixture.monitor.Configure({ WHEA_PROVIDER_NAME }, true);
+    CHECK_EQ(fixture.monitor.GetProviderCount(), 1);
+    CHECK_EQ(static_cast<int>(fixture.monitor.GetLevel()), static_cast<int>(SYSTEM_ERROR_NONE));
+    fixture.Update(1000);
+    CHECK_EQ(fixture.created.size(), static_cast<size_t>(2));
+}
+
+TEST_CASE(SuppressedProviderIsLeftOutOfTheQuery)
+{
+    // 合成日志按完整来源列表编号，这里只放 WHEA 事件，它在两种查询中的下标都是 0
+    CFixture fixture(true);
+    fixture.log->Add(PROVIDER_WHEA, START - HOUR, 3, 19);
+    fixture.Update(0);
+    CHECK_EQ(fixture.queried.size(), static_cast<size_t>(3));
+
+    fixture.monitor.SetSuppressed(L"NVLDDMKM", true);
+    fixture.Update(1000);
+    REQUIRE(fixture.queried.size() == 2);
+    CHECK(fixture.queried[0] == WHEA_PROVIDER_NAME);
+    CHECK(fixture.queried[1] == L"disk");
+    CHECK_EQ(fixture.created.size(), static_cast<size_t>(2));
+    CHECK_EQ(fixture.monitor.GetCount(PROVIDER_WHEA), 1u);
+    CHECK_EQ(fixture.monitor.GetProviderCount(), 3);
+
+    // 重复设置不重建读取器
+    fixture.monitor.SetSuppressed(L"nvlddmkm", true);
+    fixture.Update(1000);
+    CHECK_EQ(fixture.created.size(), static_cast<size_t>(2));
+
+    fixture.monitor.SetSuppressed(L"nvlddmkm", false);
+    fixture.Update(1000);
+    CHECK_EQ(fixture.queried.size(), static_cast<size_t>(3));
+    CHECK_EQ(fixture.monitor.GetCount(PROVIDER_WHEA), 1u);
+}
+
+TEST_CASE(SuppressedEventsLandInTheRightWindow)
+{
+    CFixture fixture(false);
+    fixture.monitor.SetSuppressed(L"nvlddmkm", true);
+    // 读取器只查询 WHEA 和 disk，disk 事件在查询中的下标是 1
+    fixture.log->Add(1, START - HOUR);
+    fixture.Update(0);
+    CHECK_EQ(fixture.monitor.GetCount(PROVIDER_NVLDDMKM), 0u);
+    CHECK_EQ(fixture.monitor.GetCount(PROVIDER_DISK), 1u);
+}
@@ -0,0 +1,52 @@
+// tests/TempDir.h - 测试用的临时目录，析构时递归删除
+#pragma once
+#include <string>
+#include <cstdio>
+#include <cstdlib>
+#include <ftw.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+class CTempDir
+{
+public:
+    CTempDir()
+    {
+        const char* base = std::getenv("TMPDIR");
+        std::string pattern = std::string(base && *base ? base : "/tmp") + "/cpucorebars.XXXXXX";
+        if (mkdtemp(&pattern[0])) m_path = pattern;
+    }
+
+    ~CTempDir()
+    {
+        if (!m_path.empty()) nftw(m_path.c_str(), RemoveEntry, 16, FTW_DEPTH | FTW_PHYS);
+    }
+
+    CTempDir(const CTempDir&) = delete;
+    CTempDir& operator=(const CTempDir&) = delete;
+
+    bool IsValid() const { return !m_path.empty(); }
+    const std::string& GetPath() const { return m_path; }
+
+    // 相对路径中的目录按需创建
+    std::string WriteFile(const std::string& relative, const std::string& content) const
+    {
+        std::string path = m_path + "/" + relative;
+        for (size_t pos = m_path.size() + 1; (pos = path.find('/', pos)) != std::string::npos; ++pos) {
+            mkdir(path.substr(0, pos).c_str(), 0755);
+        }
+        FILE* file = std::fopen(path.c_str(), "wb");
+        if (!file) return std::string();
+        std::fwrite(content.data(), 1, content.size(), file);
+        std::fclose(file);
+        return path;
+    }
+
+private:
+    static int RemoveEntry(const char* path, const struct stat*, int, struct FTW*)
+    {
+        return std::remove(path);
+    }
+
+    std::string m_path;
+};
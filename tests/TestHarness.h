@@ -0,0 +1,59 @@
+// tests/TestHarness.h - 最小的测试框架：注册用例、断言、统一的 main
+#pragma once
+#include <cstdio>
+#include <string>
+#include <vector>
+
+struct CTestCase
+{
+    const char* name;
+    void (*func)();
+};
+
+std::vector<CTestCase>& GetTestCases();
+void ReportFailure(const char* file, int line, const std::string& message);
+
+struct CTestRegistrar
+{
+    CTestRegistrar(const char* name, void (*func)()) { GetTestCases().push_back({ name, func }); }
+};
+
+// 用例函数体内可以直接 return 结束当前用例
+#define TEST_CASE(name) \
+    static void name(); \
+    static CTestRegistrar name##_registrar(#name, name); \
+    static void name()
+
+#define CHECK(cond) \
+    do { \
+        if (!(cond)) ReportFailure(__FILE__, __LINE__, #cond); \
+    } while (0)
+
+#define CHECK_EQ(actual, expected) \
+    do { \
+        auto check_actual_ = (actual); \
+        auto check_expected_ = (expected); \
+        if (!(check_actual_ == check_expected_)) { \
+            ReportFailure(__FILE__, __LINE__, std::string(#actual " == " #expected " (actual ") \
+                + std::to_string(check_actual_) + ", expected " + std::to_string(check_expected_) + ")"); \
+        } \
+    } while (0)
+
+#define CHECK_NEAR(actual, expected, tolerance) \
+    do { \
+        double check_actual_ = (actual); \
+        double check_expected_ = (expected); \
+        if (check_actual_ < check_expected_ - (tolerance) || check_actual_ > check_expected_ + (tolerance)) { \
+            ReportFailure(__FILE__, __LINE__, std::string(#actual " ~= " #expected " (actual ") \
+                + std::to_string(check_actual_) + ", expected " + std::to_string(check_expected_) + ")"); \
+        } \
+    } while (0)
+
+// 失败后继续执行会越界或崩溃时使用
+#define REQUIRE(cond) \
+    do { \
+        if (!(cond)) { \
+            ReportFailure(__FILE__, __LINE__, #cond); \
+            return; \
+        } \
+    } while (0)
@@ -0,0 +1,37 @@
+﻿// tests/TestMain.cpp - 运行所有注册的用例；可用参数只运行名称包含该子串的用例
+#include "TestHarness.h"
+#include <cstring>
+
+namespace
+{
+    int s_failures = 0;
+}
+
+std::vector<CTestCase>& GetTestCases()
+{
+    static std::vector<CTestCase> cases;
+    return cases;
+}
+
+void ReportFailure(const char* file, int line, const std::string& message)
+{
+    std::fprintf(stderr, "%s:%d: 检查失败: %s\n", file, line, message.c_str());
+    ++s_failures;
+}
+
+int main(int argc, char** argv)
+{
+    const char* filter = argc > 1 ? argv[1] : nullptr;
+    int run = 0, failed = 0;
+    for (const CTestCase& test : GetTestCases()) {
+        if (filter && !std::strstr(test.name, filter)) continue;
+        int before = s_failures;
+        test.func();
+        ++run;
+        bool ok = (s_failures == before);
+        if (!ok) ++failed;
+        std::printf("[%s] %s\n", ok ? " OK " : "FAIL", test.name);
+    }
+    std::printf("%d 个用例，%d 个失败\n", run, failed);
+    return failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,571 @@
+﻿// tests/nvml_standin/NvmlStandin.cpp - 按脚本返回数据的 NVML 替身库（libnvidia-ml.so / nvml.dll）
+#include "nvml.h"
+#include "NvmlStandin.h"
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// 句柄类型在 nvml.h 中只有前置声明，替身库自己定义
+struct nvmlDevice_st
+{
+    char bus_id[NVML_DEVICE_PCI_BUS_ID_BUFFER_SIZE];
+    char uuid[NVML_DEVICE_UUID_V2_BUFFER_SIZE];
+    unsigned int temperature;
+    unsigned long long reasons;
+    std::map<unsigned int, unsigned long long> fields;
+    nvmlViolationTime_t violations[NVML_PERF_POLICY_COUNT];
+    bool violation_valid[NVML_PERF_POLICY_COUNT];
+    bool policy_fields;                     // 是否通过 NVML_FI_DEV_PERF_POLICY_* 字段提供违规计数器
+    unsigned long long memory_total, memory_used, memory_reserved;
+    unsigned long long bar1_total, bar1_used;
+    std::vector<unsigned int> utilization;  // 第 i 个采样的时间戳为 i + 1
+    std::vector<nvmlProcessInfo_t> processes;
+    std::vector<nvmlProcessInfo_t> graphics_processes;
+    bool lost;
+};
+
+struct nvmlEventSet_st
+{
+    unsigned int device_mask;
+};
+
+namespace
+{
+    const unsigned int MAX_DEVICES = 16;
+    const unsigned int SAMPLE_BUFFER = 120;
+
+    // 按调用次数生效的故障：remaining 为 0 表示一直生效
+    struct CFault
+    {
+        unsigned int value;
+        unsigned int remaining;
+    };
+
+    typedef std::vector<std::string> CDirective;
+
+    std::mutex s_mutex;
+    std::condition_variable s_event_cv;
+    bool s_loaded = false;
+    bool s_initialized = false;
+    std::vector<std::vector<CDirective>> s_frames;
+    size_t s_next_frame = 0;
+    unsigned int s_device_count = 0;
+    nvmlDevice_st s_devices[MAX_DEVICES];
+    unsigned int s_latency_us = 0;
+    std::map<std::string, CFault> s_failures;
+    std::map<std::string, CFault> s_hangs;
+    std::map<std::string, unsigned int> s_call_counts;
+    std::deque<nvmlEventData_t> s_pending_events;
+
+    void ResetDevice(unsigned int index)
+    {
+        nvmlDevice_st& device = s_devices[index];
+        device = nvmlDevice_st();
+        snprintf(device.bus_id, sizeof(device.bus_id), "00000000:%02X:00.0", index + 1);
+        snprintf(device.uuid, sizeof(device.uuid), "GPU-standin-%04u", index);
+        device.temperature = 40;
+        device.policy_fields = true;
+    }
+
+    void ResetState()
+    {
+        s_frames.clear();
+        s_next_frame = 0;
+        s_device_count = 0;
+        for (unsigned int i = 0; i < MAX_DEVICES; ++i) ResetDevice(i);
+        s_latency_us = 0;
+        s_failures.clear();
+        s_hangs.clear();
+        s_call_counts.clear();
+        s_pending_events.clear();
+    }
+
+    unsigned long long ParseValue(const std::string& text)
+    {
+        return strtoull(text.c_str(), nullptr, 0);
+    }
+
+    // 取第 arg 个参数作为设备下标
+    nvmlDevice_st* DeviceArg(const CDirective& directive, size_t arg)
+    {
+        if (directive.size() <= arg) return nullptr;
+        unsigned long long index = ParseValue(directive[arg]);
+        return index < MAX_DEVICES ? &s_devices[index] : nullptr;
+    }
+
+    void SetFault(std::map<std::string, CFault>& faults, const CDirective& directive)
+    {
+        unsigned int value = static_cast<unsigned int>(ParseValue(directive[2]));
+        unsigned int count = directive.size() > 3 ? static_cast<unsigned int>(ParseValue(directive[3])) : 0;
+        if (value == 0) faults.erase(directive[1]);
+        else faults[directive[1]] = CFault{ value, count };
+    }
+
+    // 持有 s_mutex 时调用；无法识别的指令返回 false
+    bool Apply(const CDirective& directive)
+    {
+        const std::string& name = directive[0];
+        size_t argc = directive.size() - 1;
+        nvmlDevice_st* device = DeviceArg(directive, 1);
+        if (name == "devices" && argc == 1) {
+            s_device_count = static_cast<unsigned int>(std::min(ParseValue(directive[1]), static_cast<unsigned long long>(MAX_DEVICES)));
+        } else if (name == "latency_us" && argc == 1) {
+            s_latency_us = static_cast<unsigned int>(ParseValue(directive[1]));
+        } else if ((name == "fail" || name == "hang") && (argc == 2 || argc == 3)) {
+            SetFault(name == "fail" ? s_failures : s_hangs, directive);
+        } else if (!device) {
+            return false;
+        } else if (name == "busid" && argc == 2) {
+            snprintf(device->bus_id, sizeof(device->bus_id), "%s", directive[2].c_str());
+        } else if (name == "uuid" && argc == 2) {
+            snprintf(device->uuid, sizeof(device->uuid), "%s", directive[2].c_str());
+        } else if (name == "temp" && argc == 2) {
+            device->temperature = static_cast<unsigned int>(ParseValue(directive[2]));
+        } else if (name == "reasons" && argc == 2) {
+            device->reasons = ParseValue(directive[2]);
+        } else if (name == "field" && argc == 3) {
+            unsigned int id = static_cast<unsigned int>(ParseValue(directive[2]));
+            if (directive[3] == "-") device->fields.erase(id);
+            else device->fields[id] = ParseValue(directive[3]);
+        } else if (name == "violation" && argc == 4) {
+            unsigned long long policy = ParseValue(directive[2]);
+            if (policy >= NVML_PERF_POLICY_COUNT) return false;
+            device->violations[policy].referenceTime = ParseValue(directive[3]);
+            device->violations[policy].violationTime = ParseValue(directive[4]);
+            device->violation_valid[policy] = true;
+        } else if (name == "policy_fields" && argc == 2) {
+            device->policy_fields = ParseValue(directive[2]) != 0;
+        } else if (name == "memory" && argc == 4) {
+            device->memory_total = ParseValue(directive[2]);
+            device->memory_used = ParseValue(directive[3]);
+            device->memory_reserved = ParseValue(directive[4]);
+        } else if (name == "bar1" && argc == 3) {
+            device->bar1_total = ParseValue(directive[2]);
+            device->bar1_used = ParseValue(directive[3]);
+        } else if (name == "util" && argc == 2) {
+            device->utilization.push_back(static_cast<unsigned int>(ParseValue(directive[2])));
+        } else if ((name == "process" || name == "graphics_process") && argc == 3) {
+            nvmlProcessInfo_t info = {};
+            info.pid = static_cast<unsigned int>(ParseValue(directive[2]));
+            info.usedGpuMemory = ParseValue(directive[3]);
+            (name == "process" ? device->processes : device->graphics_processes).push_back(info);
+        } else if (name == "clear_processes" && argc == 1) {
+            device->processes.clear();
+            device->graphics_processes.clear();
+        } else if (name == "lost" && argc == 1) {
+            device->lost = true;
+        } else if (name == "restore" && argc == 1) {
+            device->lost = false;
+        } else if (name == "xid" && argc == 2) {
+            nvmlEventData_t data = {};
+            data.device = device;
+            data.eventType = nvmlEventTypeXidCriticalError;
+            data.eventData = ParseValue(directive[2]);
+            s_pending_events.push_back(data);
+            s_event_cv.notify_all();
+        } else {
+            return false;
+        }
+        return true;
+    }
+
+    bool ApplyNextFrame()
+    {
+        if (s_next_frame >= s_frames.size()) return false;
+        for (const CDirective& directive : s_frames[s_next_frame]) Apply(directive);
+        ++s_next_frame;
+        return true;
+    }
+
+    bool LoadScript(const char* path)
+    {
+        std::ifstream file(path);
+        if (!file) {
+            fprintf(stderr, "nvml_standin: cannot open %s\n", path);
+            return false;
+        }
+        std::vector<std::vector<CDirective>> frames(1);
+        std::string line;
+        while (std::getline(file, line)) {
+            std::istringstream tokens(line.substr(0, line.find('#')));
+            CDirective directive;
+            std::string token;
+            while (tokens >> token) directive.push_back(token);
+            if (directive.empty()) continue;
+            if (directive[0] == "frame" && directive.size() == 1) frames.emplace_back();
+            else frames.back().push_back(directive);
+        }
+
+        // 先把所有帧试执行一遍，写错的脚本整体拒绝，不会只生效一半
+        ResetState();
+        for (const std::vector<CDirective>& frame : frames) {
+            for (const CDirective& directive : frame) {
+                if (Apply(directive)) continue;
+                fprintf(stderr, "nvml_standin: %s: invalid directive '%s'\n", path, directive[0].c_str());
+                ResetState();
+                return false;
+            }
+        }
+        ResetState();
+        s_frames.swap(frames);
+        s_loaded = true;
+        ApplyNextFrame();
+        return true;
+    }
+
+    // 每个导出函数的入口：计数、注入延迟和阻塞、返回脚本指定的错误码
+    nvmlReturn_t Enter(const char* function)
+    {
+        unsigned long long delay_us = 0;
+        nvmlReturn_t result = NVML_SUCCESS;
+        {
+            std::lock_guard<std::mutex> lock(s_mutex);
+            ++s_call_counts[function];
+            delay_us = s_latency_us;
+            auto hang = s_hangs.find(function);
+            if (hang != s_hangs.end()) {
+                delay_us += hang->second.value * 1000ull;
+                if (hang->second.remaining > 0 && --hang->second.remaining == 0) s_hangs.erase(hang);
+            }
+            auto failure = s_failures.find(function);
+            if (failure != s_failures.end()) {
+                result = static_cast<nvmlReturn_t>(failure->second.value);
+                if (failure->second.remaining > 0 && --failure->second.remaining == 0) s_failures.erase(failure);
+            } else if (!s_initialized && strcmp(function, "nvmlInit_v2") != 0) {
+                result = NVML_ERROR_UNINITIALIZED;
+            }
+        }
+        if (delay_us > 0) std::this_thread::sleep_for(std::chrono::microseconds(delay_us));
+        return result;
+    }
+
+    // 持有 s_mutex 时调用
+    nvmlReturn_t CheckDevice(nvmlDevice_t device)
+    {
+        if (device < s_devices || device >= s_devices + s_device_count) return NVML_ERROR_INVALID_ARGUMENT;
+        return device->lost ? NVML_ERROR_GPU_IS_LOST : NVML_SUCCESS;
+    }
+
+    nvmlReturn_t QueryProcesses(nvmlDevice_t device, unsigned int* count, nvmlProcessInfo_t* infos, bool graphics)
+    {
+        std::lock_guard<std::mutex> lock(s_mutex);
+        nvmlReturn_t result = CheckDevice(device);
+        if (result != NVML_SUCCESS) return result;
+        const std::vector<nvmlProcessInfo_t>& processes = graphics ? device->graphics_processes : device->processes;
+        unsigned int available = static_cast<unsigned int>(processes.size());
+        if (*count < available) {
+            *count = available;
+            return NVML_ERROR_INSUFFICIENT_SIZE;
+        }
+        for (unsigned int i = 0; i < available; ++i) infos[i] = processes[i];
+        *count = available;
+        return NVML_SUCCESS;
+    }
+}
+
+// =================================================================
+// 控制接口
+// =================================================================
+int nvmlStandinLoad(const char* path)
+{
+    std::lock_guard<std::mutex> lock(s_mutex);
+    return LoadScript(path) ? 1 : 0;
+}
+
+int nvmlStandinAdvance()
+{
+    std::lock_guard<std::mutex> lock(s_mutex);
+    return ApplyNextFrame() ? 1 : 0;
+}
+
+unsigned int nvmlStandinGetCallCount(const char* function)
+{
+    std::lock_guard<std::mutex> lock(s_mutex);
+    auto it = s_call_counts.find(function);
+    return it != s_call_counts.end() ? it->second : 0;
+}
+
+void nvmlStandinResetCallCounts()
+{
+    std::lock_guard<std::mutex> lock(s_mutex);
+    s_call_counts.clear();
+}
+
+// =================================================================
+// NVML 接口：只实现 CGpuMonitor 用到的函数
+// =================================================================
+nvmlReturn_t nvmlInit_v2(void)
+{
+    {
+        std::lock_guard<std::mutex> lock(s_mutex);
+        const char* script = getenv("NVML_STANDIN_SCRIPT");
+        if (!s_loaded && script && *script) LoadScript(script);
+    }
+    nvmlReturn_t result = Enter(__func__);
+    if (result != NVML_SUCCESS) return result;
+    std::lock_guard<std::mutex> lock(s_mutex);
+    s_initialized = true;
+    return NVML_SUCCESS;
+}
+
+nvmlReturn_t nvmlShutdown(void)
+{
+    nvmlReturn_t result = Enter(__func__);
+    if (result != NVML_SUCCESS) return result;
+    std::lock_guard<std::mutex> lock(s_mutex);
+    s_initialized = false;
+    return NVML_SUCCESS;
+}
+
+nvmlReturn_t nvmlDeviceGetCount_v2(unsigned int* device_count)
+{
+    nvmlReturn_t result = Enter(__func__);
+    if (result != NVML_SUCCESS) return result;
+    std::lock_guard<std::mutex> lock(s_mutex);
+    *device_count = s_device_count;
+    return NVML_SUCCESS;
+}
+
+nvmlReturn_t nvmlDeviceGetHandleByIndex_v2(unsigned int index, nvmlDevice_t* device)
+{
+    nvmlReturn_t result = Enter(__func__);
+    if (result != NVML_SUCCESS) return result;
+    std::lock_guard<std::mutex> lock(s_mutex);
+    if (index >= s_device_count) return NVML_ERROR_INVALID_ARGUMENT;
+    *device = &s_devices[index];
+    return NVML_SUCCESS;
+}
+
+nvmlReturn_t nvmlDeviceGetUUID(nvmlDevice_t device, char* uuid, unsigned int length)
+{
+    nvmlReturn_t result = Enter(__func__);
+    if (result != NVML_SUCCESS) return result;
+    std::lock_guard<std::mutex> lock(s_mutex);
+    result = CheckDevice(device);
+    if (result != NVML_SUCCESS) return result;
+    if (strlen(device->uuid) >= length) return NVML_ERROR_INSUFFICIENT_SIZE;
+    strcpy(uuid, device->uuid);
+    return NVML_SUCCESS;
+}
+
+nvmlReturn_t nvmlDeviceGetPciInfo_v3(nvmlDevice_t device, nvmlPciInfo_t* pci)
+{
+    nvmlReturn_t result = Enter(__func__);
+    if (result != NVML_SUCCESS) return result;
+    std::lock_guard<std::mutex> lock(s_mutex);
+    result = CheckDevice(device);
+    if (result != NVML_SUCCESS) return result;
+    *pci = nvmlPciInfo_t();
+    snprintf(pci->busId, sizeof(pci->busId), "%s", device->bus_id);
+    snprintf(pci->busIdLegacy, sizeof(pci->busIdLegacy), "%.*s", static_cast<int>(sizeof(pci->busIdLegacy) - 1), device->bus_id);
+    return NVML_SUCCESS;
+}
+
+nvmlReturn_t nvmlDeviceGetCurrentClocksEventReasons(nvmlDevice_t device, unsigned long long* reasons)
+{
+    nvmlReturn_t result = Enter(__func__);
+    if (result != NVML_SUCCESS) return result;
+    std::lock_guard<std::mutex> lock(s_mutex);
+    result = CheckDevice(device);
+    if (result == NVML_SUCCESS) *reasons = device->reasons;
+    return result;
+}
+
+nvmlReturn_t nvmlDeviceGetTemperature(nvmlDevice_t device, nvmlTemperatureSensors_t sensor, unsigned int* temp)
+{
+    nvmlReturn_t result = Enter(__func__);
+    if (result != NVML_SUCCESS) return result;
+    std::lock_guard<std::mutex> lock(s_mutex);
+    result = CheckDevice(device);
+    if (result != NVML_SUCCESS) return result;
+    if (sensor != NVML_TEMPERATURE_GPU) return NVML_ERROR_INVALID_ARGUMENT;
+    *temp = device->temperature;
+    return NVML_SUCCESS;
+}
+
+nvmlReturn_t nvmlDeviceGetFieldValues(nvmlDevice_t device, int values_count, nvmlFieldValue_t* values)
+{
+    nvmlReturn_t result = Enter(__func__);
+    if (result != NVML_SUCCESS) return result;
+    std::lock_guard<std::mutex> lock(s_mutex);
+    result = CheckDevice(device);
+    if (result != NVML_SUCCESS) return result;
+    long long now_us = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    for (int i = 0; i < values_count; ++i) {
+        nvmlFieldValue_t& field = values[i];
+        field.timestamp = now_us;
+        // 违规策略字段与 nvmlDeviceGetViolationStatus 读同一组计数器，时间戳为计数器的参考时间
+        unsigned int policy = field.fieldId - NVML_FI_DEV_PERF_POLICY_POWER;
+        if (field.fieldId >= NVML_FI_DEV_PERF_POLICY_POWER && policy <= NVML_PERF_POLICY_RELIABILITY) {
+            if (!device->policy_fields || !device->violation_valid[policy]) {
+                field.nvmlReturn = NVML_ERROR_NOT_SUPPORTED;
+                continue;
+            }
+            field.nvmlReturn = NVML_SUCCESS;
+            field.timestamp = static_cast<long long>(device->violations[policy].referenceTime);
+            field.valueType = NVML_VALUE_TYPE_UNSIGNED_LONG_LONG;
+            field.value.ullVal = device->violations[policy].violationTime;
+            continue;
+        }
+        auto it = device->fields.find(field.fieldId);
+        if (it == device->fields.end()) {
+            field.nvmlReturn = NVML_ERROR_NOT_SUPPORTED;
+            continue;
+        }
+        field.nvmlReturn = NVML_SUCCESS;
+        field.valueType = NVML_VALUE_TYPE_UNSIGNED_LONG_LONG;
+        field.value.ullVal = it->second;
+    }
+    return NVML_SUCCESS;
+}
+
+nvmlReturn_t nvmlDeviceGetViolationStatus(nvmlDevice_t device, nvmlPerfPolicyType_t policy, nvmlViolationTime_t* time)
+{
+    nvmlReturn_t result = Enter(__func__);
+    if (result != NVML_SUCCESS) return result;
+    std::lock_guard<std::mutex> lock(s_mutex);
+    result = CheckDevice(device);
+    if (result != NVML_SUCCESS) return result;
+    if (policy >= NVML_PERF_POLICY_COUNT || !device->violation_valid[policy]) return NVML_ERROR_NOT_SUPPORTED;
+    *time = device->violations[policy];
+    return NVML_SUCCESS;
+}
+
+nvmlReturn_t nvmlDeviceGetSamples(nvmlDevice_t device, nvmlSamplingType_t, unsigned long long last_seen,
+    nvmlValueType_t* value_type, unsigned int* count, nvmlSample_t* samples)
+{
+    nvmlReturn_t result = Enter(__func__);
+    if (result != NVML_SUCCESS) return result;
+    std::lock_guard<std::mutex> lock(s_mutex);
+    result = CheckDevice(device);
+    if (result != NVML_SUCCESS) return result;
+    *value_type = NVML_VALUE_TYPE_UNSIGNED_INT;
+    if (!samples) {
+        *count = SAMPLE_BUFFER;
+        return NVML_SUCCESS;
+    }
+    // 每条 util 指令产生一个采样，时间戳就是它的序号；返回 last_seen 之后的全部采样
+    size_t first = static_cast<size_t>(std::min<unsigned long long>(last_seen, device->utilization.size()));
+    size_t available = device->utilization.size() - first;
+    if (available == 0) return NVML_ERROR_NOT_FOUND;
+    if (*count < 1) return NVML_ERROR_INSUFFICIENT_SIZE;
+    unsigned int returned = static_cast<unsigned int>(std::min<size_t>(available, *count));
+    for (unsigned int i = 0; i < returned; ++i) {
+        samples[i].timeStamp = first + i + 1;
+        samples[i].sampleValue.uiVal = device->utilization[first + i];
+    }
+    *count = returned;
+    return NVML_SUCCESS;
+}
+
+nvmlReturn_t nvmlDeviceGetMemoryInfo_v2(nvmlDevice_t device, nvmlMemory_v2_t* memory)
+{
+    nvmlReturn_t result = Enter(__func__);
+    if (result != NVML_SUCCESS) return result;
+    std::lock_guard<std::mutex> lock(s_mutex);
+    result = CheckDevice(device);
+    if (result != NVML_SUCCESS) return result;
+    if (memory->version != nvmlMemory_v2) return NVML_ERROR_ARGUMENT_VERSION_MISMATCH;
+    if (device->memory_total == 0) return NVML_ERROR_NOT_SUPPORTED;
+    memory->total = device->memory_total;
+    memory->used = device->memory_used;
+    memory->reserved = device->memory_reserved;
+    memory->free = device->memory_total - std::min(device->memory_total, device->memory_used + device->memory_reserved);
+    return NVML_SUCCESS;
+}
+
+nvmlReturn_t nvmlDeviceGetBAR1MemoryInfo(nvmlDevice_t device, nvmlBAR1Memory_t* bar1)
+{
+    nvmlReturn_t result = Enter(__func__);
+    if (result != NVML_SUCCESS) return result;
+    std::lock_guard<std::mutex> lock(s_mutex);
+    result = CheckDevice(device);
+    if (result != NVML_SUCCESS) return result;
+    if (device->bar1_total == 0) return NVML_ERROR_NOT_SUPPORTED;
+    bar1->bar1Total = device->bar1_total;
+    bar1->bar1Used = device->bar1_used;
+    bar1->bar1Free = device->bar1_total - std::min(device->bar1_total, device->bar1_used);
+    return NVML_SUCCESS;
+}
+
+nvmlReturn_t nvmlDeviceGetComputeRunningProcesses_v3(nvmlDevice_t device, unsigned int* count, nvmlProcessInfo_t* infos)
+{
+    nvmlReturn_t result = Enter(__func__);
+    return result != NVML_SUCCESS ? result : QueryProcesses(device, count, infos, false);
+}
+
+nvmlReturn_t nvmlDeviceGetGraphicsRunningProcesses_v3(nvmlDevice_t device, unsigned int* count, nvmlProcessInfo_t* infos)
+{
+    nvmlReturn_t result = Enter(__func__);
+    return result != NVML_SUCCESS ? result : QueryProcesses(device, count, infos, true);
+}
+
+nvmlReturn_t nvmlDeviceGetSupportedEventTypes(nvmlDevice_t device, unsigned long long* event_types)
+{
+    nvmlReturn_t result = Enter(__func__);
+    if (result != NVML_SUCCESS) return result;
+    std::lock_guard<std::mutex> lock(s_mutex);
+    result = CheckDevice(device);
+    if (result == NVML_SUCCESS) *event_types = nvmlEventTypeXidCriticalError;
+    return result;
+}
+
+nvmlReturn_t nvmlEventSetCreate(nvmlEventSet_t* set)
+{
+    nvmlReturn_t result = Enter(__func__);
+    if (result != NVML_SUCCESS) return result;
+    *set = new nvmlEventSet_st{ 0 };
+    return NVML_SUCCESS;
+}
+
+nvmlReturn_t nvmlDeviceRegisterEvents(nvmlDevice_t device, unsigned long long event_types, nvmlEventSet_t set)
+{
+    nvmlReturn_t result = Enter(__func__);
+    if (result != NVML_SUCCESS) return result;
+    std::lock_guard<std::mutex> lock(s_mutex);
+    result = CheckDevice(device);
+    if (result != NVML_SUCCESS) return result;
+    if (event_types & ~static_cast<unsigned long long>(nvmlEventTypeXidCriticalError)) return NVML_ERROR_NOT_SUPPORTED;
+    set->device_mask |= 1u << (device - s_devices);
+    return NVML_SUCCESS;
+}
+
+nvmlReturn_t nvmlEventSetWait_v2(nvmlEventSet_t set, nvmlEventData_t* data, unsigned int timeout_ms)
+{
+    nvmlReturn_t result = Enter(__func__);
+    if (result != NVML_SUCCESS) return result;
+    std::unique_lock<std::mutex> lock(s_mutex);
+    // 未注册设备的事件直接丢弃，与驱动的行为一致
+    auto ready = [&]() {
+        while (!s_pending_events.empty()) {
+            unsigned int index = static_cast<unsigned int>(s_pending_events.front().device - s_devices);
+            if (set->device_mask & (1u << index)) return true;
+            s_pending_events.pop_front();
+        }
+        return false;
+    };
+    if (!s_event_cv.wait_for(lock, std::chrono::milliseconds(timeout_ms), ready)) return NVML_ERROR_TIMEOUT;
+    *data = s_pending_events.front();
+    s_pending_events.pop_front();
+    return NVML_SUCCESS;
+}
+
+nvmlReturn_t nvmlEventSetFree(nvmlEventSet_t set)
+{
+    nvmlReturn_t result = Enter(__func__);
+    if (result != NVML_SUCCESS) return result;
+    delete set;
+    return NVML_SUCCESS;
+}
@@ -0,0 +1,47 @@
+// tests/nvml_standin/NvmlStandin.h - NVML 替身库的控制接口（测试通过 GetProcAddress 取得）
+#pragma once
+
+#ifdef _WIN32
+#define NVML_STANDIN_API __declspec(dllexport)
+#else
+#define NVML_STANDIN_API __attribute__((visibility("default")))
+#endif
+
+// =================================================================
+// 替身库按脚本文件返回数据，脚本按 "frame" 行分成若干帧：
+// 加载时执行第一帧，之后每次 nvmlStandinAdvance 执行下一帧
+// 未调用 nvmlStandinLoad 时，nvmlInit_v2 读取环境变量 NVML_STANDIN_SCRIPT 指定的脚本
+//
+// 脚本指令（每行一条，# 之后为注释，D 为设备下标，数值可用 0x 前缀）：
+//   devices N                      设备数（重新初始化后生效，最多 16 个）
+//   latency_us N                   每次 NVML 调用额外延迟
+//   busid D 00000000:41:00.0       PCI 总线号，默认 00000000:0X:00.0（X = D + 1）
+//   uuid D GPU-xxxx
+//   temp D 65                      核心温度
+//   reasons D 0x20                 时钟事件原因位掩码
+//   field D 186 150000             nvmlDeviceGetFieldValues 的字段值，值为 - 时表示不支持
+//   violation D POLICY REF_US NS   违规计数器，nvmlDeviceGetViolationStatus 和 NVML_FI_DEV_PERF_POLICY_* 字段共用
+//   policy_fields D 0|1            是否支持 NVML_FI_DEV_PERF_POLICY_* 字段（默认支持，0 模拟旧驱动）
+//   memory D TOTAL USED RESERVED   字节
+//   bar1 D TOTAL USED
+//   util D 42                      追加一个利用率采样（四种采样类型相同）
+//   process D PID BYTES            追加一个计算进程，BYTES 为 -1 表示不可用（NVML_VALUE_NOT_AVAILABLE）
+//   graphics_process D PID BYTES   追加一个图形进程；clear_processes D 清空两个列表
+//   lost D / restore D             设备掉卡 / 恢复，掉卡期间该设备的调用返回 GPU_IS_LOST
+//   xid D CODE                     产生一个 Xid 严重错误事件
+//   fail FUNCTION CODE [COUNT]     该函数返回错误码，COUNT 次后恢复（省略表示一直失败，CODE 为 0 时清除）
+//   hang FUNCTION MS [COUNT]       该函数阻塞 MS 毫秒后再返回（MS 为 0 时清除）
+//   frame                          帧分隔
+// =================================================================
+extern "C"
+{
+    // 加载脚本并执行第一帧，同时清空设备状态和调用计数；成功返回 1
+    NVML_STANDIN_API int nvmlStandinLoad(const char* path);
+
+    // 执行下一帧，没有更多帧时返回 0
+    NVML_STANDIN_API int nvmlStandinAdvance();
+
+    // 指定 NVML 函数被调用的次数（包括失败和阻塞的调用）
+    NVML_STANDIN_API unsigned int nvmlStandinGetCallCount(const char* function);
+    NVML_STANDIN_API void nvmlStandinResetCallCounts();
+}